@@ -11,10 +11,12 @@
 #include "codec.h"
 #include "tags.h"
 #include "types.h"
+#include "utf8.h"
 #include <main/php_ini.h>
 #include <ext/json/php_json.h>
 #include <ext/standard/info.h>
 #include <Zend/zend_exceptions.h>
+#include <Zend/zend_interfaces.h>
 
 #define PHP_CBOR_VERSION "0.4.10-dev"
 
@@ -35,7 +37,13 @@ zend_class_entry
 	*CBOR_CE(float32),
 	*CBOR_CE(tag),
 	*CBOR_CE(shareable),
-	*CBOR_CE(decoder)
+	*CBOR_CE(decoder),
+	*CBOR_CE(encoder),
+	*CBOR_CE(sequencereader),
+	*CBOR_CE(lazyvalue),
+	*CBOR_CE(index),
+	*CBOR_CE(reader),
+	*CBOR_CE(writer)
 	/* ce end */
 ;
 
@@ -81,6 +89,7 @@ PHP_MINIT_FUNCTION(cbor)
 	REG_CONST_LONG(CBOR_ERROR_RECURSION);
 	REG_CONST_LONG(CBOR_ERROR_SYNTAX);
 	REG_CONST_LONG(CBOR_ERROR_UTF8);
+	REG_CONST_LONG(CBOR_ERROR_IO);
 	REG_CONST_LONG(CBOR_ERROR_UNSUPPORTED_TYPE);
 	REG_CONST_LONG(CBOR_ERROR_UNSUPPORTED_VALUE);
 	REG_CONST_LONG(CBOR_ERROR_UNSUPPORTED_SIZE);
@@ -112,6 +121,12 @@ PHP_MINIT_FUNCTION(cbor)
 	REG_CLASS(tag, Tag)();
 	REG_CLASS(shareable, Shareable)(php_json_serializable_ce);
 	REG_CLASS(decoder, Decoder)();
+	REG_CLASS(encoder, Encoder)();
+	REG_CLASS(sequencereader, SequenceReader)(zend_ce_iterator);
+	REG_CLASS(lazyvalue, LazyValue)(zend_ce_arrayaccess, zend_ce_aggregate, zend_ce_countable, php_json_serializable_ce);
+	REG_CLASS(index, Index)();
+	REG_CLASS(reader, Reader)();
+	REG_CLASS(writer, Writer)();
 	/* reg_class end */
 
 #define REG_CLASS_CONST_LONG(cls, prefix, name)  zend_declare_class_constant_long(CBOR_CE(cls), ZEND_STRL(#name), prefix##name);
@@ -137,7 +152,24 @@ PHP_MINIT_FUNCTION(cbor)
 	REG_CLASS_CONST_LONG(tag, CBOR_TAG_, PCRE_REGEX);
 	REG_CLASS_CONST_LONG(tag, CBOR_TAG_, MIME_MSG);
 	/* tag constants end */
+	/* reader constants start */
+	REG_CLASS_CONST_LONG(reader, CBOR_TOKEN_, NONE);
+	REG_CLASS_CONST_LONG(reader, CBOR_TOKEN_, INT);
+	REG_CLASS_CONST_LONG(reader, CBOR_TOKEN_, BYTE);
+	REG_CLASS_CONST_LONG(reader, CBOR_TOKEN_, TEXT);
+	REG_CLASS_CONST_LONG(reader, CBOR_TOKEN_, ARRAY);
+	REG_CLASS_CONST_LONG(reader, CBOR_TOKEN_, MAP);
+	REG_CLASS_CONST_LONG(reader, CBOR_TOKEN_, TAG);
+	REG_CLASS_CONST_LONG(reader, CBOR_TOKEN_, FLOAT);
+	REG_CLASS_CONST_LONG(reader, CBOR_TOKEN_, FALSE);
+	REG_CLASS_CONST_LONG(reader, CBOR_TOKEN_, TRUE);
+	REG_CLASS_CONST_LONG(reader, CBOR_TOKEN_, NULL);
+	REG_CLASS_CONST_LONG(reader, CBOR_TOKEN_, UNDEFINED);
+	REG_CLASS_CONST_LONG(reader, CBOR_TOKEN_, SIMPLE);
+	REG_CLASS_CONST_LONG(reader, CBOR_TOKEN_, END);
+	/* reader constants end */
 
+	cbor_minit_utf8();
 	cbor_minit_types();
 	cbor_minit_encode();
 	cbor_minit_decode();
@@ -15,6 +15,27 @@
  */
 function cbor_encode(mixed $value, int $flags = CBOR_BYTE | CBOR_KEY_BYTE, ?array $options = null): string {}
 
+/*//
+ * Encode values to CBOR sequence, i.e. data items concatenated.
+ * @param iterable $values Values to encode
+ * @param int $flags Configuration flags
+ * @param array|null $options configuration options
+ * @return string CBOR sequence string
+ * @throws Cbor\Exception
+ */
+function cbor_encode_sequence(iterable $values, int $flags = CBOR_BYTE | CBOR_KEY_BYTE, ?array $options = null): string {}
+
+/*//
+ * Encode value to CBOR and write it to a stream.
+ * @param resource $stream A stream to write to
+ * @param mixed $value A value to encode
+ * @param int $flags Configuration flags
+ * @param array|null $options configuration options
+ * @return int The number of bytes written
+ * @throws Cbor\Exception
+ */
+function cbor_encode_to_stream($stream, mixed $value, int $flags = CBOR_BYTE | CBOR_KEY_BYTE, ?array $options = null): int {}
+
 /*//
  * Decode CBOR data item string.
  * @param string $data A data item string to decode
@@ -24,3 +45,54 @@ function cbor_encode(mixed $value, int $flags = CBOR_BYTE | CBOR_KEY_BYTE, ?arra
  * @throws Cbor\Exception
  */
 function cbor_decode(string $data, int $flags = CBOR_BYTE | CBOR_KEY_BYTE, ?array $options = null): mixed {}
+
+/*//
+ * Check CBOR data item string without decoding it.
+ * @param string $data A data item string to check
+ * @param int $flags Configuration flags
+ * @param array|null $options Configuration options
+ * @return int|false The length of the data item, or false if the data is invalid
+ * @throws Cbor\Exception
+ */
+function cbor_validate(string $data, int $flags = CBOR_BYTE | CBOR_KEY_BYTE, ?array $options = null): int|false {}
+
+/*//
+ * Decode the data item at the path of CBOR data item string.
+ * @param string $data A data item string to decode
+ * @param array $path Keys of maps or indices of arrays to reach the item
+ * @param int $flags Configuration flags
+ * @param array|null $options Configuration options
+ * @return mixed The decoded value, or null if the path is not found
+ * @throws Cbor\Exception
+ */
+function cbor_extract(string $data, array $path, int $flags = CBOR_BYTE | CBOR_KEY_BYTE, ?array $options = null): mixed {}
+
+/*//
+ * Index the containers of CBOR data item string for random access.
+ * @param string $data A data item string to index
+ * @param int $flags Configuration flags
+ * @param array|null $options Configuration options
+ * @return Cbor\Index The index
+ * @throws Cbor\Exception
+ */
+function cbor_index(string $data, int $flags = CBOR_BYTE | CBOR_KEY_BYTE, ?array $options = null): Cbor\Index {}
+
+/*//
+ * Convert CBOR data item string to JSON text without decoding it.
+ * @param string $data A data item string to convert
+ * @param int $flags Configuration flags
+ * @param array|null $options Configuration options
+ * @return string The JSON text
+ * @throws Cbor\Exception
+ */
+function cbor_to_json(string $data, int $flags = CBOR_BYTE | CBOR_KEY_BYTE, ?array $options = null): string {}
+
+/*//
+ * Convert JSON text to CBOR data item string without decoding it.
+ * @param string $json JSON text to convert
+ * @param int $flags Configuration flags
+ * @param array|null $options Configuration options
+ * @return string CBOR string
+ * @throws Cbor\Exception
+ */
+function cbor_from_json(string $json, int $flags = CBOR_BYTE | CBOR_KEY_BYTE, ?array $options = null): string {}
@@ -272,3 +272,349 @@ class Decoder
      */
     public function getBuffer(): string {}
 }
+
+/**
+ * CBOR Encoder
+ * @not-serializable
+ */
+class Encoder
+{
+    /*//
+     * Create CBOR encoder instance.
+     * @see cbor_encode()
+     * @param int $flags Configuration flags
+     * @param array|null $options Configuration options
+     */
+    public function __construct(int $flags = CBOR_BYTE | CBOR_KEY_BYTE, ?array $options = null) {}
+
+    /*//
+     * Encode value to CBOR string.
+     * @param mixed $value A value to encode
+     * @return string CBOR string
+     * @throws Cbor\Exception
+     */
+    public function encode(mixed $value): string {}
+
+    /*//
+     * Encode value to CBOR and write it to a stream.
+     * @param resource $stream A stream to write to
+     * @param mixed $value A value to encode
+     * @return int The number of bytes written
+     * @throws Cbor\Exception
+     */
+    public function encodeToStream($stream, mixed $value): int {}
+}
+
+/**
+ * CBOR sequence reader
+ * @not-serializable
+ */
+final class SequenceReader implements \Iterator
+{
+    /*//
+     * Create CBOR sequence reader instance.
+     * @see cbor_decode()
+     * @param string $data A CBOR sequence string to read
+     * @param int $flags Configuration flags
+     * @param array|null $options Configuration options
+     */
+    public function __construct(string $data, int $flags = CBOR_BYTE | CBOR_KEY_BYTE, ?array $options = null) {}
+
+    /*//
+     * Create CBOR sequence reader instance reading from a file.
+     *
+     * The file is mapped to memory if possible.
+     * @param string $filename A file name to read
+     * @param int $flags Configuration flags
+     * @param array|null $options Configuration options
+     * @return SequenceReader
+     * @throws Cbor\Exception
+     */
+    public static function fromFile(string $filename, int $flags = CBOR_BYTE | CBOR_KEY_BYTE, ?array $options = null): SequenceReader {}
+
+    /*//
+     * Get the current decoded data item.
+     * @return mixed The decoded value
+     */
+    public function current(): mixed {}
+
+    /*//
+     * Get the offset of the current data item.
+     * @return int The offset
+     */
+    public function key(): int {}
+
+    /*//
+     * Decode the next data item.
+     * @return void
+     * @throws Cbor\Exception
+     */
+    public function next(): void {}
+
+    /*//
+     * Decode the first data item.
+     * @return void
+     * @throws Cbor\Exception
+     */
+    public function rewind(): void {}
+
+    /*//
+     * Check if the current data item is available.
+     * @return bool True if the item is decoded
+     */
+    public function valid(): bool {}
+}
+
+/**
+ * Container decoded on the first access
+ * @not-serializable
+ */
+final class LazyValue implements \ArrayAccess, \IteratorAggregate, \Countable, \JsonSerializable
+{
+    private function __construct() {}
+
+    /*//
+     * Get the decoded array or object.
+     * @return array|object The decoded value
+     * @throws Cbor\Exception
+     */
+    public function getValue(): array|object {}
+
+    public function offsetExists(mixed $offset): bool {}
+    public function offsetGet(mixed $offset): mixed {}
+    public function offsetSet(mixed $offset, mixed $value): void {}
+    public function offsetUnset(mixed $offset): void {}
+    public function getIterator(): \Iterator {}
+    public function count(): int {}
+    public function jsonSerialize(): mixed {}
+}
+
+/**
+ * Index of the containers of CBOR data item
+ * @not-serializable
+ */
+final class Index
+{
+    private function __construct() {}
+
+    /*//
+     * Decode the data item at the path.
+     * @param string $data The data item string the index is created from
+     * @param string|int ...$path Keys of maps or indices of arrays to reach the item
+     * @return mixed The decoded value, or null if the path is not found
+     * @throws Cbor\Exception
+     */
+    public function get(string $data, string|int ...$path): mixed {}
+
+    /*//
+     * Get the range of the data item at the path.
+     * @param string $data The data item string the index is created from
+     * @param string|int ...$path Keys of maps or indices of arrays to reach the item
+     * @return array|null The offset and the length, or null if the path is not found
+     * @throws Cbor\Exception
+     */
+    public function locate(string $data, string|int ...$path): ?array {}
+}
+
+/**
+ * CBOR token reader
+ * @not-serializable
+ */
+final class Reader
+{
+    /* reader constants start */
+    //public const NONE = 0;
+    //public const INT = 1;
+    //public const BYTE = 2;
+    //public const TEXT = 3;
+    //public const ARRAY = 4;
+    //public const MAP = 5;
+    //public const TAG = 6;
+    //public const FLOAT = 7;
+    //public const FALSE = 8;
+    //public const TRUE = 9;
+    //public const NULL = 10;
+    //public const UNDEFINED = 11;
+    //public const SIMPLE = 12;
+    //public const END = 13;
+    /* reader constants end */
+
+    /*//
+     * Create CBOR token reader instance.
+     * @see cbor_decode()
+     * @param string $data A CBOR data item or sequence string to read
+     * @param int $flags Configuration flags
+     * @param array|null $options Configuration options
+     */
+    public function __construct(string $data, int $flags = CBOR_BYTE | CBOR_KEY_BYTE, ?array $options = null) {}
+
+    /*//
+     * Create CBOR token reader instance reading from a file.
+     *
+     * The file is mapped to memory if possible; otherwise it is read through a buffer holding the current token.
+     * @param string $filename A file name to read
+     * @param int $flags Configuration flags
+     * @param array|null $options Configuration options
+     * @return Reader
+     * @throws Cbor\Exception
+     */
+    public static function fromFile(string $filename, int $flags = CBOR_BYTE | CBOR_KEY_BYTE, ?array $options = null): Reader {}
+
+    /*//
+     * Read the next token.
+     * @return int The token type, or Reader::NONE at the end of data
+     * @throws Cbor\Exception
+     */
+    public function next(): int {}
+
+    /*//
+     * Get the nesting level of the current token.
+     * @return int The depth, 0 for the top level
+     */
+    public function depth(): int {}
+
+    /*//
+     * Get the offset of the current token.
+     * @return int The offset
+     */
+    public function offset(): int {}
+
+    /*//
+     * Get the length of the current string, array or map.
+     * @return int|null The length in bytes, or the number of elements or pairs; null if indefinite
+     */
+    public function length(): ?int {}
+
+    /*//
+     * Get the value of the current integer, the number of the current tag, or the current simple value.
+     * @return int The value
+     * @throws Cbor\Exception
+     */
+    public function intValue(): int {}
+
+    /*//
+     * Get the value of the current float.
+     * @return float The value
+     */
+    public function floatValue(): float {}
+
+    /*//
+     * Get the current byte or text string.
+     * @return string The string
+     * @throws Cbor\Exception
+     */
+    public function stringValue(): string {}
+
+    /*//
+     * Skip the elements of the current array or map, or the content of the current tag.
+     * @return void
+     * @throws Cbor\Exception
+     */
+    public function skip(): void {}
+
+    /*//
+     * Decode the data item of the current token as a whole.
+     * @return mixed The decoded value
+     * @throws Cbor\Exception
+     */
+    public function decode(): mixed {}
+}
+
+/**
+ * CBOR token writer
+ * @not-serializable
+ */
+final class Writer
+{
+    /*//
+     * Create CBOR token writer instance.
+     * @see cbor_encode()
+     * @param int $flags Configuration flags
+     * @param array|null $options Configuration options
+     * @param resource|null $stream A stream to write completed data items to
+     * @throws Cbor\Exception
+     */
+    public function __construct(int $flags = CBOR_BYTE | CBOR_KEY_BYTE, ?array $options = null, $stream = null) {}
+
+    /*//
+     * Start an array.
+     * @param int|null $count The number of elements, or null for indefinite-length
+     * @return void
+     * @throws Cbor\Exception
+     */
+    public function startArray(?int $count = null): void {}
+
+    /*//
+     * Start a map. Keys and values are written alternately.
+     * @param int|null $count The number of pairs, or null for indefinite-length
+     * @return void
+     * @throws Cbor\Exception
+     */
+    public function startMap(?int $count = null): void {}
+
+    /*//
+     * End the current array or map.
+     * @return void
+     * @throws Cbor\Exception
+     */
+    public function end(): void {}
+
+    /*//
+     * Write an integer.
+     * @param int $value The value
+     * @return void
+     * @throws Cbor\Exception
+     */
+    public function int(int $value): void {}
+
+    /*//
+     * Write a float.
+     * @param float $value The value
+     * @return void
+     * @throws Cbor\Exception
+     */
+    public function float(float $value): void {}
+
+    /*//
+     * Write a text string.
+     * @param string $value The value
+     * @return void
+     * @throws Cbor\Exception
+     */
+    public function text(string $value): void {}
+
+    /*//
+     * Write a byte string.
+     * @param string $value The value
+     * @return void
+     * @throws Cbor\Exception
+     */
+    public function bytes(string $value): void {}
+
+    /*//
+     * Write a tag. The next item is the content of the tag.
+     * @param int $tag The tag number
+     * @return void
+     * @throws Cbor\Exception
+     */
+    public function tag(int $tag): void {}
+
+    /*//
+     * Encode a value as a data item.
+     * @see cbor_encode()
+     * @param mixed $value The value
+     * @return void
+     * @throws Cbor\Exception
+     */
+    public function value(mixed $value): void {}
+
+    /*//
+     * Get the data written so far.
+     *
+     * The data is empty if the stream is specified.
+     * Error is thrown while a container or a tag is not complete.
+     * @param bool $clear Clear the buffer
+     * @return string The data
+     */
+    public function getData(bool $clear = true): string {}
+}
@@ -1,5 +1,5 @@
 /* This is a generated file, edit the .stub.php file instead.
- * Stub hash: 1deec7286b18b11504f2c0f5039a6594f0806aee */
+ * Stub hash: 71eb559e2ea81d0e41829121573eb4eca7e2f774 */
 
 ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_Serializable_cborSerialize, 0, 0, IS_MIXED, 0)
 ZEND_END_ARG_INFO()
@@ -104,6 +104,149 @@ ZEND_END_ARG_INFO()
 
 #define arginfo_class_Cbor_Decoder_getBuffer arginfo_class_Cbor_FloatX_toBinary
 
+#define arginfo_class_Cbor_Encoder___construct arginfo_class_Cbor_Decoder___construct
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_Encoder_encode, 0, 1, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, value, IS_MIXED, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_Encoder_encodeToStream, 0, 2, IS_LONG, 0)
+	ZEND_ARG_INFO(0, stream)
+	ZEND_ARG_TYPE_INFO(0, value, IS_MIXED, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Cbor_SequenceReader___construct, 0, 0, 1)
+	ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, flags, IS_LONG, 0, "CBOR_BYTE | CBOR_KEY_BYTE")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, options, IS_ARRAY, 1, "null")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_class_Cbor_SequenceReader_fromFile, 0, 1, Cbor\\SequenceReader, 0)
+	ZEND_ARG_TYPE_INFO(0, filename, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, flags, IS_LONG, 0, "CBOR_BYTE | CBOR_KEY_BYTE")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, options, IS_ARRAY, 1, "null")
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_Cbor_SequenceReader_current arginfo_class_Cbor_Serializable_cborSerialize
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_SequenceReader_key, 0, 0, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_Cbor_SequenceReader_next arginfo_class_Cbor_Decoder_reset
+
+#define arginfo_class_Cbor_SequenceReader_rewind arginfo_class_Cbor_Decoder_reset
+
+#define arginfo_class_Cbor_SequenceReader_valid arginfo_class_Cbor_Decoder_process
+
+#define arginfo_class_Cbor_LazyValue___construct arginfo_class_Cbor_Undefined___construct
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_MASK_EX(arginfo_class_Cbor_LazyValue_getValue, 0, 0, MAY_BE_ARRAY|MAY_BE_OBJECT)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_LazyValue_offsetExists, 0, 1, _IS_BOOL, 0)
+	ZEND_ARG_TYPE_INFO(0, offset, IS_MIXED, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_LazyValue_offsetGet, 0, 1, IS_MIXED, 0)
+	ZEND_ARG_TYPE_INFO(0, offset, IS_MIXED, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_LazyValue_offsetSet, 0, 2, IS_VOID, 0)
+	ZEND_ARG_TYPE_INFO(0, offset, IS_MIXED, 0)
+	ZEND_ARG_TYPE_INFO(0, value, IS_MIXED, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_LazyValue_offsetUnset, 0, 1, IS_VOID, 0)
+	ZEND_ARG_TYPE_INFO(0, offset, IS_MIXED, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_class_Cbor_LazyValue_getIterator, 0, 0, Iterator, 0)
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_Cbor_LazyValue_count arginfo_class_Cbor_SequenceReader_key
+
+#define arginfo_class_Cbor_LazyValue_jsonSerialize arginfo_class_Cbor_Serializable_cborSerialize
+
+#define arginfo_class_Cbor_Index___construct arginfo_class_Cbor_Undefined___construct
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_Index_get, 0, 1, IS_MIXED, 0)
+	ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
+	ZEND_ARG_VARIADIC_TYPE_MASK(0, path, MAY_BE_STRING|MAY_BE_LONG, NULL)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_Index_locate, 0, 1, IS_ARRAY, 1)
+	ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
+	ZEND_ARG_VARIADIC_TYPE_MASK(0, path, MAY_BE_STRING|MAY_BE_LONG, NULL)
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_Cbor_Reader___construct arginfo_class_Cbor_SequenceReader___construct
+
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_class_Cbor_Reader_fromFile, 0, 1, Cbor\\Reader, 0)
+	ZEND_ARG_TYPE_INFO(0, filename, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, flags, IS_LONG, 0, "CBOR_BYTE | CBOR_KEY_BYTE")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, options, IS_ARRAY, 1, "null")
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_Cbor_Reader_next arginfo_class_Cbor_SequenceReader_key
+
+#define arginfo_class_Cbor_Reader_depth arginfo_class_Cbor_SequenceReader_key
+
+#define arginfo_class_Cbor_Reader_offset arginfo_class_Cbor_SequenceReader_key
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_Reader_length, 0, 0, IS_LONG, 1)
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_Cbor_Reader_intValue arginfo_class_Cbor_SequenceReader_key
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_Reader_floatValue, 0, 0, IS_DOUBLE, 0)
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_Cbor_Reader_stringValue arginfo_class_Cbor_FloatX_toBinary
+
+#define arginfo_class_Cbor_Reader_skip arginfo_class_Cbor_Decoder_reset
+
+#define arginfo_class_Cbor_Reader_decode arginfo_class_Cbor_Serializable_cborSerialize
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Cbor_Writer___construct, 0, 0, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, flags, IS_LONG, 0, "CBOR_BYTE | CBOR_KEY_BYTE")
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, options, IS_ARRAY, 1, "null")
+	ZEND_ARG_INFO_WITH_DEFAULT_VALUE(0, stream, "null")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_Writer_startArray, 0, 0, IS_VOID, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, count, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_Cbor_Writer_startMap arginfo_class_Cbor_Writer_startArray
+
+#define arginfo_class_Cbor_Writer_end arginfo_class_Cbor_Decoder_reset
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_Writer_int, 0, 1, IS_VOID, 0)
+	ZEND_ARG_TYPE_INFO(0, value, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_Writer_float, 0, 1, IS_VOID, 0)
+	ZEND_ARG_TYPE_INFO(0, value, IS_DOUBLE, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_Writer_text, 0, 1, IS_VOID, 0)
+	ZEND_ARG_TYPE_INFO(0, value, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_Cbor_Writer_bytes arginfo_class_Cbor_Writer_text
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_Writer_tag, 0, 1, IS_VOID, 0)
+	ZEND_ARG_TYPE_INFO(0, tag, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_Writer_value, 0, 1, IS_VOID, 0)
+	ZEND_ARG_TYPE_INFO(0, value, IS_MIXED, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_class_Cbor_Writer_getData, 0, 0, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, clear, _IS_BOOL, 0, "true")
+ZEND_END_ARG_INFO()
+
 
 ZEND_METHOD(Cbor_EncodeParams, __construct);
 ZEND_METHOD(Cbor_Undefined, __construct);
@@ -135,6 +278,50 @@ ZEND_METHOD(Cbor_Decoder, getValue);
 ZEND_METHOD(Cbor_Decoder, isPartial);
 ZEND_METHOD(Cbor_Decoder, isProcessing);
 ZEND_METHOD(Cbor_Decoder, getBuffer);
+ZEND_METHOD(Cbor_Encoder, __construct);
+ZEND_METHOD(Cbor_Encoder, encode);
+ZEND_METHOD(Cbor_Encoder, encodeToStream);
+ZEND_METHOD(Cbor_SequenceReader, __construct);
+ZEND_METHOD(Cbor_SequenceReader, fromFile);
+ZEND_METHOD(Cbor_SequenceReader, current);
+ZEND_METHOD(Cbor_SequenceReader, key);
+ZEND_METHOD(Cbor_SequenceReader, next);
+ZEND_METHOD(Cbor_SequenceReader, rewind);
+ZEND_METHOD(Cbor_SequenceReader, valid);
+ZEND_METHOD(Cbor_LazyValue, __construct);
+ZEND_METHOD(Cbor_LazyValue, getValue);
+ZEND_METHOD(Cbor_LazyValue, offsetExists);
+ZEND_METHOD(Cbor_LazyValue, offsetGet);
+ZEND_METHOD(Cbor_LazyValue, offsetSet);
+ZEND_METHOD(Cbor_LazyValue, offsetUnset);
+ZEND_METHOD(Cbor_LazyValue, getIterator);
+ZEND_METHOD(Cbor_LazyValue, count);
+ZEND_METHOD(Cbor_LazyValue, jsonSerialize);
+ZEND_METHOD(Cbor_Index, __construct);
+ZEND_METHOD(Cbor_Index, get);
+ZEND_METHOD(Cbor_Index, locate);
+ZEND_METHOD(Cbor_Reader, __construct);
+ZEND_METHOD(Cbor_Reader, fromFile);
+ZEND_METHOD(Cbor_Reader, next);
+ZEND_METHOD(Cbor_Reader, depth);
+ZEND_METHOD(Cbor_Reader, offset);
+ZEND_METHOD(Cbor_Reader, length);
+ZEND_METHOD(Cbor_Reader, intValue);
+ZEND_METHOD(Cbor_Reader, floatValue);
+ZEND_METHOD(Cbor_Reader, stringValue);
+ZEND_METHOD(Cbor_Reader, skip);
+ZEND_METHOD(Cbor_Reader, decode);
+ZEND_METHOD(Cbor_Writer, __construct);
+ZEND_METHOD(Cbor_Writer, startArray);
+ZEND_METHOD(Cbor_Writer, startMap);
+ZEND_METHOD(Cbor_Writer, end);
+ZEND_METHOD(Cbor_Writer, int);
+ZEND_METHOD(Cbor_Writer, float);
+ZEND_METHOD(Cbor_Writer, text);
+ZEND_METHOD(Cbor_Writer, bytes);
+ZEND_METHOD(Cbor_Writer, tag);
+ZEND_METHOD(Cbor_Writer, value);
+ZEND_METHOD(Cbor_Writer, getData);
 
 
 static const zend_function_entry class_Cbor_Exception_methods[] = {
@@ -232,6 +419,80 @@ static const zend_function_entry class_Cbor_Decoder_methods[] = {
 	ZEND_FE_END
 };
 
+
+static const zend_function_entry class_Cbor_Encoder_methods[] = {
+	ZEND_ME(Cbor_Encoder, __construct, arginfo_class_Cbor_Encoder___construct, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Encoder, encode, arginfo_class_Cbor_Encoder_encode, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Encoder, encodeToStream, arginfo_class_Cbor_Encoder_encodeToStream, ZEND_ACC_PUBLIC)
+	ZEND_FE_END
+};
+
+
+static const zend_function_entry class_Cbor_SequenceReader_methods[] = {
+	ZEND_ME(Cbor_SequenceReader, __construct, arginfo_class_Cbor_SequenceReader___construct, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_SequenceReader, fromFile, arginfo_class_Cbor_SequenceReader_fromFile, ZEND_ACC_PUBLIC|ZEND_ACC_STATIC)
+	ZEND_ME(Cbor_SequenceReader, current, arginfo_class_Cbor_SequenceReader_current, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_SequenceReader, key, arginfo_class_Cbor_SequenceReader_key, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_SequenceReader, next, arginfo_class_Cbor_SequenceReader_next, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_SequenceReader, rewind, arginfo_class_Cbor_SequenceReader_rewind, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_SequenceReader, valid, arginfo_class_Cbor_SequenceReader_valid, ZEND_ACC_PUBLIC)
+	ZEND_FE_END
+};
+
+
+static const zend_function_entry class_Cbor_LazyValue_methods[] = {
+	ZEND_ME(Cbor_LazyValue, __construct, arginfo_class_Cbor_LazyValue___construct, ZEND_ACC_PRIVATE)
+	ZEND_ME(Cbor_LazyValue, getValue, arginfo_class_Cbor_LazyValue_getValue, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_LazyValue, offsetExists, arginfo_class_Cbor_LazyValue_offsetExists, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_LazyValue, offsetGet, arginfo_class_Cbor_LazyValue_offsetGet, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_LazyValue, offsetSet, arginfo_class_Cbor_LazyValue_offsetSet, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_LazyValue, offsetUnset, arginfo_class_Cbor_LazyValue_offsetUnset, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_LazyValue, getIterator, arginfo_class_Cbor_LazyValue_getIterator, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_LazyValue, count, arginfo_class_Cbor_LazyValue_count, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_LazyValue, jsonSerialize, arginfo_class_Cbor_LazyValue_jsonSerialize, ZEND_ACC_PUBLIC)
+	ZEND_FE_END
+};
+
+
+static const zend_function_entry class_Cbor_Index_methods[] = {
+	ZEND_ME(Cbor_Index, __construct, arginfo_class_Cbor_Index___construct, ZEND_ACC_PRIVATE)
+	ZEND_ME(Cbor_Index, get, arginfo_class_Cbor_Index_get, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Index, locate, arginfo_class_Cbor_Index_locate, ZEND_ACC_PUBLIC)
+	ZEND_FE_END
+};
+
+
+static const zend_function_entry class_Cbor_Reader_methods[] = {
+	ZEND_ME(Cbor_Reader, __construct, arginfo_class_Cbor_Reader___construct, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Reader, fromFile, arginfo_class_Cbor_Reader_fromFile, ZEND_ACC_PUBLIC|ZEND_ACC_STATIC)
+	ZEND_ME(Cbor_Reader, next, arginfo_class_Cbor_Reader_next, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Reader, depth, arginfo_class_Cbor_Reader_depth, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Reader, offset, arginfo_class_Cbor_Reader_offset, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Reader, length, arginfo_class_Cbor_Reader_length, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Reader, intValue, arginfo_class_Cbor_Reader_intValue, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Reader, floatValue, arginfo_class_Cbor_Reader_floatValue, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Reader, stringValue, arginfo_class_Cbor_Reader_stringValue, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Reader, skip, arginfo_class_Cbor_Reader_skip, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Reader, decode, arginfo_class_Cbor_Reader_decode, ZEND_ACC_PUBLIC)
+	ZEND_FE_END
+};
+
+
+static const zend_function_entry class_Cbor_Writer_methods[] = {
+	ZEND_ME(Cbor_Writer, __construct, arginfo_class_Cbor_Writer___construct, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Writer, startArray, arginfo_class_Cbor_Writer_startArray, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Writer, startMap, arginfo_class_Cbor_Writer_startMap, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Writer, end, arginfo_class_Cbor_Writer_end, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Writer, int, arginfo_class_Cbor_Writer_int, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Writer, float, arginfo_class_Cbor_Writer_float, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Writer, text, arginfo_class_Cbor_Writer_text, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Writer, bytes, arginfo_class_Cbor_Writer_bytes, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Writer, tag, arginfo_class_Cbor_Writer_tag, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Writer, value, arginfo_class_Cbor_Writer_value, ZEND_ACC_PUBLIC)
+	ZEND_ME(Cbor_Writer, getData, arginfo_class_Cbor_Writer_getData, ZEND_ACC_PUBLIC)
+	ZEND_FE_END
+};
+
 static zend_class_entry *register_class_Cbor_Exception(zend_class_entry *class_entry_Exception)
 {
 	zend_class_entry ce, *class_entry;
@@ -406,3 +667,71 @@ static zend_class_entry *register_class_Cbor_Decoder(void)
 
 	return class_entry;
 }
+
+static zend_class_entry *register_class_Cbor_Encoder(void)
+{
+	zend_class_entry ce, *class_entry;
+
+	INIT_NS_CLASS_ENTRY(ce, "Cbor", "Encoder", class_Cbor_Encoder_methods);
+	class_entry = zend_register_internal_class_ex(&ce, NULL);
+	class_entry->ce_flags |= ZEND_ACC_NOT_SERIALIZABLE;
+
+	return class_entry;
+}
+
+static zend_class_entry *register_class_Cbor_SequenceReader(zend_class_entry *class_entry_Iterator)
+{
+	zend_class_entry ce, *class_entry;
+
+	INIT_NS_CLASS_ENTRY(ce, "Cbor", "SequenceReader", class_Cbor_SequenceReader_methods);
+	class_entry = zend_register_internal_class_ex(&ce, NULL);
+	class_entry->ce_flags |= ZEND_ACC_FINAL|ZEND_ACC_NOT_SERIALIZABLE;
+	zend_class_implements(class_entry, 1, class_entry_Iterator);
+
+	return class_entry;
+}
+
+static zend_class_entry *register_class_Cbor_LazyValue(zend_class_entry *class_entry_ArrayAccess, zend_class_entry *class_entry_IteratorAggregate, zend_class_entry *class_entry_Countable, zend_class_entry *class_entry_JsonSerializable)
+{
+	zend_class_entry ce, *class_entry;
+
+	INIT_NS_CLASS_ENTRY(ce, "Cbor", "LazyValue", class_Cbor_LazyValue_methods);
+	class_entry = zend_register_internal_class_ex(&ce, NULL);
+	class_entry->ce_flags |= ZEND_ACC_FINAL|ZEND_ACC_NOT_SERIALIZABLE;
+	zend_class_implements(class_entry, 4, class_entry_ArrayAccess, class_entry_IteratorAggregate, class_entry_Countable, class_entry_JsonSerializable);
+
+	return class_entry;
+}
+
+static zend_class_entry *register_class_Cbor_Index(void)
+{
+	zend_class_entry ce, *class_entry;
+
+	INIT_NS_CLASS_ENTRY(ce, "Cbor", "Index", class_Cbor_Index_methods);
+	class_entry = zend_register_internal_class_ex(&ce, NULL);
+	class_entry->ce_flags |= ZEND_ACC_FINAL|ZEND_ACC_NOT_SERIALIZABLE;
+
+	return class_entry;
+}
+
+static zend_class_entry *register_class_Cbor_Reader(void)
+{
+	zend_class_entry ce, *class_entry;
+
+	INIT_NS_CLASS_ENTRY(ce, "Cbor", "Reader", class_Cbor_Reader_methods);
+	class_entry = zend_register_internal_class_ex(&ce, NULL);
+	class_entry->ce_flags |= ZEND_ACC_FINAL|ZEND_ACC_NOT_SERIALIZABLE;
+
+	return class_entry;
+}
+
+static zend_class_entry *register_class_Cbor_Writer(void)
+{
+	zend_class_entry ce, *class_entry;
+
+	INIT_NS_CLASS_ENTRY(ce, "Cbor", "Writer", class_Cbor_Writer_methods);
+	class_entry = zend_register_internal_class_ex(&ce, NULL);
+	class_entry->ce_flags |= ZEND_ACC_FINAL|ZEND_ACC_NOT_SERIALIZABLE;
+
+	return class_entry;
+}
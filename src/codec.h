@@ -4,6 +4,7 @@
  */
 
 #include "flags.h"
+#include <Zend/zend_smart_str_public.h>
 
 #define SIZE_INIT_LIMIT  4096
 
@@ -15,6 +16,7 @@ typedef enum {
 	/* E     */ CBOR_ERROR_RECURSION,
 	/* E D   */ CBOR_ERROR_SYNTAX,
 	/* E D   */ CBOR_ERROR_UTF8,
+	/* E     */ CBOR_ERROR_IO,
 	/* E D   */ CBOR_ERROR_UNSUPPORTED_TYPE = 17,
 	/* E D   */ CBOR_ERROR_UNSUPPORTED_VALUE,
 	/* E D   */ CBOR_ERROR_UNSUPPORTED_SIZE,
@@ -72,10 +74,14 @@ typedef enum {
 	CBOR_ERROR_TAG_TYPE__STR_REF_NOT_INT = 1,
 	CBOR_ERROR_TAG_TYPE__SHARE_INCOMPATIBLE,
 	CBOR_ERROR_TAG_TYPE__SHARE_NOT_INT,
+	CBOR_ERROR_TAG_TYPE__DATETIME_NOT_TEXT,
+	CBOR_ERROR_TAG_TYPE__EPOCH_NOT_NUM,
 
 	CBOR_ERROR_TAG_VALUE__STR_REF_RANGE = 1,
 	CBOR_ERROR_TAG_VALUE__SHARE_SELF,
 	CBOR_ERROR_TAG_VALUE__SHARE_RANGE,
+	CBOR_ERROR_TAG_VALUE__DATETIME_SYNTAX,
+	CBOR_ERROR_TAG_VALUE__EPOCH_RANGE,
 } cbor_error;
 
 #define E_DESC(e, d)  ((e) | (e##__##d << CBOR_ERROR_DESC_SHIFT))
@@ -88,10 +94,34 @@ enum {
 	/* string ref */
 	OPT_EXPLICIT = 2,
 
+	/* string cache */
+	OPT_ALL = 2,
+
 	/* shared ref */
 	OPT_SHAREABLE = 2,
 	OPT_SHAREABLE_ONLY = 3,
 	OPT_UNSAFE_REF = 4,
+
+	/* datetime */
+	OPT_EPOCH = 2,
+};
+
+/* tokens of the reader */
+enum {
+	CBOR_TOKEN_NONE = 0,  /* end of data */
+	CBOR_TOKEN_INT,
+	CBOR_TOKEN_BYTE,
+	CBOR_TOKEN_TEXT,
+	CBOR_TOKEN_ARRAY,
+	CBOR_TOKEN_MAP,
+	CBOR_TOKEN_TAG,
+	CBOR_TOKEN_FLOAT,
+	CBOR_TOKEN_FALSE,
+	CBOR_TOKEN_TRUE,
+	CBOR_TOKEN_NULL,
+	CBOR_TOKEN_UNDEFINED,
+	CBOR_TOKEN_SIMPLE,
+	CBOR_TOKEN_END,  /* end of array or map */
 };
 
 typedef struct {
@@ -108,7 +138,7 @@ typedef struct {
 	cbor_error_args error_args;
 	uint8_t string_ref;
 	uint8_t shared_ref;
-	bool datetime;
+	uint8_t datetime;
 	bool bignum;
 	bool decimal;
 	bool uri;
@@ -123,6 +153,9 @@ typedef struct {
 	cbor_error_args error_args;
 	bool string_ref;
 	uint8_t shared_ref;
+	uint8_t string_cache;
+	bool datetime;
+	uint32_t lazy;
 	struct {
 		uint8_t indent;
 		char indent_char;
@@ -140,6 +173,46 @@ typedef struct {
 	const uint8_t *ptr;
 } cbor_fragment;
 
+typedef struct {
+	size_t offset;  /* of the head */
+	size_t end;  /* of the last element, before the break of indefinite-length */
+	size_t first;  /* index of the first element in offsets */
+	size_t count;  /* number of elements; keys and values for map */
+	bool is_map;
+} cbor_index_node;
+
+typedef struct {
+	size_t root;  /* offset of the root item */
+	size_t end;
+	cbor_index_node *nodes;  /* in the order of the offset */
+	size_t *offsets;  /* of the elements of the containers */
+	size_t node_count, node_size;
+	size_t offset_count, offset_size;
+} cbor_index_table;
+
+typedef struct {
+	uint64_t remaining;  /* items left in the definite-length container */
+	bool is_indef;
+	bool is_map;
+	bool has_key;  /* key of indefinite-length map is read without the value */
+} cbor_reader_frame;
+
+typedef struct {
+	cbor_reader_frame *stack;  /* open containers */
+	uint32_t depth, stack_size;
+	uint32_t token_depth;
+	uint8_t token;  /* CBOR_TOKEN_* */
+	uint8_t type;  /* DI_* of the head */
+	bool is_indef;
+	bool in_tag;  /* content of the tag follows */
+	bool is_left;  /* container or tagged item is read as a whole */
+	size_t offset;  /* of the head */
+	size_t content;  /* offset past the head */
+	uint64_t arg;
+	uint64_t length;  /* of the string */
+} cbor_reader_state;
+
+typedef struct cbor_encode_context cbor_encode_context;
 typedef struct cbor_decode_context cbor_decode_context;
 
 void cbor_minit_encode();
@@ -157,12 +230,36 @@ void cbor_throw_error(cbor_error error, bool decoding, const cbor_error_args *ar
 
 /* encode */
 cbor_error cbor_encode(zval *value, zend_string **data, cbor_encode_args *args);
+cbor_encode_context *cbor_encode_new(const cbor_encode_args *args);
+void cbor_encode_delete(cbor_encode_context *ctx);
+cbor_error cbor_encode_process(cbor_encode_context *ctx, zval *value, smart_str *buf, cbor_encode_args *args);
+cbor_error cbor_encode_sequence(zval *values, zend_string **data, cbor_encode_args *args);
+cbor_error cbor_encode_to_stream(zval *value, php_stream *stream, size_t *written, cbor_encode_args *args);
+cbor_error cbor_encode_process_stream(cbor_encode_context *ctx, zval *value, smart_str *buf, php_stream *stream, size_t *written, cbor_encode_args *args);
+cbor_error cbor_from_json(zend_string *json, zend_string **data, cbor_encode_args *args);
 
 /* decode */
+cbor_error cbor_init_fragment(cbor_fragment *mem, zend_string *data, cbor_decode_args *args);
 cbor_error cbor_decode(zend_string *data, zval *value, cbor_decode_args *args);
 cbor_decode_context *cbor_decode_new(const cbor_decode_args *args, cbor_fragment *mem);
 void cbor_decode_delete(cbor_decode_context *ctx);
 cbor_error cbor_decode_process(cbor_decode_context *ctx);
 cbor_error cbor_decode_finish(cbor_decode_context *ctx, cbor_decode_args *args, cbor_error error, zval *value);
+cbor_error cbor_validate(zend_string *data, size_t *length, cbor_decode_args *args);
+cbor_error cbor_to_json(zend_string *data, zval *value, cbor_decode_args *args);
+cbor_error cbor_extract(zend_string *data, HashTable *path, zval *value, cbor_decode_args *args);
+cbor_error cbor_skip_item(cbor_fragment *mem, uint32_t max_depth);
+cbor_error cbor_index(zend_string *data, cbor_index_table *table, cbor_decode_args *args);
+cbor_error cbor_index_find(const cbor_index_table *table, cbor_fragment *mem, zval *path, uint32_t path_count, const cbor_decode_args *args, bool *found);
+void cbor_index_free(cbor_index_table *table);
+cbor_error cbor_index_new(zval *value, zend_string *data, cbor_decode_args *args);
+cbor_error cbor_decode_item(zend_string *data, size_t offset, size_t length, zval *value, cbor_decode_args *args);
+void cbor_lazy_value_init(zval *value, zend_string *data, size_t offset, size_t length, uint32_t count, const cbor_decode_args *args);
+zval *cbor_lazy_value_get(zval *value);
+cbor_error cbor_reader_next(cbor_reader_state *state, cbor_fragment *mem, uint32_t max_depth);
+cbor_error cbor_reader_skip(cbor_reader_state *state, cbor_fragment *mem, uint32_t max_depth);
+void cbor_reader_leave(cbor_reader_state *state);
+zend_string *cbor_reader_string(const cbor_reader_state *state, const cbor_fragment *mem);
+void cbor_reader_free(cbor_reader_state *state);
 
 bool cbor_is_len_string_ref(size_t str_len, uint32_t next_index);
@@ -5,6 +5,7 @@
 
 #define TARGET_PHP_API_LT_81  (PHP_API_VERSION < 20210902)  /* <PHP8.1 */
 #define TARGET_PHP_API_LT_82  (PHP_API_VERSION < 20220829)  /* <PHP8.2 */
+#define TARGET_PHP_API_LT_83  (PHP_API_VERSION < 20230831)  /* <PHP8.3 */
 /* Since it is a matter of the interface, PHP_VERSION_ID is not preferred */
 
 #if TARGET_PHP_API_LT_82
@@ -21,3 +22,15 @@ bool zend_array_is_list(zend_array *array);
 #define ZEND_DOUBLE_MAX_LENGTH  PHP_DOUBLE_MAX_LENGTH
 #define zend_gcvt  php_gcvt
 #endif
+
+#if TARGET_PHP_API_LT_83
+#define ZSTR_IS_VALID_UTF8(s)  false
+#define ZSTR_SET_VALID_UTF8(s)  ((void)0)
+#else
+/* interned strings may live in read-only shared memory */
+#define ZSTR_SET_VALID_UTF8(s)  do { \
+		if (!ZSTR_IS_INTERNED(s)) { \
+			GC_ADD_FLAGS(s, IS_STR_VALID_UTF8); \
+		} \
+	} while (0)
+#endif
@@ -7,10 +7,11 @@
 
 #if defined(__GNUC__) || defined(__clang__)
 #include <cpuid.h>
-#define GET_CPU_ID(fn, out) __cpuid(fn, out[0], out[1], out[2], out[3]);
+#define GET_CPU_ID(fn, out) __cpuid_count(fn, 0, out[0], out[1], out[2], out[3]);
 #else
 #include <intrin.h>
-#define GET_CPU_ID(fn, out) __cpuid(out, fn);
+#include <immintrin.h>
+#define GET_CPU_ID(fn, out) __cpuidex(out, fn, 0);
 #endif
 
 bool get_cpu_id(int fn_id, int cpu_id[4])
@@ -28,3 +29,15 @@ bool get_cpu_id(int fn_id, int cpu_id[4])
 	GET_CPU_ID(fn_id, cpu_id);
 	return true;
 }
+
+/* Call only if OSXSAVE is set. */
+unsigned long long get_xcr0()
+{
+#if defined(__GNUC__) || defined(__clang__)
+	unsigned int eax, edx;
+	__asm__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((unsigned long long)edx << 32) | eax;
+#else
+	return _xgetbv(0);
+#endif
+}
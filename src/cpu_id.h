@@ -12,7 +12,14 @@
 enum {
 	// cf. Intel Architecture Instruction Set Extensions Programming Reference ver.48 1-31
 	CPU_ID_1_2_SSE3 = 1 << 0,
+	CPU_ID_1_2_OSXSAVE = 1 << 27,
 	CPU_ID_1_2_F16C = 1 << 29,
+	CPU_ID_7_1_AVX2 = 1 << 5,
+};
+
+enum {
+	XCR0_YMM_STATE = (1 << 1) | (1 << 2),  /* XMM and YMM states are enabled by OS */
 };
 
 bool get_cpu_id(int fn_id, int cpu_id[4]);
+unsigned long long get_xcr0();
@@ -6,12 +6,17 @@
 #include "cbor.h"
 #include "di_decoder.h"
 #include "codec.h"
+#include "compatibility.h"
 #include "tags.h"
 #include "types.h"
 #include "utf8.h"
 #include "xzval.h"
+#include "warn_muted.h"
+#include <ext/date/php_date.h>
+#include "warn_unmuted.h"
 #include <Zend/zend_smart_str.h>
 #include <assert.h>
+#include <math.h>
 
 #define _CB_SET_ERROR(error)  do { \
 		assert(error); \
@@ -35,36 +40,62 @@
 #define ASSERT_ERROR_SET()  assert(ctx->cb_error)
 #define ASSERT_STACK_ITEM_IS_TOP(item)  assert(ctx->stack_top == (stack_item *)item)
 
+#define STR_CACHE_SIZE  256  /* must be a power of 2 */
+#define STR_CACHE_MAX_LEN  64
+
 typedef struct stack_item stack_item;
 typedef struct srns_item srns_item;
 typedef struct decode_vt decode_vt;
 
+typedef struct {
+	const char *val;  /* points into the data being validated */
+	size_t len;
+	bool is_xstring;
+	bool is_text;
+} vd_str_entry;
+
 typedef struct cbor_decode_context {
 	cbor_decode_args args;
 	cbor_error cb_error;
 	bool skip_self_desc;
 	cbor_fragment *mem;
-	stack_item *stack_top, *stack_pool;
-	uint32_t stack_depth;
+	zend_string *data;  /* string mem points to, which lazy values refer to */
+	stack_item *stack_top;
+	char *stack_base;  /* stack items indexed by depth */
+	uint32_t stack_depth, stack_size;
 	const decode_vt *vt;
 	union dec_ctx_vt_switch {
 		struct {
 			zval root;
 			srns_item *srns; /* string ref namespace */
 			HashTable *refs; /* shared ref */
+			zend_string **str_cache; /* recently decoded strings */
+			size_t prealloc; /* preallocated slots of open arrays yet to be filled */
+			bool str_is_text; /* major type of the last decoded string */
 		} zv;
 		struct {
 			smart_str str;
 			int indent_level;
 		} edn;
+		struct {
+			smart_str str;
+		} json;
+		struct {
+			vd_str_entry *strs; /* strings of stringref-namespaces */
+			uint32_t str_count, str_size;
+			uint32_t srns_start; /* index of the first string of the current namespace */
+			uint32_t srns_depth;
+			zend_long share_count;
+		} vd;
 	} u;
 } dec_context;
 
 struct decode_vt {
 	int si_size;
+	int si_clear_size;  /* leading bytes of the item cleared on push */
 	void (*ctx_init)(dec_context *ctx);
 	void (*ctx_free)(dec_context *ctx);
-	cbor_error (*dec_item)(const uint8_t *data, size_t len, cbor_di_decoded *out, dec_context *ctx);
+	cbor_error (*dec_loop)(dec_context *ctx);
 	cbor_error (*dec_finish)(dec_context *ctx, cbor_decode_args *args, cbor_error error, zval *value);
 	void (*si_free)(stack_item *item);
 	void (*si_push)(dec_context *ctx, stack_item *item, stack_item *parent_item);
@@ -82,11 +113,11 @@ typedef enum {
 } si_type_code;
 
 typedef enum {
-	DATA_TYPE_STRING = 1,
+	DATA_TYPE_BYTE = 1,
+	DATA_TYPE_TEXT,
 } data_type;
 
 struct stack_item {
-	stack_item *next_item;
 	const decode_vt *vt;
 	si_type_code si_type;
 	uint32_t count;
@@ -107,6 +138,7 @@ enum tag_handler_index_value {
 	THI_STR_REF,
 	THI_SHAREABLE,
 	THI_SHARED_REF,
+	THI_DATETIME,  /* date/time string and epoch-based date/time */
 	THI_COUNT,
 };
 
@@ -150,7 +182,7 @@ struct stack_item_zv {
 
 static void zv_ctx_init(dec_context *ctx);
 static void zv_ctx_free(dec_context *ctx);
-static cbor_error zv_dec_item(const uint8_t *data, size_t len, cbor_di_decoded *out, dec_context *ctx);
+static cbor_error zv_dec_loop(dec_context *ctx);
 static cbor_error zv_dec_finish(dec_context *ctx, cbor_decode_args *args, cbor_error error, zval *value);
 static void zv_si_free(stack_item *item);
 static void zv_si_push(dec_context *ctx, stack_item *item, stack_item *parent_item);
@@ -158,9 +190,10 @@ static void zv_si_pop(dec_context *ctx, stack_item *item);
 
 static const decode_vt zv_dec_vt = {
 	sizeof(stack_item_zv),
+	offsetof(stack_item_zv, v),  /* value is initialized on push */
 	&zv_ctx_init,
 	&zv_ctx_free,
-	&zv_dec_item,
+	&zv_dec_loop,
 	&zv_dec_finish,
 	&zv_si_free,
 	&zv_si_push,
@@ -169,26 +202,93 @@ static const decode_vt zv_dec_vt = {
 
 static void edn_ctx_init(dec_context *ctx);
 static void edn_ctx_free(dec_context *ctx);
-static cbor_error edn_dec_item(const uint8_t *data, size_t len, cbor_di_decoded *out, dec_context *ctx);
+static cbor_error edn_dec_loop(dec_context *ctx);
 static cbor_error edn_dec_finish(dec_context *ctx, cbor_decode_args *args, cbor_error error, zval *value);
 static void edn_si_free(stack_item *item);
 static void edn_si_push(dec_context *ctx, stack_item *item, stack_item *parent_item);
 static void edn_si_pop(dec_context *ctx, stack_item *item);
 
 static const decode_vt edn_dec_vt = {
+	sizeof(stack_item_zv),
 	sizeof(stack_item_zv),
 	&edn_ctx_init,
 	&edn_ctx_free,
-	&edn_dec_item,
+	&edn_dec_loop,
 	&edn_dec_finish,
 	&edn_si_free,
 	&edn_si_push,
 	&edn_si_pop,
 };
 
+typedef struct stack_item_vd {
+	stack_item base;
+	tag_handler_index thi;
+	bool keeps_str;  /* content of indefinite-length string is needed; map key or date/time string */
+	bool has_key;  /* map value is expected */
+	bool has_content;  /* content of shareable is pushed */
+	uint32_t n;  /* count of added elements for indefinite-length */
+	union si_vd_value_ {
+		HashTable *keys;  /* for CBOR_MAP_NO_DUP_KEY */
+		smart_str str;  /* content of indefinite-length string if keeps_str */
+		uint32_t srns_start;  /* of the outer namespace */
+		zend_long share_index;
+		zend_long tag_id;  /* THI_DATETIME */
+	} v;
+} stack_item_vd;
+
+static void vd_ctx_init(dec_context *ctx);
+static void vd_ctx_free(dec_context *ctx);
+static cbor_error vd_dec_loop(dec_context *ctx);
+static cbor_error vd_dec_finish(dec_context *ctx, cbor_decode_args *args, cbor_error error, zval *value);
+static void vd_si_free(stack_item *item);
+static void vd_si_push(dec_context *ctx, stack_item *item, stack_item *parent_item);
+static void vd_si_pop(dec_context *ctx, stack_item *item);
+
+static const decode_vt vd_dec_vt = {
+	sizeof(stack_item_vd),
+	sizeof(stack_item_vd),
+	&vd_ctx_init,
+	&vd_ctx_free,
+	&vd_dec_loop,
+	&vd_dec_finish,
+	&vd_si_free,
+	&vd_si_push,
+	&vd_si_pop,
+};
+
+typedef struct stack_item_json {
+	stack_item base;
+	uint8_t byte_enc;  /* encoding of byte strings in the item */
+	bool is_key;  /* tag, string: the item is a map key */
+	bool map_is_key;  /* map: key is expected */
+	bool appended;  /* array, map: separator is required before the next element */
+	smart_str str;  /* chunks of indefinite-length byte string */
+} stack_item_json;
+
+static void json_ctx_init(dec_context *ctx);
+static void json_ctx_free(dec_context *ctx);
+static cbor_error json_dec_loop(dec_context *ctx);
+static cbor_error json_dec_finish(dec_context *ctx, cbor_decode_args *args, cbor_error error, zval *value);
+static void json_si_free(stack_item *item);
+static void json_si_push(dec_context *ctx, stack_item *item, stack_item *parent_item);
+static void json_si_pop(dec_context *ctx, stack_item *item);
+
+static const decode_vt json_dec_vt = {
+	sizeof(stack_item_json),
+	sizeof(stack_item_json),
+	&json_ctx_init,
+	&json_ctx_free,
+	&json_dec_loop,
+	&json_dec_finish,
+	&json_si_free,
+	&json_si_push,
+	&json_si_pop,
+};
+
 struct srns_item {  /* srns: string ref namespace */
 	srns_item *prev_item;
 	HashTable *str_table;
+	smart_str text_flags;  /* 1 byte per str_table entry, non-zero if text */
 };
 
 static cbor_error decode_nested(dec_context *ctx);
@@ -236,24 +336,23 @@ DECLARE_SI_SET_HANDLER_VEC(thi_child)
 
 #define SI_CALL_CHILD_HANDLER(si, ...)  SI_CALL_HANDLER_VEC(thi_child, h_child, si, __VA_ARGS__)
 
+#define STACK_INIT_SIZE  16
+#define STACK_ITEM_AT(ctx, depth)  ((stack_item *)((ctx)->stack_base + (size_t)(depth) * (ctx)->vt->si_size))
+
 static void stack_free_item(dec_context *ctx, stack_item *item)
 {
 	if (item == NULL) {
 		return;
 	}
 	item->vt->si_free(item);
-	assert(item->next_item == NULL);
-	item->next_item = ctx->stack_pool;
-	ctx->stack_pool = item;
 }
 
 static stack_item *stack_pop_item(dec_context *ctx)
 {
 	stack_item *item = ctx->stack_top;
 	if (item) {
-		ctx->stack_top = item->next_item;
-		item->next_item = NULL;
 		ctx->stack_depth--;
+		ctx->stack_top = ctx->stack_depth ? STACK_ITEM_AT(ctx, ctx->stack_depth - 1) : NULL;
 		ctx->vt->si_pop(ctx, item);
 	}
 	return item;
@@ -266,21 +365,31 @@ static void stack_push_item(dec_context *ctx, stack_item *item)
 		stack_free_item(ctx, item);
 		RETURN_CB_ERROR(CBOR_ERROR_DEPTH);
 	}
+	assert(item == STACK_ITEM_AT(ctx, ctx->stack_depth));
 	ctx->vt->si_push(ctx, item, parent_item);
 	ctx->stack_depth++;
-	item->next_item = ctx->stack_top;
 	ctx->stack_top = item;
 }
 
+/* Items are taken from the slot above the top; the pointers to the items are invalidated on the next call. */
 static void *stack_new_item(dec_context *ctx, si_type_code si_type, uint32_t count)
 {
-	stack_item *item = ctx->stack_pool;
-	if (item) {
-		ctx->stack_pool = item->next_item;
-		memset(item, 0, ctx->vt->si_size);
-	} else {
-		item = ecalloc(1, ctx->vt->si_size);
+	stack_item *item;
+	if (ctx->stack_depth >= ctx->stack_size) {
+		/* one more than the max depth, as the item is taken before the depth is checked */
+		uint32_t size = ctx->stack_size ? ctx->stack_size * 2 : STACK_INIT_SIZE;
+		if (size > ctx->args.max_depth + 1) {
+			size = ctx->args.max_depth + 1;
+		}
+		assert(size > ctx->stack_depth);
+		ctx->stack_base = safe_erealloc(ctx->stack_base, size, ctx->vt->si_size, 0);
+		ctx->stack_size = size;
+		if (ctx->stack_top) {
+			ctx->stack_top = STACK_ITEM_AT(ctx, ctx->stack_depth - 1);
+		}
 	}
+	item = STACK_ITEM_AT(ctx, ctx->stack_depth);
+	memset(item, 0, ctx->vt->si_clear_size);
 	item->vt = ctx->vt;
 	item->si_type = si_type;
 	item->count = count;
@@ -301,30 +410,30 @@ static void cbor_decode_free(dec_context *ctx)
 		stack_item *item = stack_pop_item(ctx);
 		stack_free_item(ctx, item);
 	}
-	stack_item *ptr = ctx->stack_pool;
-	while (ptr) {
-		stack_item *next = ptr->next_item;
-		efree(ptr);
-		ptr = next;
+	if (ctx->stack_base) {
+		efree(ctx->stack_base);
 	}
 	ctx->vt->ctx_free(ctx);
 }
 
-static void cbor_decode_init(dec_context *ctx, const cbor_decode_args *args, cbor_fragment *mem)
+static void cbor_decode_init_vt(dec_context *ctx, const cbor_decode_args *args, cbor_fragment *mem, const decode_vt *vt)
 {
 	ctx->skip_self_desc = !(args->flags & CBOR_SELF_DESCRIBE);
-	ctx->stack_top = ctx->stack_pool = NULL;
-	ctx->stack_depth = 0;
+	ctx->stack_top = NULL;
+	ctx->stack_base = NULL;
+	ctx->stack_depth = ctx->stack_size = 0;
 	ctx->args = *args;
 	ctx->mem = mem;
-	if (args->flags & CBOR_EDN) {
-		ctx->vt = &edn_dec_vt;
-	} else {
-		ctx->vt = &zv_dec_vt;
-	}
+	ctx->data = NULL;
+	ctx->vt = vt;
 	ctx->vt->ctx_init(ctx);
 }
 
+static void cbor_decode_init(dec_context *ctx, const cbor_decode_args *args, cbor_fragment *mem)
+{
+	cbor_decode_init_vt(ctx, args, mem, (args->flags & CBOR_EDN) ? &edn_dec_vt : &zv_dec_vt);
+}
+
 dec_context *cbor_decode_new(const cbor_decode_args *args, cbor_fragment *mem)
 {
 	dec_context *ctx = emalloc(sizeof(dec_context));
@@ -374,28 +483,37 @@ cbor_error cbor_decode_finish(dec_context *ctx, cbor_decode_args *args, cbor_err
 	return ctx->vt->dec_finish(ctx, args, error, value);
 }
 
-cbor_error cbor_decode(zend_string *data, zval *value, cbor_decode_args *args)
+/* Set the range of the data to decode; 'offset' and 'length' options are applied. */
+cbor_error cbor_init_fragment(cbor_fragment *mem, zend_string *data, cbor_decode_args *args)
 {
 	cbor_error error = 0;
-	dec_context ctx;
-	cbor_fragment mem;
-	mem.offset = args->offset;
-	mem.length = ZSTR_LEN(data);
-	if (mem.offset > mem.length) {
+	mem->offset = args->offset;
+	mem->length = ZSTR_LEN(data);
+	if (mem->offset > mem->length) {
 		error = CBOR_ERROR_TRUNCATED_DATA;
-		args->error_args.offset = mem.length;
+		args->error_args.offset = mem->length;
 	} else if (args->length != LEN_DEFAULT) {
-		if ((size_t)args->length > mem.length || mem.offset > mem.length - args->length) {
+		if ((size_t)args->length > mem->length || mem->offset > mem->length - args->length) {
 			error = CBOR_ERROR_TRUNCATED_DATA;
-			args->error_args.offset = mem.length;
+			args->error_args.offset = mem->length;
 		}
-		mem.length = mem.offset + args->length;
+		mem->length = mem->offset + args->length;
 	}
-	mem.base = 0;
-	mem.limit = mem.length;
-	mem.ptr = (const uint8_t *)ZSTR_VAL(data);
+	mem->base = 0;
+	mem->limit = mem->length;
+	mem->ptr = (const uint8_t *)ZSTR_VAL(data);
+	return error;
+}
+
+cbor_error cbor_decode(zend_string *data, zval *value, cbor_decode_args *args)
+{
+	cbor_error error;
+	dec_context ctx;
+	cbor_fragment mem;
+	error = cbor_init_fragment(&mem, data, args);
 	if (!error) {
 		cbor_decode_init(&ctx, args, &mem);
+		ctx.data = data;
 		error = cbor_decode_process(&ctx);
 		if (!error && mem.offset != mem.length) {
 			error = CBOR_ERROR_EXTRANEOUS_DATA;
@@ -407,26 +525,67 @@ cbor_error cbor_decode(zend_string *data, zval *value, cbor_decode_args *args)
 	return error;
 }
 
-static cbor_error decode_nested(dec_context *ctx)
+/* Check a data item without building the value; *length is set to the length of the item. */
+cbor_error cbor_validate(zend_string *data, size_t *length, cbor_decode_args *args)
 {
 	cbor_error error;
-	cbor_fragment *mem = ctx->mem;
-	cbor_di_decoded out_data;
-	ctx->cb_error = 0;
-	do {
-		if (mem->offset >= mem->length) {
-			return CBOR_ERROR_TRUNCATED_DATA;
-		}
-		error = ctx->vt->dec_item(mem->ptr + mem->offset, mem->length - mem->offset, &out_data, ctx);
-		mem->offset += out_data.read_len;
-		if (error) {
-			return error;
-		}
-		if (ctx->cb_error) {
-			return ctx->cb_error;
+	dec_context ctx;
+	cbor_fragment mem;
+	error = cbor_init_fragment(&mem, data, args);
+	if (!error) {
+		cbor_decode_init_vt(&ctx, args, &mem, &vd_dec_vt);
+		error = cbor_decode_process(&ctx);
+		*length = mem.offset - (size_t)args->offset;
+		error = cbor_decode_finish(&ctx, args, error, NULL);
+		cbor_decode_free(&ctx);
+	}
+	return error;
+}
+
+/* Convert a data item to JSON text without creating values. */
+cbor_error cbor_to_json(zend_string *data, zval *value, cbor_decode_args *args)
+{
+	cbor_error error;
+	dec_context ctx;
+	cbor_fragment mem;
+	error = cbor_init_fragment(&mem, data, args);
+	if (!error) {
+		cbor_decode_init_vt(&ctx, args, &mem, &json_dec_vt);
+		error = cbor_decode_process(&ctx);
+		if (!error && mem.offset != mem.length) {
+			error = CBOR_ERROR_EXTRANEOUS_DATA;
+			ctx.args.error_args.offset = mem.base + mem.offset;
 		}
-	} while (ctx->stack_depth);
-	return 0;
+		error = cbor_decode_finish(&ctx, args, error, value);
+		cbor_decode_free(&ctx);
+	}
+	return error;
+}
+
+static cbor_error decode_nested(dec_context *ctx)
+{
+	return ctx->vt->dec_loop(ctx);
+}
+
+/* Decode the data item in the range of the data, i.e. the content of a lazy value. */
+cbor_error cbor_decode_item(zend_string *data, size_t offset, size_t length, zval *value, cbor_decode_args *args)
+{
+	cbor_error error;
+	dec_context ctx;
+	cbor_fragment mem;
+	mem.ptr = (const uint8_t *)ZSTR_VAL(data);
+	mem.base = 0;
+	mem.offset = offset;
+	mem.length = mem.limit = offset + length;
+	cbor_decode_init_vt(&ctx, args, &mem, &zv_dec_vt);
+	ctx.data = data;
+	error = decode_nested(&ctx);
+	if (error) {
+		ctx.args.error_args.offset = mem.base + mem.offset;
+	}
+	error = cbor_decode_finish(&ctx, args, error, value);
+	cbor_decode_free(&ctx);
+	return error;
 }
 
 #define CBOR_INT_BUF_SIZE  24 /* ceil(log10(2)*64) = 20 */
@@ -469,5 +628,101 @@ bool cbor_is_len_string_ref(size_t str_len, uint32_t next_index)
 	return str_len >= threshold;
 }
 
+#define DATETIME_BUF_SIZE  sizeof "0000-00-00T00:00:00.000000+00:00"
+
+static bool scan_digits(const char *str, int width, int *value)
+{
+	*value = 0;
+	for (int i = 0; i < width; i++) {
+		if (str[i] < '0' || str[i] > '9') {
+			return false;
+		}
+		*value = *value * 10 + (str[i] - '0');
+	}
+	return true;
+}
+
+/* Check the RFC 3339 date-time and copy it to buf for timelib, dropping the fraction beyond microseconds. Returns 0 if invalid. */
+static size_t normalize_datetime(char *buf, const char *str, size_t len)
+{
+	static const uint8_t month_days[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+	int year, month, day, hour, minute, second, off_hour, off_minute;
+	size_t pos = 19;
+	char *ptr;
+	/* 0         1         2         3   */
+	/* 012345678901234567890123456789012 */
+	/* 2001-02-03T04:05:06.000007+08:09  */
+	if (len < 20
+			|| !scan_digits(&str[0], 4, &year) || str[4] != '-'
+			|| !scan_digits(&str[5], 2, &month) || str[7] != '-'
+			|| !scan_digits(&str[8], 2, &day) || (str[10] != 'T' && str[10] != 't')
+			|| !scan_digits(&str[11], 2, &hour) || str[13] != ':'
+			|| !scan_digits(&str[14], 2, &minute) || str[16] != ':'
+			|| !scan_digits(&str[17], 2, &second)) {
+		return 0;
+	}
+	if (month < 1 || month > 12 || day < 1 || day > month_days[month - 1]
+			|| (month == 2 && day == 29 && (year % 4 || (year % 100 == 0 && year % 400)))
+			|| hour > 23 || minute > 59 || second > 60) {  /* leap second */
+		return 0;
+	}
+	memcpy(buf, str, pos);
+	buf[10] = 'T';
+	ptr = &buf[pos];
+	if (str[pos] == '.') {
+		size_t start = ++pos, frac_len;
+		while (pos < len && str[pos] >= '0' && str[pos] <= '9') {
+			pos++;
+		}
+		if ((frac_len = pos - start) == 0) {
+			return 0;
+		}
+		if (frac_len > 6) {
+			frac_len = 6;
+		}
+		*ptr++ = '.';
+		memcpy(ptr, &str[start], frac_len);
+		ptr += frac_len;
+	}
+	if (pos + 1 == len && (str[pos] == 'Z' || str[pos] == 'z')) {
+		*ptr++ = 'Z';
+	} else if (pos + 6 == len && (str[pos] == '+' || str[pos] == '-')
+			&& scan_digits(&str[pos + 1], 2, &off_hour) && str[pos + 3] == ':'
+			&& scan_digits(&str[pos + 4], 2, &off_minute)
+			&& off_hour <= 23 && off_minute <= 59) {
+		memcpy(ptr, &str[pos], 6);
+		ptr += 6;
+	} else {
+		return 0;
+	}
+	assert((size_t)(ptr - buf) < DATETIME_BUF_SIZE);
+	return ptr - buf;
+}
+
+/* ZEND_LONG_MIN is excluded, as the sign and the digits are parsed separately by timelib */
+#define IS_EPOCH_IN_RANGE(sec)  ((sec) != ZEND_LONG_MIN)
+
+/* Split the epoch-based date/time in float into seconds and microseconds. */
+static bool split_epoch(double value, zend_long *sec, int *usec)
+{
+	double sec_value;
+	if (!(value > (double)ZEND_LONG_MIN && value < -(double)ZEND_LONG_MIN)) {  /* or NaN */
+		return false;
+	}
+	sec_value = floor(value);
+	*sec = (zend_long)sec_value;
+	*usec = (int)round((value - sec_value) * 1000000);
+	if (*usec >= 1000000) {
+		if (*sec == ZEND_LONG_MAX) {
+			return false;
+		}
+		(*sec)++;
+		*usec = 0;
+	}
+	return true;
+}
+
 #include "decode_zv.h"
 #include "decode_edn.h"
+#include "decode_vd.h"
+#include "decode_json.h"
@@ -3,76 +3,79 @@
  * @license BSD-2-Clause
  */
 
-#define SET_READ_ERROR(result)  do { \
-		if (UNEXPECTED(!result)) { \
-			goto DI_FAILURE; \
-		} \
-	} while (0)
-
-static cbor_error METHOD(dec_item)(const uint8_t *data, size_t len, cbor_di_decoded *out, dec_context *ctx)
+/* Decode a data item at data; *read_len is set to the length consumed, or 0 if the head is not read. */
+static zend_always_inline cbor_error METHOD(dec_item)(const uint8_t *data, size_t len, size_t *read_len, dec_context *ctx)
 {
 	cbor_error error = 0;
-	uint8_t type = cbor_di_get_type(data, len);
-	out->read_len = 1;
-	out->req_len = 0;
+	const cbor_di_head *head = &cbor_di_heads[data[0]];
+	uint8_t type = head->type;
+	uint64_t arg;
+	*read_len = 0;
+	if (UNEXPECTED(!type)) {
+		return CBOR_ERROR_MALFORMED_DATA;
+	}
+	if (UNEXPECTED(head->arg_len > len - 1)) {
+		return CBOR_ERROR_TRUNCATED_DATA;
+	}
+	arg = cbor_di_read_arg(data, head->arg_len);
+	*read_len = 1 + head->arg_len;
 	switch (type) {
 	case DI_UINT:
-		SET_READ_ERROR(cbor_di_read_int(data, len, out));
-		if (!DI_IS_DOUBLE(*out)) {
-			METHOD(proc_uint32)(ctx, out->v.i32);
+		if (head->arg_len != 8) {
+			METHOD(proc_uint32)(ctx, (uint32_t)arg);
 		} else {
-			METHOD(proc_uint64)(ctx, out->v.i64);
+			METHOD(proc_uint64)(ctx, arg);
 		}
 		break;
 	case DI_NINT:
-		SET_READ_ERROR(cbor_di_read_int(data, len, out));
-		if (!DI_IS_DOUBLE(*out)) {
-			METHOD(proc_nint32)(ctx, out->v.i32);
+		if (head->arg_len != 8) {
+			METHOD(proc_nint32)(ctx, (uint32_t)arg);
 		} else {
-			METHOD(proc_nint64)(ctx, out->v.i64);
+			METHOD(proc_nint64)(ctx, arg);
 		}
 		break;
 	case DI_BSTR:
-		SET_READ_ERROR(cbor_di_read_str(data, len, out));
-		if (EXPECTED(out->v.str.val)) {
-			METHOD(proc_byte_string)(ctx, out->v.str.val, out->v.str.len);
-		} else {
-			METHOD(proc_byte_string_start)(ctx);
-		}
-		break;
 	case DI_TSTR:
-		SET_READ_ERROR(cbor_di_read_str(data, len, out));
-		if (EXPECTED(out->v.str.val)) {
-			METHOD(proc_text_string)(ctx, out->v.str.val, out->v.str.len);
-		} else {
+		if (EXPECTED(!head->is_indef)) {
+			const char *val = (const char *)&data[*read_len];
+			if (UNEXPECTED(arg > len - *read_len)) {
+				*read_len = 0;
+				return CBOR_ERROR_TRUNCATED_DATA;
+			}
+			*read_len += (size_t)arg;
+			if (type == DI_TSTR) {
+				METHOD(proc_text_string)(ctx, val, arg);
+			} else {
+				METHOD(proc_byte_string)(ctx, val, arg);
+			}
+		} else if (type == DI_TSTR) {
 			METHOD(proc_text_string_start)(ctx);
+		} else {
+			METHOD(proc_byte_string_start)(ctx);
 		}
 		break;
 	case DI_ARRAY:
-		SET_READ_ERROR(cbor_di_read_list(data, len, out));
-		if (EXPECTED(!out->v.ext.is_indef)) {
-			if (out->v.i64 > 0xffffffff) {
+		if (EXPECTED(!head->is_indef)) {
+			if (arg > 0xffffffff) {
 				return CBOR_ERROR_UNSUPPORTED_SIZE;
 			}
-			METHOD(proc_array_start)(ctx, (uint32_t)out->v.i64);
+			METHOD(proc_array_start)(ctx, (uint32_t)arg);
 		} else {
 			METHOD(proc_indef_array_start)(ctx);
 		}
 		break;
 	case DI_MAP:
-		SET_READ_ERROR(cbor_di_read_list(data, len, out));
-		if (EXPECTED(!out->v.ext.is_indef)) {
-			if (out->v.i64 > 0xffffffff) {
+		if (EXPECTED(!head->is_indef)) {
+			if (arg > 0xffffffff) {
 				return CBOR_ERROR_UNSUPPORTED_SIZE;
 			}
-			METHOD(proc_map_start)(ctx, (uint32_t)out->v.i64);
+			METHOD(proc_map_start)(ctx, (uint32_t)arg);
 		} else {
 			METHOD(proc_indef_map_start)(ctx);
 		}
 		break;
 	case DI_TAG:
-		SET_READ_ERROR(cbor_di_read_int(data, len, out));
-		METHOD(proc_tag)(ctx, !DI_IS_DOUBLE(*out) ? out->v.i32 : out->v.i64);
+		METHOD(proc_tag)(ctx, arg);
 		break;
 	case DI_FALSE:
 	case DI_TRUE:
@@ -85,31 +88,29 @@ static cbor_error METHOD(dec_item)(const uint8_t *data, size_t len, cbor_di_deco
 		METHOD(proc_undefined)(ctx);
 		break;
 	case DI_SIMPLE0:
-		SET_READ_ERROR(cbor_di_read_int(data, len, out));
-		assert(out->v.i32 <= 31);
-		METHOD(proc_simple)(ctx, out->v.i32);
+		assert(arg <= 31);
+		METHOD(proc_simple)(ctx, (uint32_t)arg);
 		break;
 	case DI_SIMPLE8:
-		SET_READ_ERROR(cbor_di_read_int(data, len, out));
-		if (out->v.i32 <= 31) {
+		if (arg <= 31) {
 			// 0..23: not-well-formed range is not used (RFC 8949 3.3)
 			// 24..31 reserved to minimize confusion (RFC 8949 3.3)
 			return CBOR_ERROR_MALFORMED_DATA;
 		}
-		METHOD(proc_simple)(ctx, out->v.i32);
+		METHOD(proc_simple)(ctx, (uint32_t)arg);
 		break;
 	case DI_FLOAT16:
-		SET_READ_ERROR(cbor_di_read_float(data, len, out));
-		METHOD(proc_float16)(ctx, out->v.f16);
+		METHOD(proc_float16)(ctx, (uint16_t)arg);
 		break;
 	case DI_FLOAT32:
-		SET_READ_ERROR(cbor_di_read_float(data, len, out));
-		METHOD(proc_float32)(ctx, out->v.i32);
+		METHOD(proc_float32)(ctx, (uint32_t)arg);
 		break;
-	case DI_FLOAT64:
-		SET_READ_ERROR(cbor_di_read_float(data, len, out));
-		METHOD(proc_float64)(ctx, out->v.f64);
+	case DI_FLOAT64: {
+		double f64;
+		memcpy(&f64, &arg, sizeof f64);
+		METHOD(proc_float64)(ctx, f64);
 		break;
+	}
 	case DI_BREAK: {
 		stack_item *item = stack_pop_item(ctx);
 		if (UNEXPECTED(item == NULL)) {
@@ -120,13 +121,32 @@ static cbor_error METHOD(dec_item)(const uint8_t *data, size_t len, cbor_di_deco
 		break;
 	}
 	default:
-		out->read_len = 0;
+		*read_len = 0;
 		return CBOR_ERROR_MALFORMED_DATA;
 	}
 	goto FINALLY;
-DI_FAILURE:
-	error = out->req_len ? CBOR_ERROR_TRUNCATED_DATA : CBOR_ERROR_MALFORMED_DATA;
-	goto FINALLY;
 FINALLY:
 	return error;
 }
+
+static cbor_error METHOD(dec_loop)(dec_context *ctx)
+{
+	cbor_error error;
+	cbor_fragment *mem = ctx->mem;
+	size_t read_len;
+	ctx->cb_error = 0;
+	do {
+		if (mem->offset >= mem->length) {
+			return CBOR_ERROR_TRUNCATED_DATA;
+		}
+		error = METHOD(dec_item)(mem->ptr + mem->offset, mem->length - mem->offset, &read_len, ctx);
+		mem->offset += read_len;
+		if (error) {
+			return error;
+		}
+		if (ctx->cb_error) {
+			return ctx->cb_error;
+		}
+	} while (ctx->stack_depth);
+	return 0;
+}
@@ -3,7 +3,6 @@
  * @license BSD-2-Clause
  */
 
-#include "compatibility.h"
 #include <math.h>
 #include <Zend/zend_strtod.h>
 
@@ -0,0 +1,525 @@
+/**
+ * @author SATO Kentaro
+ * @license BSD-2-Clause
+ */
+
+/* JSON transcoder; text is written from the data items as they are read, without creating values. */
+
+#include <math.h>
+#include <Zend/zend_strtod.h>
+
+typedef enum {
+	JSON_ENC_BASE64URL = 0,
+	JSON_ENC_BASE64,
+	JSON_ENC_HEX,
+} json_byte_enc;
+
+#define JSON_STR  (&ctx->u.json.str)
+#define JSON_APPEND_CHAR(c)  smart_str_appendc(JSON_STR, (c))
+#define JSON_APPEND_LSTR(s)  smart_str_appendl_ex(JSON_STR, ZEND_STRL(s), false)
+
+static void json_ctx_init(dec_context *ctx)
+{
+	memset(&ctx->u.json.str, 0, sizeof ctx->u.json.str);
+}
+
+static void json_ctx_free(dec_context *ctx)
+{
+	smart_str_free(&ctx->u.json.str);
+}
+
+static void json_si_free(stack_item *item_)
+{
+	stack_item_json *item = (stack_item_json *)item_;
+	smart_str_free(&item->str);
+}
+
+static void json_si_push(dec_context *ctx, stack_item *item, stack_item *parent_item)
+{
+}
+
+static void json_si_pop(dec_context *ctx, stack_item *item)
+{
+}
+
+static cbor_error json_dec_finish(dec_context *ctx, cbor_decode_args *args, cbor_error error, zval *value)
+{
+	if (error) {
+		args->error_args = ctx->args.error_args;
+		return error;
+	}
+	ZVAL_STR(value, smart_str_extract(&ctx->u.json.str));
+	return 0;
+}
+
+/* Tags 21..23 set the encoding of the byte strings nested in the content. */
+static uint8_t json_get_byte_enc(dec_context *ctx)
+{
+	stack_item_json *item = (stack_item_json *)ctx->stack_top;
+	return item ? item->byte_enc : JSON_ENC_BASE64URL;
+}
+
+/* Write the separator before an item; *is_key is set if the item is a map key. */
+static bool json_begin(dec_context *ctx, bool *is_key)
+{
+	stack_item_json *item = (stack_item_json *)ctx->stack_top;
+	*is_key = false;
+	if (item == NULL) {
+		return true;
+	}
+	switch (item->base.si_type) {
+	case SI_TYPE_ARRAY:
+		if (item->appended) {
+			JSON_APPEND_CHAR(',');
+		}
+		item->appended = true;
+		return true;
+	case SI_TYPE_MAP:
+		if (item->map_is_key) {
+			if (item->appended) {
+				JSON_APPEND_CHAR(',');
+			}
+			item->appended = true;
+			*is_key = true;
+		}
+		return true;
+	case SI_TYPE_TAG:
+		*is_key = item->is_key;
+		return true;
+	}
+	if (item->base.si_type & SI_TYPE_STRING_MASK) {
+		RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_SYNTAX, INDEF_STRING_CHUNK_TYPE));
+	}
+	RETURN_CB_ERROR_B(CBOR_ERROR_INTERNAL);
+}
+
+/* Count the item written in the container; completed containers and tags are closed. */
+static void json_end(dec_context *ctx)
+{
+	stack_item_json *item;
+	while ((item = (stack_item_json *)ctx->stack_top) != NULL) {
+		switch (item->base.si_type) {
+		case SI_TYPE_ARRAY:
+			if (!item->base.count || --item->base.count) {
+				return;
+			}
+			JSON_APPEND_CHAR(']');
+			break;
+		case SI_TYPE_MAP:
+			if (item->map_is_key) {
+				item->map_is_key = false;
+				JSON_APPEND_CHAR(':');
+				return;
+			}
+			item->map_is_key = true;
+			if (!item->base.count || --item->base.count) {
+				return;
+			}
+			JSON_APPEND_CHAR('}');
+			break;
+		case SI_TYPE_TAG:
+			break;
+		default:
+			RETURN_CB_ERROR(CBOR_ERROR_INTERNAL);
+		}
+		stack_pop_item(ctx);
+		stack_free_item(ctx, &item->base);
+	}
+}
+
+static void json_append_text(dec_context *ctx, const char *val, size_t length)
+{
+	const uint8_t *str = (const uint8_t *)val;
+	const uint8_t *end = str + length;
+	const uint8_t *run = str;
+	for (; str < end; str++) {
+		char esc_seq_char;
+		if (EXPECTED(*str >= 0x20 && *str != '"' && *str != '\\')) {
+			continue;
+		}
+		if (run < str) {
+			smart_str_appendl_ex(JSON_STR, (const char *)run, str - run, false);
+		}
+		run = str + 1;
+		switch (*str) {
+		case '\\': esc_seq_char = '\\'; break;
+		case '"':  esc_seq_char = '"'; break;
+		case '\t': esc_seq_char = 't'; break;
+		case '\r': esc_seq_char = 'r'; break;
+		case '\f': esc_seq_char = 'f'; break;
+		case '\n': esc_seq_char = 'n'; break;
+		case '\b': esc_seq_char = 'b'; break;
+		default:
+			smart_str_append_printf(JSON_STR, "\\u%04x", *str);
+			continue;
+		}
+		JSON_APPEND_CHAR('\\');
+		JSON_APPEND_CHAR(esc_seq_char);
+	}
+	if (run < end) {
+		smart_str_appendl_ex(JSON_STR, (const char *)run, end - run, false);
+	}
+}
+
+static void json_append_bytes(dec_context *ctx, const char *val, size_t length, uint8_t byte_enc)
+{
+	const uint8_t *str = (const uint8_t *)val;
+	const uint8_t *end = str + length;
+	char *ptr;
+	JSON_APPEND_CHAR('"');
+	if (byte_enc == JSON_ENC_HEX) {
+		static const char hex_digits[] = "0123456789abcdef";
+		if (UNEXPECTED(length > SIZE_MAX / 2)) {
+			RETURN_CB_ERROR(CBOR_ERROR_UNSUPPORTED_SIZE);
+		}
+		ptr = smart_str_extend(JSON_STR, length * 2);
+		for (; str < end; str++) {
+			*ptr++ = hex_digits[*str >> 4];
+			*ptr++ = hex_digits[*str & 0x0f];
+		}
+	} else {
+		/* RFC 4648; base64url is without padding (RFC 8949 3.4.5.2) */
+		static const char base64_digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		static const char base64url_digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+		const char *digits = (byte_enc == JSON_ENC_BASE64) ? base64_digits : base64url_digits;
+		size_t rem = length % 3;
+		size_t out_len = length / 3 * 4;
+		if (UNEXPECTED(length / 3 > SIZE_MAX / 4 - 1)) {
+			RETURN_CB_ERROR(CBOR_ERROR_UNSUPPORTED_SIZE);
+		}
+		if (rem) {
+			out_len += (byte_enc == JSON_ENC_BASE64) ? 4 : rem + 1;
+		}
+		ptr = smart_str_extend(JSON_STR, out_len);
+		for (end -= rem; str < end; str += 3) {
+			uint32_t bits = (uint32_t)str[0] << 16 | (uint32_t)str[1] << 8 | str[2];
+			*ptr++ = digits[bits >> 18];
+			*ptr++ = digits[(bits >> 12) & 0x3f];
+			*ptr++ = digits[(bits >> 6) & 0x3f];
+			*ptr++ = digits[bits & 0x3f];
+		}
+		if (rem) {
+			uint32_t bits = (uint32_t)str[0] << 16 | (rem == 2 ? (uint32_t)str[1] << 8 : 0);
+			*ptr++ = digits[bits >> 18];
+			*ptr++ = digits[(bits >> 12) & 0x3f];
+			if (rem == 2) {
+				*ptr++ = digits[(bits >> 6) & 0x3f];
+			}
+			if (byte_enc == JSON_ENC_BASE64) {
+				if (rem == 1) {
+					*ptr++ = '=';
+				}
+				*ptr++ = '=';
+			}
+		}
+	}
+	JSON_APPEND_CHAR('"');
+}
+
+static void json_do_int(dec_context *ctx, uint64_t val, bool is_negative)
+{
+	char buf[CBOR_INT_BUF_SIZE];
+	size_t len;
+	bool is_key;
+	if (!json_begin(ctx, &is_key)) {
+		return;
+	}
+	len = cbor_int_to_str(buf, val, is_negative);
+	if (is_key) {
+		/* JSON member name is a string */
+		JSON_APPEND_CHAR('"');
+		smart_str_appendl_ex(JSON_STR, buf, len, false);
+		JSON_APPEND_CHAR('"');
+	} else {
+		smart_str_appendl_ex(JSON_STR, buf, len, false);
+	}
+	json_end(ctx);
+}
+
+static void json_proc_uint64(dec_context *ctx, uint64_t val)
+{
+	json_do_int(ctx, val, false);
+}
+
+static void json_proc_uint32(dec_context *ctx, uint32_t val)
+{
+	json_do_int(ctx, val, false);
+}
+
+static void json_proc_nint64(dec_context *ctx, uint64_t val)
+{
+	json_do_int(ctx, val, true);
+}
+
+static void json_proc_nint32(dec_context *ctx, uint32_t val)
+{
+	json_do_int(ctx, val, true);
+}
+
+static void json_do_xstring(dec_context *ctx, const char *val, uint64_t length, bool is_text)
+{
+	stack_item_json *item = (stack_item_json *)ctx->stack_top;
+	bool is_key;
+#if UINT64_MAX > SIZE_MAX
+	if (length > SIZE_MAX) {
+		RETURN_CB_ERROR(CBOR_ERROR_UNSUPPORTED_SIZE);
+	}
+#endif
+	if (is_text && !(ctx->args.flags & CBOR_UNSAFE_TEXT)
+			&& !is_utf8((uint8_t *)val, (size_t)length)) {
+		RETURN_CB_ERROR(CBOR_ERROR_UTF8);
+	}
+	if (item != NULL && item->base.si_type & SI_TYPE_STRING_MASK) {
+		/* indefinite-length string */
+		si_type_code str_si_type = is_text ? SI_TYPE_TEXT : SI_TYPE_BYTE;
+		if (item->base.si_type != str_si_type) {
+			RETURN_CB_ERROR(E_DESC(CBOR_ERROR_SYNTAX, INCONSISTENT_STRING_TYPE));
+		}
+		if (is_text) {
+			json_append_text(ctx, val, (size_t)length);
+		} else if (length) {
+			/* encoded as a whole, as chunks may not be aligned to the encoding unit */
+			smart_str_appendl(&item->str, val, (size_t)length);
+		}
+		return;
+	}
+	if (!json_begin(ctx, &is_key)) {
+		return;
+	}
+	if (is_text) {
+		JSON_APPEND_CHAR('"');
+		json_append_text(ctx, val, (size_t)length);
+		JSON_APPEND_CHAR('"');
+	} else {
+		json_append_bytes(ctx, val, (size_t)length, json_get_byte_enc(ctx));
+	}
+	json_end(ctx);
+}
+
+static void json_stack_push_xstring(dec_context *ctx, si_type_code si_type)
+{
+	bool is_key;
+	uint8_t byte_enc = json_get_byte_enc(ctx);
+	if (!json_begin(ctx, &is_key)) {
+		return;
+	}
+	if (si_type == SI_TYPE_TEXT) {
+		JSON_APPEND_CHAR('"');
+	}
+	stack_item_json *item = stack_new_item(ctx, si_type, 0);
+	item->byte_enc = byte_enc;
+	item->is_key = is_key;
+	stack_push_item(ctx, &item->base);
+}
+
+static void json_proc_text_string(dec_context *ctx, const char *val, uint64_t length)
+{
+	json_do_xstring(ctx, val, length, true);
+}
+
+static void json_proc_text_string_start(dec_context *ctx)
+{
+	json_stack_push_xstring(ctx, SI_TYPE_TEXT);
+}
+
+static void json_proc_byte_string(dec_context *ctx, const char *val, uint64_t length)
+{
+	json_do_xstring(ctx, val, length, false);
+}
+
+static void json_proc_byte_string_start(dec_context *ctx)
+{
+	json_stack_push_xstring(ctx, SI_TYPE_BYTE);
+}
+
+static void json_stack_push_container(dec_context *ctx, si_type_code si_type, uint32_t count)
+{
+	bool is_map = si_type == SI_TYPE_MAP;
+	bool is_key;
+	uint8_t byte_enc = json_get_byte_enc(ctx);
+	if (count > ctx->args.max_size) {
+		RETURN_CB_ERROR(CBOR_ERROR_UNSUPPORTED_SIZE);
+	}
+	if (!json_begin(ctx, &is_key)) {
+		return;
+	}
+	if (is_key) {
+		if (is_map) {
+			RETURN_CB_ERROR(E_DESC(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, OBJECT));
+		}
+		RETURN_CB_ERROR(E_DESC(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, ARRAY));
+	}
+	JSON_APPEND_CHAR(is_map ? '{' : '[');
+	stack_item_json *item = stack_new_item(ctx, si_type, count);
+	item->byte_enc = byte_enc;
+	item->map_is_key = true;
+	stack_push_item(ctx, &item->base);
+}
+
+static void json_proc_array_start(dec_context *ctx, uint32_t count)
+{
+	bool is_key;
+	if (count) {
+		json_stack_push_container(ctx, SI_TYPE_ARRAY, count);
+	} else if (json_begin(ctx, &is_key)) {
+		if (is_key) {
+			RETURN_CB_ERROR(E_DESC(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, ARRAY));
+		}
+		JSON_APPEND_LSTR("[]");
+		json_end(ctx);
+	}
+}
+
+static void json_proc_indef_array_start(dec_context *ctx)
+{
+	json_stack_push_container(ctx, SI_TYPE_ARRAY, 0);
+}
+
+static void json_proc_map_start(dec_context *ctx, uint32_t count)
+{
+	bool is_key;
+	if (count) {
+		json_stack_push_container(ctx, SI_TYPE_MAP, count);
+	} else if (json_begin(ctx, &is_key)) {
+		if (is_key) {
+			RETURN_CB_ERROR(E_DESC(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, OBJECT));
+		}
+		JSON_APPEND_LSTR("{}");
+		json_end(ctx);
+	}
+}
+
+static void json_proc_indef_map_start(dec_context *ctx)
+{
+	json_stack_push_container(ctx, SI_TYPE_MAP, 0);
+}
+
+static void json_proc_tag(dec_context *ctx, uint64_t val)
+{
+	/* the content is written in place of the tag */
+	bool is_key;
+	uint8_t byte_enc = json_get_byte_enc(ctx);
+	if (!json_begin(ctx, &is_key)) {
+		return;
+	}
+	if (val == CBOR_TAG_STRING_REF_NS || val == CBOR_TAG_STRING_REF
+			|| val == CBOR_TAG_SHAREABLE || val == CBOR_TAG_SHARED_REF) {
+		/* references are not resolved; the content alone does not represent the value */
+		RETURN_CB_ERROR(CBOR_ERROR_UNSUPPORTED_TYPE);
+	}
+	if (val == CBOR_TAG_TO_BASE64URL) {
+		byte_enc = JSON_ENC_BASE64URL;
+	} else if (val == CBOR_TAG_TO_BASE64) {
+		byte_enc = JSON_ENC_BASE64;
+	} else if (val == CBOR_TAG_TO_HEX) {
+		byte_enc = JSON_ENC_HEX;
+	}
+	stack_item_json *item = stack_new_item(ctx, SI_TYPE_TAG, 1);
+	item->byte_enc = byte_enc;
+	item->is_key = is_key;
+	stack_push_item(ctx, &item->base);
+}
+
+static void json_do_float(dec_context *ctx, double val, int digits)
+{
+	char buf[ZEND_DOUBLE_MAX_LENGTH + 2];
+	char *str;
+	size_t len;
+	bool is_key;
+	if (!json_begin(ctx, &is_key)) {
+		return;
+	}
+	if (is_key) {
+		RETURN_CB_ERROR(E_DESC(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, FLOAT));
+	}
+	if (isinf(val) || isnan(val)) {
+		/* RFC 8949 6.1 */
+		JSON_APPEND_LSTR("null");
+	} else {
+		str = zend_gcvt(val, digits, '.', 'e', buf);
+		len = strlen(str);
+		if (!memchr(str, '.', len)) {
+			str[len++] = '.';
+			str[len++] = '0';  /* keep float distinguishable from int */
+		}
+		smart_str_appendl_ex(JSON_STR, str, len, false);
+	}
+	json_end(ctx);
+}
+
+static void json_proc_float16(dec_context *ctx, uint16_t val)
+{
+	json_do_float(ctx, cbor_from_fp16i(val), 5);
+}
+
+static void json_proc_float32(dec_context *ctx, uint32_t val)
+{
+	binary32_alias val32;
+	val32.i = val;
+	json_do_float(ctx, (double)val32.f, 9);
+}
+
+static void json_proc_float64(dec_context *ctx, double val)
+{
+	json_do_float(ctx, val, -1);
+}
+
+static void json_do_literal(dec_context *ctx, const char *str, size_t len, cbor_error key_error)
+{
+	bool is_key;
+	if (!json_begin(ctx, &is_key)) {
+		return;
+	}
+	if (is_key) {
+		RETURN_CB_ERROR(key_error);
+	}
+	smart_str_appendl_ex(JSON_STR, str, len, false);
+	json_end(ctx);
+}
+
+static void json_proc_null(dec_context *ctx)
+{
+	json_do_literal(ctx, ZEND_STRL("null"), E_DESC(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, NULL));
+}
+
+static void json_proc_undefined(dec_context *ctx)
+{
+	json_do_literal(ctx, ZEND_STRL("null"), E_DESC(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, UNDEF));
+}
+
+static void json_proc_simple(dec_context *ctx, uint32_t val)
+{
+	json_do_literal(ctx, ZEND_STRL("null"), CBOR_ERROR_UNSUPPORTED_KEY_TYPE);
+}
+
+static void json_proc_boolean(dec_context *ctx, bool val)
+{
+	if (val) {
+		json_do_literal(ctx, ZEND_STRL("true"), E_DESC(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, BOOL));
+	} else {
+		json_do_literal(ctx, ZEND_STRL("false"), E_DESC(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, BOOL));
+	}
+}
+
+static void json_proc_indef_break(dec_context *ctx, stack_item *item_)
+{
+	stack_item_json *item = (stack_item_json *)item_;
+	if (item->base.si_type & SI_TYPE_STRING_MASK) {
+		if (item->base.si_type == SI_TYPE_TEXT) {
+			JSON_APPEND_CHAR('"');
+		} else {
+			json_append_bytes(ctx, item->str.s ? ZSTR_VAL(item->str.s) : "", smart_str_get_len(&item->str), item->byte_enc);
+		}
+	} else {  /* SI_TYPE_ARRAY, SI_TYPE_MAP, SI_TYPE_TAG */
+		if (UNEXPECTED(item->base.count != 0)  /* definite-length */
+				|| (item->base.si_type == SI_TYPE_MAP && UNEXPECTED(!item->map_is_key))) {  /* value is expected */
+			RETURN_CB_ERROR(E_DESC(CBOR_ERROR_SYNTAX, BREAK_UNEXPECTED));
+		}
+		JSON_APPEND_CHAR(item->base.si_type == SI_TYPE_ARRAY ? ']' : '}');
+	}
+	json_end(ctx);
+}
+
+#define METHOD(name) json_##name
+#include "decode_base.h"
+#undef METHOD
@@ -0,0 +1,613 @@
+/**
+ * @author SATO Kentaro
+ * @license BSD-2-Clause
+ */
+
+/* Validating decoder; data items are checked as zv_* would decode them, without creating values. */
+
+typedef enum {
+	VD_OTHER = 0,  /* null, bool, float, array */
+	VD_LONG,
+	VD_XINT,  /* integer out of zend_long range */
+	VD_STRING,
+	VD_OBJECT,
+	VD_SHARED,  /* value of shareable or shared ref */
+} vd_type;
+
+typedef struct {
+	vd_type type;
+	zend_long lval;  /* VD_LONG: value, VD_SHARED: index */
+	uint64_t ival;  /* VD_LONG, VD_XINT: raw value */
+	bool is_negative;
+	bool is_text;  /* VD_STRING, VD_OBJECT: text string */
+	bool is_float;  /* VD_OTHER, VD_OBJECT: float or Cbor\FloatX */
+	double dval;  /* is_float */
+	const char *str;  /* VD_STRING */
+	size_t len;
+} vd_value;
+
+#define VD_IS_MAP_KEY(item)  ((item) != NULL && (item)->base.si_type == SI_TYPE_MAP && !(item)->has_key)
+
+static void vd_ctx_init(dec_context *ctx)
+{
+	ctx->u.vd.strs = NULL;
+	ctx->u.vd.str_count = ctx->u.vd.str_size = 0;
+	ctx->u.vd.srns_start = 0;
+	ctx->u.vd.srns_depth = 0;
+	ctx->u.vd.share_count = 0;
+}
+
+static void vd_ctx_free(dec_context *ctx)
+{
+	if (ctx->u.vd.strs) {
+		efree(ctx->u.vd.strs);
+	}
+}
+
+static void vd_si_free(stack_item *item_)
+{
+	stack_item_vd *item = (stack_item_vd *)item_;
+	if (item->base.si_type & SI_TYPE_STRING_MASK) {
+		smart_str_free(&item->v.str);
+	} else if (item->base.si_type == SI_TYPE_MAP) {
+		if (item->v.keys) {
+			zend_array_destroy(item->v.keys);
+		}
+	}
+}
+
+static void vd_si_push(dec_context *ctx, stack_item *item, stack_item *parent_item)
+{
+	stack_item_vd *parent = (stack_item_vd *)parent_item;
+	if (parent && parent->base.si_type == SI_TYPE_TAG_HANDLED && parent->thi == THI_SHAREABLE) {
+		/* see tag_handler_shareable_child() */
+		if (ctx->args.shared_ref == OPT_TRUE
+				&& (item->si_type != SI_TYPE_MAP || ctx->args.flags & CBOR_MAP_AS_ARRAY)) {
+			RETURN_CB_ERROR(E_DESC(CBOR_ERROR_TAG_TYPE, SHARE_INCOMPATIBLE));
+		}
+		parent->has_content = true;
+	}
+}
+
+static void vd_si_pop(dec_context *ctx, stack_item *item)
+{
+}
+
+static cbor_error vd_dec_finish(dec_context *ctx, cbor_decode_args *args, cbor_error error, zval *value)
+{
+	if (error) {
+		args->error_args = ctx->args.error_args;
+	}
+	return error;
+}
+
+static void vd_stack_push(dec_context *ctx, si_type_code si_type, uint32_t count)
+{
+	stack_item_vd *item = stack_new_item(ctx, si_type, count);
+	stack_push_item(ctx, &item->base);
+}
+
+static void vd_stack_push_xstring(dec_context *ctx, si_type_code si_type)
+{
+	stack_item_vd *parent = (stack_item_vd *)ctx->stack_top;
+	bool keeps_str = VD_IS_MAP_KEY(parent)
+		|| (parent && parent->base.si_type == SI_TYPE_TAG_HANDLED && parent->thi == THI_DATETIME);
+	stack_item_vd *item = stack_new_item(ctx, si_type, 0);
+	item->keeps_str = keeps_str;
+	stack_push_item(ctx, &item->base);
+}
+
+static bool vd_append(dec_context *ctx, const vd_value *value);
+
+static bool vd_append_type(dec_context *ctx, vd_type type)
+{
+	vd_value value = {type};
+	return vd_append(ctx, &value);
+}
+
+static bool vd_append_counted(dec_context *ctx, vd_type type)
+{
+	stack_item *item = stack_pop_item(ctx);
+	bool result = vd_append_type(ctx, type);
+	stack_free_item(ctx, item);
+	return result;
+}
+
+static bool vd_append_to_array(dec_context *ctx, const vd_value *value, stack_item_vd *item)
+{
+	if (value->type == VD_XINT) {
+		RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_UNSUPPORTED_VALUE, INT_RANGE));
+	}
+	if (!item->base.count && item->n++ >= ctx->args.max_size) {
+		RETURN_CB_ERROR_B(CBOR_ERROR_UNSUPPORTED_SIZE);
+	}
+	if (item->base.count && --item->base.count == 0) {
+		ASSERT_STACK_ITEM_IS_TOP(item);
+		return vd_append_counted(ctx, VD_OTHER);
+	}
+	return true;
+}
+
+/* Check the key as zv_append_to_map() adds it to the array or the object. */
+static bool vd_add_map_key(dec_context *ctx, const vd_value *key, stack_item_vd *item)
+{
+	bool is_object = !(ctx->args.flags & CBOR_MAP_AS_ARRAY);
+	char buf[CBOR_INT_BUF_SIZE];
+	const char *str;
+	size_t len;
+	zend_ulong index;
+	zval *added;
+	switch (key->type) {
+	case VD_LONG:
+	case VD_XINT:
+		if (!(ctx->args.flags & CBOR_INT_KEY)) {
+			RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, INT_KEY));
+		}
+		break;
+	case VD_STRING:
+		if (is_object && key->len >= 1 && key->str[0] == '\0') {
+			RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_UNSUPPORTED_KEY_VALUE, RESERVED_PROP_NAME));
+		}
+		break;
+	default:
+		RETURN_CB_ERROR_B(CBOR_ERROR_UNSUPPORTED_KEY_TYPE);
+	}
+	if (!(ctx->args.flags & CBOR_MAP_NO_DUP_KEY)) {
+		return true;
+	}
+	if (!item->v.keys) {
+		item->v.keys = zend_new_array(0);
+	}
+	if (key->type == VD_LONG && !is_object) {
+		added = zend_hash_index_add_empty_element(item->v.keys, (zend_ulong)key->lval);
+	} else {
+		if (key->type == VD_STRING) {
+			str = key->str;
+			len = key->len;
+		} else {
+			len = cbor_int_to_str(buf, key->ival, key->is_negative);
+			str = buf;
+		}
+		if (!is_object && ZEND_HANDLE_NUMERIC_STR(str, len, index)) {
+			added = zend_hash_index_add_empty_element(item->v.keys, index);
+		} else {
+			added = zend_hash_str_add_empty_element(item->v.keys, str, len);
+		}
+	}
+	if (!added) {
+		RETURN_CB_ERROR_B(CBOR_ERROR_DUPLICATE_KEY);
+	}
+	return true;
+}
+
+static bool vd_append_to_map(dec_context *ctx, const vd_value *value, stack_item_vd *item)
+{
+	if (!item->has_key) {
+		if (!item->base.count && ++item->n > ctx->args.max_size) {
+			RETURN_CB_ERROR_B(CBOR_ERROR_UNSUPPORTED_SIZE);
+		}
+		item->has_key = true;
+		return vd_add_map_key(ctx, value, item);
+	}
+	if (value->type == VD_XINT) {
+		RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_UNSUPPORTED_VALUE, INT_RANGE));
+	}
+	item->has_key = false;
+	if (item->base.count && --item->base.count == 0) {
+		ASSERT_STACK_ITEM_IS_TOP(item);
+		return vd_append_counted(ctx, (ctx->args.flags & CBOR_MAP_AS_ARRAY) ? VD_OTHER : VD_OBJECT);
+	}
+	return true;
+}
+
+static bool vd_append_to_tag(dec_context *ctx, const vd_value *value, stack_item_vd *item)
+{
+	if (value->type == VD_XINT) {
+		RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_UNSUPPORTED_VALUE, INT_RANGE));
+	}
+	ASSERT_STACK_ITEM_IS_TOP(item);
+	return vd_append_counted(ctx, VD_OBJECT);  /* Cbor\Tag */
+}
+
+/* Check the content of the date/time tag as tag_handler_datetime_exit() converts it. */
+static bool vd_check_datetime(dec_context *ctx, const vd_value *value, zend_long tag_id)
+{
+	char buf[DATETIME_BUF_SIZE];
+	zend_long sec;
+	int usec;
+	if (tag_id == CBOR_TAG_DATETIME) {
+		if ((value->type != VD_STRING && value->type != VD_OBJECT) || !value->is_text) {  /* not a byte string */
+			RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_TAG_TYPE, DATETIME_NOT_TEXT));
+		}
+		if (!normalize_datetime(buf, value->str, value->len)) {
+			RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_TAG_VALUE, DATETIME_SYNTAX));
+		}
+	} else if (value->type == VD_XINT || (value->type == VD_LONG && !IS_EPOCH_IN_RANGE(value->lval))) {
+		RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_TAG_VALUE, EPOCH_RANGE));
+	} else if (value->type != VD_LONG) {
+		if (!value->is_float) {
+			RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_TAG_TYPE, EPOCH_NOT_NUM));
+		}
+		if (!split_epoch(value->dval, &sec, &usec)) {
+			RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_TAG_VALUE, EPOCH_RANGE));
+		}
+	}
+	return true;
+}
+
+static bool vd_append_to_tag_handled(dec_context *ctx, const vd_value *value, stack_item_vd *item)
+{
+	vd_value result = *value;
+	const vd_str_entry *entry;
+	ASSERT_STACK_ITEM_IS_TOP(item);
+	switch (item->thi) {
+	case THI_STR_REF_NS:
+		/* leave the namespace */
+		ctx->u.vd.str_count = ctx->u.vd.srns_start;
+		ctx->u.vd.srns_start = item->v.srns_start;
+		ctx->u.vd.srns_depth--;
+		break;
+	case THI_STR_REF:
+		if (value->type != VD_LONG) {
+			RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_TAG_TYPE, STR_REF_NOT_INT));
+		}
+		if (value->lval < 0 || (zend_ulong)value->lval >= ctx->u.vd.str_count - ctx->u.vd.srns_start) {
+			RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_TAG_VALUE, STR_REF_RANGE));
+		}
+		entry = &ctx->u.vd.strs[ctx->u.vd.srns_start + value->lval];
+		result.type = entry->is_xstring ? VD_OBJECT : VD_STRING;
+		result.is_text = entry->is_text;
+		result.str = entry->val;
+		result.len = entry->len;
+		break;
+	case THI_SHAREABLE:
+		if (value->type == VD_XINT) {
+			RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_UNSUPPORTED_VALUE, INT_RANGE));
+		}
+		if (item->has_content) {
+			if (ctx->args.shared_ref == OPT_UNSAFE_REF
+					&& value->type == VD_SHARED && value->lval == item->v.share_index) {
+				RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_TAG_VALUE, SHARE_SELF));
+			}
+		} else if (ctx->args.shared_ref == OPT_TRUE && value->type != VD_OBJECT) {
+			RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_TAG_TYPE, SHARE_INCOMPATIBLE));
+		}
+		result.type = VD_SHARED;
+		result.lval = item->v.share_index;
+		break;
+	case THI_SHARED_REF:
+		if (value->type != VD_LONG) {
+			RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_TAG_TYPE, SHARE_NOT_INT));
+		}
+		if (value->lval < 0 || value->lval >= ctx->u.vd.share_count) {
+			RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_TAG_VALUE, SHARE_RANGE));
+		}
+		result.type = VD_SHARED;
+		break;
+	case THI_DATETIME:
+		if (!vd_check_datetime(ctx, value, item->v.tag_id)) {
+			return false;
+		}
+		memset(&result, 0, sizeof result);
+		result.type = VD_OBJECT;  /* DateTimeImmutable */
+		break;
+	default:
+		RETURN_CB_ERROR_B(CBOR_ERROR_INTERNAL);
+	}
+	stack_pop_item(ctx);
+	bool appended = vd_append(ctx, &result);
+	stack_free_item(ctx, &item->base);
+	return appended;
+}
+
+static bool vd_append(dec_context *ctx, const vd_value *value)
+{
+	stack_item_vd *item = (stack_item_vd *)ctx->stack_top;
+	if (item == NULL) {
+		if (value->type == VD_XINT) {
+			RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_UNSUPPORTED_VALUE, INT_RANGE));
+		}
+		return true;
+	}
+	switch (item->base.si_type) {
+	case SI_TYPE_ARRAY:
+		return vd_append_to_array(ctx, value, item);
+	case SI_TYPE_MAP:
+		return vd_append_to_map(ctx, value, item);
+	case SI_TYPE_TAG:
+		return vd_append_to_tag(ctx, value, item);
+	case SI_TYPE_TAG_HANDLED:
+		return vd_append_to_tag_handled(ctx, value, item);
+	}
+	if (item->base.si_type & SI_TYPE_STRING_MASK) {
+		RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_SYNTAX, INDEF_STRING_CHUNK_TYPE));
+	}
+	RETURN_CB_ERROR_B(CBOR_ERROR_INTERNAL);
+}
+
+static void vd_do_int(dec_context *ctx, uint64_t val, bool is_negative, bool is_overflow)
+{
+	vd_value value = {VD_LONG};
+	if (is_overflow) {
+		value.type = VD_XINT;
+	} else {
+		value.lval = is_negative ? -(zend_long)val - 1 : (zend_long)val;
+	}
+	value.ival = val;
+	value.is_negative = is_negative;
+	vd_append(ctx, &value);
+}
+
+static void vd_proc_uint32(dec_context *ctx, uint32_t val)
+{
+	vd_do_int(ctx, val, false, TEST_OVERFLOW_XINT32(val));
+}
+
+static void vd_proc_uint64(dec_context *ctx, uint64_t val)
+{
+	vd_do_int(ctx, val, false, TEST_OVERFLOW_XINT64(val));
+}
+
+static void vd_proc_nint32(dec_context *ctx, uint32_t val)
+{
+	vd_do_int(ctx, val, true, TEST_OVERFLOW_XINT32(val));
+}
+
+static void vd_proc_nint64(dec_context *ctx, uint64_t val)
+{
+	vd_do_int(ctx, val, true, TEST_OVERFLOW_XINT64(val));
+}
+
+/* Register the string to the current namespace as tag_handler_str_ref_ns_data() does. */
+static void vd_add_string_ref(dec_context *ctx, const vd_value *value)
+{
+	vd_str_entry *entry;
+	if (!cbor_is_len_string_ref(value->len, ctx->u.vd.str_count - ctx->u.vd.srns_start)) {
+		return;
+	}
+	if (ctx->u.vd.str_count >= ctx->u.vd.str_size) {
+		uint32_t size = ctx->u.vd.str_size ? ctx->u.vd.str_size * 2 : 16;
+		ctx->u.vd.strs = safe_erealloc(ctx->u.vd.strs, size, sizeof *ctx->u.vd.strs, 0);
+		ctx->u.vd.str_size = size;
+	}
+	entry = &ctx->u.vd.strs[ctx->u.vd.str_count++];
+	entry->val = value->str;
+	entry->len = value->len;
+	entry->is_xstring = value->type == VD_OBJECT;
+	entry->is_text = value->is_text;
+}
+
+static void vd_append_string_item(dec_context *ctx, vd_value *value, bool is_text, bool is_indef)
+{
+	int type_flag = is_text ? CBOR_TEXT : CBOR_BYTE;
+	stack_item_vd *item = (stack_item_vd *)ctx->stack_top;
+	value->is_text = is_text;
+	if (VD_IS_MAP_KEY(item)) {
+		bool is_valid_type = is_text ? (ctx->args.flags & CBOR_KEY_TEXT) : (ctx->args.flags & CBOR_KEY_BYTE);
+		if (!is_valid_type) {
+			cbor_error error = is_text ? E_DESC(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, TEXT) : E_DESC(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, BYTE);
+			RETURN_CB_ERROR(error);
+		}
+		value->type = VD_STRING;
+	} else {
+		value->type = (ctx->args.flags & type_flag) ? VD_STRING : VD_OBJECT;  /* or Cbor\Byte, Cbor\Text */
+	}
+	if (!is_indef && ctx->u.vd.srns_depth) {
+		/* every item above the namespace tag is in the namespace */
+		vd_add_string_ref(ctx, value);
+	}
+	vd_append(ctx, value);
+}
+
+static void vd_do_xstring(dec_context *ctx, const char *val, uint64_t length, bool is_text)
+{
+	vd_value value = {VD_STRING};
+	stack_item_vd *item = (stack_item_vd *)ctx->stack_top;
+#if UINT64_MAX > SIZE_MAX
+	if (length > SIZE_MAX) {
+		RETURN_CB_ERROR(CBOR_ERROR_UNSUPPORTED_SIZE);
+	}
+#endif
+	if (is_text && !(ctx->args.flags & CBOR_UNSAFE_TEXT)
+			&& !is_utf8((uint8_t *)val, (size_t)length)) {
+		RETURN_CB_ERROR(CBOR_ERROR_UTF8);
+	}
+	if (item != NULL && item->base.si_type & SI_TYPE_STRING_MASK) {
+		/* indefinite-length string */
+		si_type_code str_si_type = is_text ? SI_TYPE_TEXT : SI_TYPE_BYTE;
+		if (item->base.si_type == str_si_type) {
+			if (length && item->keeps_str) {
+				/* content is only needed to check the key or the date/time */
+				if (UNEXPECTED(length > SIZE_MAX - smart_str_get_len(&item->v.str))) {
+					RETURN_CB_ERROR(CBOR_ERROR_UNSUPPORTED_SIZE);
+				}
+				smart_str_appendl(&item->v.str, val, (size_t)length);
+			}
+			return;
+		}
+		RETURN_CB_ERROR(E_DESC(CBOR_ERROR_SYNTAX, INCONSISTENT_STRING_TYPE));
+	}
+	value.str = val;
+	value.len = (size_t)length;
+	vd_append_string_item(ctx, &value, is_text, false);
+}
+
+static void vd_proc_text_string(dec_context *ctx, const char *val, uint64_t length)
+{
+	vd_do_xstring(ctx, val, length, true);
+}
+
+static void vd_proc_text_string_start(dec_context *ctx)
+{
+	vd_stack_push_xstring(ctx, SI_TYPE_TEXT);
+}
+
+static void vd_proc_byte_string(dec_context *ctx, const char *val, uint64_t length)
+{
+	vd_do_xstring(ctx, val, length, false);
+}
+
+static void vd_proc_byte_string_start(dec_context *ctx)
+{
+	vd_stack_push_xstring(ctx, SI_TYPE_BYTE);
+}
+
+static void vd_proc_array_start(dec_context *ctx, uint32_t count)
+{
+	if (count > ctx->args.max_size) {
+		RETURN_CB_ERROR(CBOR_ERROR_UNSUPPORTED_SIZE);
+	}
+	if (ctx->mem->limit && ctx->mem->offset + 1 + count > ctx->mem->limit) {
+		RETURN_CB_ERROR(CBOR_ERROR_TRUNCATED_DATA);
+	}
+	if (count) {
+		vd_stack_push(ctx, SI_TYPE_ARRAY, count);
+	} else {
+		vd_append_type(ctx, VD_OTHER);
+	}
+}
+
+static void vd_proc_indef_array_start(dec_context *ctx)
+{
+	vd_stack_push(ctx, SI_TYPE_ARRAY, 0);
+}
+
+static void vd_proc_map_start(dec_context *ctx, uint32_t count)
+{
+	if (count > ctx->args.max_size) {
+		RETURN_CB_ERROR(CBOR_ERROR_UNSUPPORTED_SIZE);
+	}
+	if (ctx->mem->limit && ctx->mem->offset + 1 + count * 2 > ctx->mem->limit) {
+		RETURN_CB_ERROR(CBOR_ERROR_TRUNCATED_DATA);
+	}
+	if (count) {
+		vd_stack_push(ctx, SI_TYPE_MAP, count);
+	} else {
+		vd_append_type(ctx, (ctx->args.flags & CBOR_MAP_AS_ARRAY) ? VD_OTHER : VD_OBJECT);
+	}
+}
+
+static void vd_proc_indef_map_start(dec_context *ctx)
+{
+	vd_stack_push(ctx, SI_TYPE_MAP, 0);
+}
+
+static void vd_proc_tag(dec_context *ctx, uint64_t val)
+{
+	tag_handler_index thi = THI_NONE;
+	stack_item_vd *item = (stack_item_vd *)ctx->stack_top;
+	if (val > ZEND_LONG_MAX) {
+		RETURN_CB_ERROR(E_DESC(CBOR_ERROR_UNSUPPORTED_VALUE, INT_RANGE));
+	}
+	if (val == CBOR_TAG_STRING_REF_NS && ctx->args.string_ref) {
+		thi = THI_STR_REF_NS;
+	} else if (val == CBOR_TAG_STRING_REF && ctx->args.string_ref) {
+		if (!ctx->u.vd.srns_depth) {
+			/* outer stringref-namespace is expected */
+			RETURN_CB_ERROR(E_DESC(CBOR_ERROR_TAG_SYNTAX, STR_REF_NO_NS));
+		}
+		thi = THI_STR_REF;
+	} else if (val == CBOR_TAG_SHAREABLE && ctx->args.shared_ref) {
+		if (item && item->base.si_type == SI_TYPE_TAG_HANDLED && item->thi == THI_SHAREABLE) {
+			/* nested shareable */
+			RETURN_CB_ERROR(E_DESC(CBOR_ERROR_TAG_SYNTAX, SHARE_NESTED));
+		}
+		thi = THI_SHAREABLE;
+	} else if (val == CBOR_TAG_SHARED_REF && ctx->args.shared_ref) {
+		thi = THI_SHARED_REF;
+	} else if ((val == CBOR_TAG_DATETIME || val == CBOR_TAG_EPOCH) && ctx->args.datetime) {
+		thi = THI_DATETIME;
+	}
+	if (thi == THI_NONE) {
+		vd_stack_push(ctx, SI_TYPE_TAG, 1);
+		return;
+	}
+	item = stack_new_item(ctx, SI_TYPE_TAG_HANDLED, 1);
+	item->thi = thi;
+	if (thi == THI_STR_REF_NS) {
+		/* enter the namespace */
+		item->v.srns_start = ctx->u.vd.srns_start;
+		ctx->u.vd.srns_start = ctx->u.vd.str_count;
+		ctx->u.vd.srns_depth++;
+	} else if (thi == THI_SHAREABLE) {
+		item->v.share_index = ctx->u.vd.share_count++;
+	} else if (thi == THI_DATETIME) {
+		item->v.tag_id = (zend_long)val;
+	}
+	stack_push_item(ctx, &item->base);
+}
+
+static void vd_do_floatx(dec_context *ctx, int type_flag, double val)
+{
+	vd_value value = {(ctx->args.flags & type_flag) ? VD_OTHER : VD_OBJECT};  /* or Cbor\FloatX */
+	value.is_float = true;
+	value.dval = val;
+	vd_append(ctx, &value);
+}
+
+static void vd_proc_float16(dec_context *ctx, uint16_t val)
+{
+	vd_do_floatx(ctx, CBOR_FLOAT16, cbor_from_fp16i((cbor_fp16i)val));
+}
+
+static void vd_proc_float32(dec_context *ctx, uint32_t val)
+{
+	binary32_alias binary32;
+	binary32.i = val;
+	vd_do_floatx(ctx, CBOR_FLOAT32, cbor_from_fp32(binary32.f));
+}
+
+static void vd_proc_float64(dec_context *ctx, double val)
+{
+	vd_value value = {VD_OTHER};
+	value.is_float = true;
+	value.dval = val;
+	vd_append(ctx, &value);
+}
+
+static void vd_proc_null(dec_context *ctx)
+{
+	vd_append_type(ctx, VD_OTHER);
+}
+
+static void vd_proc_undefined(dec_context *ctx)
+{
+	vd_append_type(ctx, VD_OBJECT);
+}
+
+static void vd_proc_simple(dec_context *ctx, uint32_t val)
+{
+	RETURN_CB_ERROR(E_DESC(CBOR_ERROR_UNSUPPORTED_TYPE, SIMPLE));
+}
+
+static void vd_proc_boolean(dec_context *ctx, bool val)
+{
+	vd_append_type(ctx, VD_OTHER);
+}
+
+static void vd_proc_indef_break(dec_context *ctx, stack_item *item_)
+{
+	stack_item_vd *item = (stack_item_vd *)item_;
+	if (item->base.si_type & SI_TYPE_STRING_MASK) {
+		vd_value value = {VD_STRING};
+		if (item->v.str.s) {
+			value.str = ZSTR_VAL(item->v.str.s);
+			value.len = ZSTR_LEN(item->v.str.s);
+		} else {
+			value.str = "";
+		}
+		vd_append_string_item(ctx, &value, item->base.si_type == SI_TYPE_TEXT, true);
+	} else {  /* SI_TYPE_ARRAY, SI_TYPE_MAP, SI_TYPE_TAG, SI_TYPE_TAG_HANDLED */
+		if (UNEXPECTED(item->base.count != 0)  /* definite-length */
+				|| (item->base.si_type == SI_TYPE_MAP && UNEXPECTED(item->has_key))) {  /* value is expected */
+			THROW_CB_ERROR(E_DESC(CBOR_ERROR_SYNTAX, BREAK_UNEXPECTED));
+		}
+		assert(item->base.si_type == SI_TYPE_ARRAY || item->base.si_type == SI_TYPE_MAP);
+		vd_append_type(ctx, (item->base.si_type == SI_TYPE_MAP && !(ctx->args.flags & CBOR_MAP_AS_ARRAY)) ? VD_OBJECT : VD_OTHER);
+	}
+FINALLY: ;
+}
+
+#define METHOD(name) vd_##name
+#include "decode_base.h"
+#undef METHOD
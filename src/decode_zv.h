@@ -18,6 +18,9 @@ static void zv_ctx_init(dec_context *ctx)
 	if (ctx->args.shared_ref) {
 		ctx->u.zv.refs = zend_new_array(0);
 	}
+	ctx->u.zv.str_cache = NULL;
+	ctx->u.zv.prealloc = 0;
+	ctx->u.zv.str_is_text = false;
 }
 
 static void zv_ctx_free(dec_context *ctx)
@@ -26,6 +29,14 @@ static void zv_ctx_free(dec_context *ctx)
 	if (ctx->args.shared_ref) {
 		zend_array_destroy(ctx->u.zv.refs);
 	}
+	if (ctx->u.zv.str_cache) {
+		for (int i = 0; i < STR_CACHE_SIZE; i++) {
+			if (ctx->u.zv.str_cache[i]) {
+				zend_string_release(ctx->u.zv.str_cache[i]);
+			}
+		}
+		efree(ctx->u.zv.str_cache);
+	}
 	zval_ptr_dtor(&ctx->u.zv.root);
 }
 
@@ -85,6 +96,7 @@ static void zv_stack_push_counted(dec_context *ctx, si_type_code si_type, zval *
 static void zv_stack_push_xstring(dec_context *ctx, si_type_code si_type)
 {
 	stack_item_zv *item = stack_new_item(ctx, si_type, 0);
+	memset(&item->v.str, 0, sizeof item->v.str);
 	stack_push_item(ctx, &item->base);
 }
 
@@ -114,6 +126,23 @@ static bool zv_append_counted(dec_context *ctx, zval *value)
 	return result;
 }
 
+/* Append to the packed array with a room, as ZEND_HASH_FILL_PACKED does. */
+static zend_always_inline void zv_fill_packed(HashTable *ht, zval *value)
+{
+	uint32_t idx = ht->nNumUsed;
+	assert(HT_IS_PACKED(ht) && idx < ht->nTableSize && idx == ht->nNumOfElements);
+#if TARGET_PHP_API_LT_82
+	Bucket *bucket = ht->arData + idx;
+	ZVAL_COPY_VALUE(&bucket->val, value);
+	bucket->h = idx;
+	bucket->key = NULL;
+#else
+	ZVAL_COPY_VALUE(&ht->arPacked[idx], value);
+#endif
+	ht->nNumUsed = ht->nNumOfElements = idx + 1;
+	ht->nNextFreeElement = (zend_long)idx + 1;
+}
+
 static bool zv_append_to_array(dec_context *ctx, xzval *value, stack_item_zv *item)
 {
 	if (XZ_ISXXINT_P(value)) {
@@ -123,8 +152,20 @@ static bool zv_append_to_array(dec_context *ctx, xzval *value, stack_item_zv *it
 		/* max size of indefinite-length array is enforced on append */
 		RETURN_CB_ERROR_B(CBOR_ERROR_UNSUPPORTED_SIZE);
 	}
-	if (add_next_index_zval(&item->v.value, value) != SUCCESS) {
-		RETURN_CB_ERROR_B(CBOR_ERROR_INTERNAL);
+	HashTable *ht = Z_ARRVAL(item->v.value);
+	if (item->base.count && EXPECTED(HT_IS_PACKED(ht) && ht->nNumUsed < ht->nTableSize)) {
+		/* definite-length array is preallocated */
+		zv_fill_packed(ht, value);
+		ctx->u.zv.prealloc--;
+	} else {
+		uint32_t size = ht->nTableSize;
+		if (add_next_index_zval(&item->v.value, value) != SUCCESS) {
+			RETURN_CB_ERROR_B(CBOR_ERROR_INTERNAL);
+		}
+		if (item->base.count && HT_IS_PACKED(ht) && ht->nTableSize > size) {
+			/* the table grew past the initial size */
+			ctx->u.zv.prealloc += min(ht->nTableSize - ht->nNumUsed, item->base.count - 1);
+		}
 	}
 	Z_TRY_ADDREF_P(value);
 	if (item->base.count && --item->base.count == 0) {
@@ -194,11 +235,15 @@ static bool zv_append_to_map(dec_context *ctx, xzval *value, stack_item_zv *item
 		if (Z_STRLEN(item->v.map.key) >= 1 && Z_STRVAL(item->v.map.key)[0] == '\0') {
 			RETURN_CB_ERROR_B(E_DESC(CBOR_ERROR_UNSUPPORTED_KEY_VALUE, RESERVED_PROP_NAME));
 		}
+		/* stdClass has only dynamic properties; fill the table directly */
+		HashTable *props = Z_OBJ(item->v.map.dest)->properties;
+		assert(props != NULL && GC_REFCOUNT(props) == 1);
 		if (ctx->args.flags & CBOR_MAP_NO_DUP_KEY
-				&& zend_std_has_property(Z_OBJ(item->v.map.dest), Z_STR(item->v.map.key), ZEND_PROPERTY_EXISTS, NULL)) {
+				&& zend_hash_exists(props, Z_STR(item->v.map.key))) {
 			RETURN_CB_ERROR_B(CBOR_ERROR_DUPLICATE_KEY);
 		}
-		zend_std_write_property(Z_OBJ(item->v.map.dest), Z_STR(item->v.map.key), value, NULL);
+		Z_TRY_ADDREF_P(value);
+		zend_hash_update(props, Z_STR(item->v.map.key), value);
 	} else {  /* IS_ARRAY */
 		if (Z_TYPE(item->v.map.key) == IS_LONG) {
 			zend_ulong index = (zend_ulong)Z_LVAL(item->v.map.key);
@@ -213,7 +258,7 @@ static bool zv_append_to_map(dec_context *ctx, xzval *value, stack_item_zv *item
 					&& zend_symtable_exists(Z_ARRVAL(item->v.map.dest), Z_STR(item->v.map.key))) {
 				RETURN_CB_ERROR_B(CBOR_ERROR_DUPLICATE_KEY);
 			}
-			add_assoc_zval_ex(&item->v.map.dest, Z_STRVAL(item->v.map.key), Z_STRLEN(item->v.map.key), value);
+			zend_symtable_update(Z_ARRVAL(item->v.map.dest), Z_STR(item->v.map.key), value);
 		}
 		Z_TRY_ADDREF_P(value);
 	}
@@ -391,8 +436,9 @@ static bool zv_append_string_item(dec_context *ctx, zval *value, bool is_text, b
 		value = &container;
 	}
 	if (!is_indef && item && item->thi_data != THI_NONE) {
-		(*tag_handlers[item->thi_data].h_data)(ctx, item, DATA_TYPE_STRING, value);
+		(*tag_handlers[item->thi_data].h_data)(ctx, item, is_text ? DATA_TYPE_TEXT : DATA_TYPE_BYTE, value);
 	}
+	ctx->u.zv.str_is_text = is_text;
 	result = zv_append(ctx, value);
 	if (!Z_ISNULL(container)) {
 		zval_ptr_dtor_nogc(&container);
@@ -400,6 +446,29 @@ static bool zv_append_string_item(dec_context *ctx, zval *value, bool is_text, b
 	return result;
 }
 
+/* Get the string from the direct-mapped cache, replacing the entry on miss. The hash is precomputed for hash table lookups. */
+static zend_string *zv_get_cached_string(dec_context *ctx, const char *val, size_t length)
+{
+	zend_string **cache = ctx->u.zv.str_cache;
+	zend_ulong h = zend_inline_hash_func(val, length);
+	zend_string *str;
+	if (!cache) {
+		cache = ctx->u.zv.str_cache = ecalloc(STR_CACHE_SIZE, sizeof *cache);
+	}
+	cache += h & (STR_CACHE_SIZE - 1);
+	str = *cache;
+	if (str && ZSTR_H(str) == h && ZSTR_LEN(str) == length && !memcmp(ZSTR_VAL(str), val, length)) {
+		return zend_string_copy(str);
+	}
+	if (str) {
+		zend_string_release(str);
+	}
+	str = zend_string_init(val, length, false);
+	ZSTR_H(str) = h;
+	*cache = str;
+	return zend_string_copy(str);
+}
+
 static void zv_do_xstring(dec_context *ctx, const char *val, uint64_t length, bool is_text)
 {
 	zval value;
@@ -427,7 +496,16 @@ static void zv_do_xstring(dec_context *ctx, const char *val, uint64_t length, bo
 		}
 		RETURN_CB_ERROR(E_DESC(CBOR_ERROR_SYNTAX, INCONSISTENT_STRING_TYPE));
 	}
-	ZVAL_STRINGL_FAST(&value, (const char *)val, (size_t)length);
+	if (ctx->args.string_cache && length > 1 && length <= STR_CACHE_MAX_LEN
+			&& (ctx->args.string_cache == OPT_ALL
+				|| (item != NULL && item->base.si_type == SI_TYPE_MAP && Z_ISUNDEF(item->v.map.key)))) {
+		ZVAL_STR(&value, zv_get_cached_string(ctx, val, (size_t)length));
+	} else {
+		ZVAL_STRINGL_FAST(&value, (const char *)val, (size_t)length);
+	}
+	if (is_text && !(ctx->args.flags & CBOR_UNSAFE_TEXT)) {
+		ZSTR_SET_VALID_UTF8(Z_STR(value));
+	}
 	zv_append_string_item(ctx, &value, is_text, false);
 	zval_ptr_dtor_str(&value);
 }
@@ -452,6 +530,39 @@ static void zv_proc_byte_string_start(dec_context *ctx)
 	zv_stack_push_xstring(ctx, SI_TYPE_BYTE);
 }
 
+/* Append a lazy value in place of the container at the offset if the lazy option applies; the content is skipped without being decoded. */
+static bool zv_do_lazy(dec_context *ctx, uint32_t count)
+{
+	stack_item_zv *item = (stack_item_zv *)ctx->stack_top;
+	cbor_fragment *mem = ctx->mem;
+	cbor_fragment item_mem;
+	cbor_decode_args item_args;
+	size_t head_len;
+	cbor_error error;
+	zval value;
+	if (!ctx->args.lazy || count < ctx->args.lazy
+			|| item == NULL  /* root */
+			|| ctx->data == NULL || ctx->stack_depth >= ctx->args.max_depth
+			|| ctx->args.shared_ref || ctx->u.zv.srns != NULL  /* references may cross the boundary */
+			|| (item->base.si_type == SI_TYPE_MAP && Z_ISUNDEF(item->v.map.key))) {
+		return false;
+	}
+	item_mem = *mem;
+	head_len = 1 + cbor_di_heads[mem->ptr[mem->offset]].arg_len;
+	error = cbor_skip_item(&item_mem, ctx->args.max_depth - ctx->stack_depth);
+	if (error) {
+		mem->offset = item_mem.offset - head_len;  /* the head is consumed by the caller */
+		RETURN_CB_ERROR_V(true, error);
+	}
+	item_args = ctx->args;
+	item_args.max_depth -= ctx->stack_depth;
+	cbor_lazy_value_init(&value, ctx->data, mem->offset, item_mem.offset - mem->offset, count, &item_args);
+	mem->offset = item_mem.offset - head_len;
+	zv_append(ctx, &value);
+	zval_ptr_dtor_nogc(&value);
+	return true;
+}
+
 static void zv_proc_array_start(dec_context *ctx, uint32_t count)
 {
 	zval value;
@@ -461,8 +572,22 @@ static void zv_proc_array_start(dec_context *ctx, uint32_t count)
 	if (ctx->mem->limit && ctx->mem->offset + 1 + count > ctx->mem->limit) {
 		RETURN_CB_ERROR(CBOR_ERROR_TRUNCATED_DATA);
 	}
+	if (zv_do_lazy(ctx, count)) {
+		return;
+	}
 	if (count) {
-		array_init_size(&value, ((count > SIZE_INIT_LIMIT) ? SIZE_INIT_LIMIT : (uint32_t)count));
+		/* count is bound by the remaining data if the limit is known,
+		 * but nested arrays may claim the same data; cap by what is not yet
+		 * claimed by the open arrays so that the total stays bound */
+		uint32_t init_size = min(count, SIZE_INIT_LIMIT);
+		if (ctx->mem->limit) {
+			size_t unclaimed = ctx->mem->limit - ctx->mem->offset;
+			unclaimed = (unclaimed > ctx->u.zv.prealloc) ? unclaimed - ctx->u.zv.prealloc : 0;
+			init_size = (uint32_t)min(unclaimed, (size_t)count);
+		}
+		array_init_size(&value, init_size);
+		zend_hash_real_init_packed(Z_ARRVAL(value));
+		ctx->u.zv.prealloc += min(Z_ARRVAL(value)->nTableSize, count);
 		zv_stack_push_counted(ctx, SI_TYPE_ARRAY, &value, (uint32_t)count);
 	} else {
 		ZVAL_EMPTY_ARRAY(&value);
@@ -487,12 +612,17 @@ static void zv_proc_map_start(dec_context *ctx, uint32_t count)
 	if (ctx->mem->limit && ctx->mem->offset + 1 + count * 2 > ctx->mem->limit) {
 		RETURN_CB_ERROR(CBOR_ERROR_TRUNCATED_DATA);
 	}
+	if (zv_do_lazy(ctx, count)) {
+		return;
+	}
 	if (ctx->args.flags & CBOR_MAP_AS_ARRAY) {
 		if (count) {
 			array_init_size(&value, ((count > SIZE_INIT_LIMIT) ? SIZE_INIT_LIMIT : (uint32_t)count));
 		} else {
 			ZVAL_EMPTY_ARRAY(&value);
 		}
+	} else if (count) {
+		object_and_properties_init(&value, zend_standard_class_def, zend_new_array((count > SIZE_INIT_LIMIT) ? SIZE_INIT_LIMIT : (uint32_t)count));
 	} else {
 		ZVAL_OBJ(&value, zend_objects_new(zend_standard_class_def));
 	}
@@ -510,7 +640,7 @@ static void zv_proc_indef_map_start(dec_context *ctx)
 	if (ctx->args.flags & CBOR_MAP_AS_ARRAY) {
 		array_init(&value);
 	} else {
-		ZVAL_OBJ(&value, zend_objects_new(zend_standard_class_def));
+		object_and_properties_init(&value, zend_standard_class_def, zend_new_array(0));
 	}
 	zv_stack_push_map(ctx, SI_TYPE_MAP, &value, 0);
 }
@@ -602,6 +732,10 @@ static void zv_proc_indef_break(dec_context *ctx, stack_item *item_)
 		bool is_text = item->base.si_type == SI_TYPE_TEXT;
 		zval value;
 		ZVAL_STR(&value, smart_str_extract(&item->v.str));
+		if (is_text && !(ctx->args.flags & CBOR_UNSAFE_TEXT)) {
+			/* every chunk has been validated */
+			ZSTR_SET_VALID_UTF8(Z_STR(value));
+		}
 		zv_append_string_item(ctx, &value, is_text, true);
 		zval_ptr_dtor_str(&value);
 	} else {  /* SI_TYPE_ARRAY, SI_TYPE_MAP, SI_TYPE_TAG, SI_TYPE_TAG_HANDLED */
@@ -617,8 +751,9 @@ FINALLY: ;
 
 static void tag_handler_str_ref_ns_data(dec_context *ctx, stack_item_zv *item, data_type type, zval *value)
 {
-	if (type == DATA_TYPE_STRING) {
-		HashTable *str_table = ctx->u.zv.srns->str_table;
+	if (type == DATA_TYPE_BYTE || type == DATA_TYPE_TEXT) {
+		srns_item *srns = ctx->u.zv.srns;
+		HashTable *str_table = srns->str_table;
 		size_t str_len;
 		if (Z_TYPE_P(value) == IS_STRING) {
 			str_len = Z_STRLEN_P(value);
@@ -634,6 +769,7 @@ static void tag_handler_str_ref_ns_data(dec_context *ctx, stack_item_zv *item, d
 				RETURN_CB_ERROR(CBOR_ERROR_INTERNAL);
 			}
 			Z_ADDREF_P(value);
+			smart_str_appendc(&srns->text_flags, type == DATA_TYPE_TEXT);
 		}
 	}
 }
@@ -659,6 +795,7 @@ static xzval *tag_handler_str_ref_ns_exit(dec_context *ctx, xzval *value, stack_
 static void free_srns_item(srns_item *srns)
 {
 	zend_array_destroy(srns->str_table);
+	smart_str_free(&srns->text_flags);
 	efree(srns);
 }
 
@@ -676,6 +813,7 @@ static bool tag_handler_str_ref_ns_enter(dec_context *ctx, stack_item_zv *item)
 	SI_SET_CHILD_HANDLER(item, THI_STR_REF_NS);
 	item->v.tag_h.v.srns_detached = NULL;
 	srns->str_table = zend_new_array(0);
+	memset(&srns->text_flags, 0, sizeof srns->text_flags);
 	srns->prev_item = ctx->u.zv.srns;
 	ctx->u.zv.srns = srns;
 	return true;
@@ -698,6 +836,8 @@ static xzval *tag_handler_str_ref_exit(dec_context *ctx, xzval *value, stack_ite
 		RETURN_CB_ERROR_V(value, E_DESC(CBOR_ERROR_TAG_VALUE, STR_REF_RANGE));
 	}
 	assert(Z_TYPE_P(value) == IS_LONG);
+	/* the enclosing tag (e.g. date/time) may check the major type of the referenced string */
+	ctx->u.zv.str_is_text = ZSTR_VAL(ctx->u.zv.srns->text_flags.s)[index];
 	if (Z_TYPE_P(str) != IS_OBJECT || GC_REFCOUNT(Z_OBJ_P(str)) == 1) {
 		ZVAL_COPY(tmp_v, str);
 	} else {
@@ -837,6 +977,67 @@ static bool tag_handler_shared_ref_enter(dec_context *ctx, stack_item_zv *item)
 	return true;
 }
 
+static xzval *tag_handler_datetime_exit(dec_context *ctx, xzval *value, stack_item_zv *item, zval *tmp_v)
+{
+	char buf[DATETIME_BUF_SIZE];
+	size_t len;
+	int usec = 0;
+	php_date_obj *date_obj;
+	if (item->v.tag_h.id == CBOR_TAG_DATETIME) {
+		zend_string *str;
+		if (Z_TYPE_P(value) == IS_STRING && ctx->u.zv.str_is_text) {  /* not a byte string */
+			str = zend_string_copy(Z_STR_P(value));
+		} else if (Z_TYPE_P(value) == IS_OBJECT && Z_OBJCE_P(value) == CBOR_CE(text)) {
+			str = cbor_get_xstring_value(value);
+		} else {
+			RETURN_CB_ERROR_V(value, E_DESC(CBOR_ERROR_TAG_TYPE, DATETIME_NOT_TEXT));
+		}
+		len = normalize_datetime(buf, ZSTR_VAL(str), ZSTR_LEN(str));
+		zend_string_release(str);
+		if (!len) {
+			RETURN_CB_ERROR_V(value, E_DESC(CBOR_ERROR_TAG_VALUE, DATETIME_SYNTAX));
+		}
+	} else {
+		zend_long sec;
+		zval d_value;
+		if (XZ_ISXXINT_P(value)) {
+			RETURN_CB_ERROR_V(value, E_DESC(CBOR_ERROR_TAG_VALUE, EPOCH_RANGE));
+		} else if (Z_TYPE_P(value) == IS_LONG) {
+			sec = Z_LVAL_P(value);
+			if (!IS_EPOCH_IN_RANGE(sec)) {
+				RETURN_CB_ERROR_V(value, E_DESC(CBOR_ERROR_TAG_VALUE, EPOCH_RANGE));
+			}
+		} else {
+			if (Z_TYPE_P(value) == IS_DOUBLE) {
+				ZVAL_COPY_VALUE(&d_value, value);
+			} else if (Z_TYPE_P(value) != IS_OBJECT
+					|| (Z_OBJCE_P(value) != CBOR_CE(float16) && Z_OBJCE_P(value) != CBOR_CE(float32))
+					|| Z_OBJ_HT_P(value)->cast_object(Z_OBJ_P(value), &d_value, IS_DOUBLE) != SUCCESS) {
+				RETURN_CB_ERROR_V(value, E_DESC(CBOR_ERROR_TAG_TYPE, EPOCH_NOT_NUM));
+			}
+			if (!split_epoch(Z_DVAL(d_value), &sec, &usec)) {
+				RETURN_CB_ERROR_V(value, E_DESC(CBOR_ERROR_TAG_VALUE, EPOCH_RANGE));
+			}
+		}
+		len = snprintf(buf, sizeof buf, "@" ZEND_LONG_FMT, sec);
+	}
+	php_date_instantiate(php_date_get_immutable_ce(), tmp_v);
+	date_obj = Z_PHPDATE_P(tmp_v);
+	if (!php_date_initialize(date_obj, buf, len, NULL, NULL, 0)) {
+		zval_ptr_dtor(tmp_v);
+		RETURN_CB_ERROR_V(value, CBOR_ERROR_INTERNAL);
+	}
+	if (usec) {
+		date_obj->time->us = usec;
+	}
+	return tmp_v;
+}
+
+static bool tag_handler_datetime_enter(dec_context *ctx, stack_item_zv *item)
+{
+	return true;
+}
+
 static tag_handler_procs tag_handlers[THI_COUNT] = {
 	{
 		NULL,
@@ -858,6 +1059,9 @@ static tag_handler_procs tag_handlers[THI_COUNT] = {
 	}, {
 		&tag_handler_shared_ref_enter,
 		&tag_handler_shared_ref_exit,
+	}, {
+		&tag_handler_datetime_enter,
+		&tag_handler_datetime_exit,
 	},
 };
 
@@ -873,10 +1077,13 @@ static bool zv_do_tag_enter(dec_context *ctx, zend_long tag_id)
 		thi = THI_SHAREABLE;
 	} else if (tag_id == CBOR_TAG_SHARED_REF && ctx->args.shared_ref) {
 		thi = THI_SHARED_REF;
+	} else if ((tag_id == CBOR_TAG_DATETIME || tag_id == CBOR_TAG_EPOCH) && ctx->args.datetime) {
+		thi = THI_DATETIME;
 	}
 	if (thi != THI_NONE) {
 		stack_item_zv *item = stack_new_item(ctx, SI_TYPE_TAG_HANDLED, 1);
 		item->v.tag_h.id = tag_id;
+		item->v.tag_h.thi = THI_NONE;
 		if (!(*tag_handlers[thi].h_enter)(ctx, item)) {
 			ASSERT_ERROR_SET();
 			stack_free_item(ctx, &item->base);
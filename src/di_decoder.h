@@ -8,31 +8,53 @@
 #include <stdint.h>
 #include <stdio.h>
 
+/* decoding instructions for an initial byte */
 typedef struct {
-	size_t read_len;
-	size_t req_len;  /* if returned false and req_len == 0, data is truncated */
-	union cbor_di_decoded_ {
-		uint32_t i32;
-		uint64_t i64;
-		struct {
-			size_t len;
-			const char *val;  /* NULL: indefinite */
-		} str;
-		uint16_t f16;
-		float f32;
-		double f64;
-		struct {
-			uint64_t int_filler;
-			bool is_indef;
-		} ext;
-	} v;
-} cbor_di_decoded;
-
-#define DI_IS_SINGLE(out)  ((out).read_len == 1 + 4)
-#define DI_IS_DOUBLE(out)  ((out).read_len == 1 + 8)
-
-uint8_t cbor_di_get_type(const uint8_t *data, size_t len);
-bool cbor_di_read_int(const uint8_t *data, size_t len, cbor_di_decoded *out);
-bool cbor_di_read_str(const uint8_t *data, size_t len, cbor_di_decoded *out);
-bool cbor_di_read_list(const uint8_t *data, size_t len, cbor_di_decoded *out);
-bool cbor_di_read_float(const uint8_t *data, size_t len, cbor_di_decoded *out);
+	uint8_t type;  /* DI_*, 0: not well-formed */
+	uint8_t arg_len;  /* length of the argument following the initial byte, 0: in the additional info */
+	bool is_indef;
+} cbor_di_head;
+
+extern const cbor_di_head cbor_di_heads[0x100];
+
+#define DI_GET_INFO(ini_byte)  ((ini_byte) & 0x1f)  /* 0b0001_0000 */
+
+#define DI_READ_1(data)  ((data)[1])
+
+#define DI_READ_2(data)  ( \
+		((uint16_t)(data)[1] << 8) \
+		| ((data)[2] << 0) \
+	)
+#define DI_READ_4(data)  ( \
+		((uint32_t)(data)[1] << 24) \
+		| ((uint32_t)(data)[2] << 16) \
+		| ((uint32_t)(data)[3] << 8) \
+		| ((data)[4] << 0) \
+	)
+
+#define DI_READ_8(data)  ( \
+		((uint64_t)(data)[1] << 56) \
+		| ((uint64_t)(data)[2] << 48) \
+		| ((uint64_t)(data)[3] << 40) \
+		| ((uint64_t)(data)[4] << 32) \
+		| ((uint64_t)(data)[5] << 24) \
+		| ((uint64_t)(data)[6] << 16) \
+		| ((uint64_t)(data)[7] << 8) \
+		| ((data)[8] << 0) \
+	)
+
+/* Read the argument of the head; data must have at least 1 + arg_len bytes. */
+static inline uint64_t cbor_di_read_arg(const uint8_t *data, uint8_t arg_len)
+{
+	switch (arg_len) {
+	case 0:
+		return DI_GET_INFO(data[0]);
+	case 1:
+		return DI_READ_1(data);
+	case 2:
+		return DI_READ_2(data);
+	case 4:
+		return DI_READ_4(data);
+	}
+	return DI_READ_8(data);
+}
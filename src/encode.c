@@ -15,21 +15,43 @@
 #include "warn_unmuted.h"
 #include <Zend/zend_interfaces.h>
 #include <Zend/zend_smart_str.h>
+#include <Zend/zend_sort.h>
 #include <assert.h>
 
 #define CTX_TEXT_FLAG(ctx)  (((ctx)->args.e_flags & CBOR_TEXT) != 0)
 
 #define MAKE_ZSTR(ls)  zend_string_init(ZEND_STRL(ls), false)
 
+#define STREAM_CHUNK_SIZE  (64 * 1024)
+#define KEY_CACHE_LIMIT  4096
+#define SRNS_TABLE_INIT_SIZE  16
+#define SHARED_REFS_INIT_SIZE  8
+#define SRNS_MIN_LENGTH  3  /* the least threshold of cbor_is_len_string_ref() */
+
+/* string of the stringref-namespace; hash is 0 for the empty slot */
+typedef struct {
+	zend_string *str;  /* NULL if the string is in the arena */
+	size_t offset;  /* in the arena */
+	size_t length;
+	zend_ulong hash;
+	uint32_t index;
+} srns_entry;
+
+/* open addressing table of the strings */
+typedef struct {
+	srns_entry *slots;
+	uint32_t mask;  /* number of slots - 1 */
+	uint32_t count;
+	smart_str arena;  /* strings given without zend_string */
+} srns_table;
+
 typedef struct {
 	uint32_t next_index;
-	HashTable *str_table[2];
+	srns_table table[2];
 } srns_item;
 
 enum {
 	EXT_STR_ENC_SERIALIZE_FN = 0,
-	EXT_STR_DATE_FORMAT_FN,
-	EXT_STR_DATE_FORMAT,
 	EXT_STR_DEC_ISNAN_FN,
 	EXT_STR_DEC_ISINF_FN,
 	EXT_STR_DEC_ISNEG_FN,
@@ -46,13 +68,27 @@ enum {
 	_EXT_FN_COUNT,
 };
 
+/* values marked as shareable, by the pointer of the counted value */
 typedef struct {
+	zval *values;  /* by the index of the sharedref; kept alive so that the pointers are not reused */
+	uint32_t *slots;  /* open addressing; index + 1 of values, or 0 if empty */
+	uint32_t count, size;  /* of values */
+	uint32_t mask;  /* number of slots - 1 */
+} shared_refs;
+
+typedef struct cbor_encode_context {
 	cbor_encode_args args;
 	uint32_t cur_depth;
 	uint32_t in_enc_params;
 	smart_str *buf;
+	php_stream *stream;  /* flush destination of stream_buf if not NULL */
+	smart_str *stream_buf;
+	size_t written;
 	srns_item *srns; /* string ref namespace */
-	HashTable *refs, *ref_lock; /* shared ref, lock is actually not needed fow now */
+	srns_item *srns_root; /* namespace of the data item, reused for the next item */
+	shared_refs refs;  /* shared ref */
+	/* lookup caches below are kept while the context lives */
+	HashTable *key_cache[4];  /* encoded interned keys by [to_text | use_int_key << 1] */
 	struct enc_ctx_ce {
 		zend_class_entry *date_i;
 		zend_class_entry *gmp;
@@ -63,6 +99,14 @@ typedef struct {
 	zend_string *str[_EXT_STR_COUNT];
 } enc_context;
 
+/* encoded map key in the arena with its value, to be sorted under CDE */
+typedef struct {
+	size_t offset;
+	size_t length;
+	const char *key;  /* set on sorting */
+	zval value;
+} cde_key;
+
 typedef enum {
 	HASH_ARRAY = 0,
 	HASH_OBJ,
@@ -70,6 +114,7 @@ typedef enum {
 } hash_type;
 
 static cbor_error enc_zval(enc_context *ctx, zval *value);
+static cbor_error enc_flush(enc_context *ctx, size_t min_len);
 static void enc_long(enc_context *ctx, zend_long value);
 static void enc_z_double(enc_context *ctx, zval *value);
 static cbor_error enc_string(enc_context *ctx, zend_string *value, bool to_text);
@@ -86,7 +131,9 @@ static cbor_error enc_encodeparams(enc_context *ctx, zval *ins);
 
 static void init_srns_stack(enc_context *ctx);
 static void free_srns_stack(enc_context *ctx);
+static void clean_srns_stack(srns_item *srns);
 static cbor_error enc_string_ref(enc_context *ctx, const char *value, size_t length, zend_string *v_str, bool to_text);
+static void clean_shared_refs(shared_refs *refs);
 static cbor_error enc_ref_counted(enc_context *ctx, zval *value);
 static cbor_error enc_shareable(enc_context *ctx, zval *value);
 static cbor_error enc_datetime(enc_context *ctx, zval *value);
@@ -117,39 +164,157 @@ void cbor_minit_encode()
 		} \
 	} while (0)
 
+static void enc_context_init(enc_context *ctx, const cbor_encode_args *args)
+{
+	memset(ctx, 0, sizeof *ctx);
+	assert(IS_UNDEF == 0);
+	ctx->args = *args;
+}
+
+static void enc_context_free(enc_context *ctx)
+{
+	if (ctx->srns_root) {
+		ctx->srns = ctx->srns_root;
+		free_srns_stack(ctx);
+	}
+	clean_shared_refs(&ctx->refs);
+	if (ctx->refs.values) {
+		efree(ctx->refs.values);
+		efree(ctx->refs.slots);
+	}
+	for (int i = 0; i < 4; i++) {
+		if (ctx->key_cache[i]) {
+			zend_array_destroy(ctx->key_cache[i]);
+		}
+	}
+	for (int i = 0; i < _EXT_STR_COUNT; i++) {
+		if (ctx->str[i]) {
+			zend_string_release(ctx->str[i]);
+		}
+	}
+}
+
+/* Append a data item to buf. The buffer is rolled back on error. */
+/* If stream is given, buf is flushed to the stream and data already written cannot be rolled back. */
+static cbor_error enc_process(enc_context *ctx, zval *value, smart_str *buf, php_stream *stream)
+{
+	cbor_error error;
+	size_t start_len = buf->s ? ZSTR_LEN(buf->s) : 0;
+	memset(&ctx->args.error_args, 0, sizeof ctx->args.error_args);
+	ctx->cur_depth = 0;
+	ctx->in_enc_params = 0;
+	ctx->buf = buf;
+	ctx->stream = stream;
+	ctx->stream_buf = buf;
+	ctx->written = 0;
+	if (!ctx->ce.uri_i) {
+		ctx->ce.date_i = NULL;  /* UriInterface may have been loaded since the last lookup */
+	}
+	if (ctx->args.e_flags & CBOR_SELF_DESCRIBE) {
+		enc_tag_bare(ctx, CBOR_TAG_SELF_DESCRIBE);
+	}
+	if (ctx->args.string_ref == OPT_TRUE) {
+		enc_tag_bare(ctx, CBOR_TAG_STRING_REF_NS);
+		if (!ctx->srns_root) {
+			init_srns_stack(ctx);
+			ctx->srns_root = ctx->srns;
+		}
+		ctx->srns = ctx->srns_root;
+	}
+	error = enc_zval(ctx, value);
+	if (!error && stream) {
+		error = enc_flush(ctx, 0);
+	}
+	if (ctx->srns_root) {
+		clean_srns_stack(ctx->srns_root);
+	}
+	ctx->srns = NULL;
+	clean_shared_refs(&ctx->refs);
+	ctx->stream = NULL;
+	if (error && buf->s) {
+		ZSTR_LEN(buf->s) = stream ? 0 : start_len;
+	}
+	return error;
+}
+
 cbor_error cbor_encode(zval *value, zend_string **data, cbor_encode_args *args)
 {
 	cbor_error error;
 	enc_context ctx;
 	smart_str buf = {0};
-	memset(&ctx, 0, sizeof ctx);
-	assert(IS_UNDEF == 0);
-	ctx.args = *args;
-	ctx.cur_depth = 0;
-	ctx.in_enc_params = 0;
-	ctx.buf = &buf;
-	if (ctx.args.e_flags & CBOR_SELF_DESCRIBE) {
-		enc_tag_bare(&ctx, CBOR_TAG_SELF_DESCRIBE);
-	}
-	if (ctx.args.string_ref == OPT_TRUE) {
-		enc_tag_bare(&ctx, CBOR_TAG_STRING_REF_NS);
-		init_srns_stack(&ctx);
-	}
-	ctx.refs = zend_new_array(0);
-	ctx.ref_lock = zend_new_array(0);
-	error = enc_zval(&ctx, value);
-	free_srns_stack(&ctx);
-	if (ctx.refs) {
-		zend_array_destroy(ctx.refs);
-	}
-	if (ctx.ref_lock) {
-		zend_array_destroy(ctx.ref_lock);
+	enc_context_init(&ctx, args);
+	error = enc_process(&ctx, value, &buf, NULL);
+	enc_context_free(&ctx);
+	if (!error) {
+		*data = smart_str_extract(&buf);
+	} else {
+		args->error_args = ctx.args.error_args;
+		smart_str_free(&buf);
 	}
-	for (int i = 0; i < _EXT_STR_COUNT; i++) {
-		if (ctx.str[i]) {
-			zend_string_release(ctx.str[i]);
-		}
+	return error;
+}
+
+cbor_error cbor_encode_to_stream(zval *value, php_stream *stream, size_t *written, cbor_encode_args *args)
+{
+	cbor_error error;
+	enc_context ctx;
+	smart_str buf = {0};
+	enc_context_init(&ctx, args);
+	error = enc_process(&ctx, value, &buf, stream);
+	enc_context_free(&ctx);
+	*written = ctx.written;
+	if (error) {
+		args->error_args = ctx.args.error_args;
 	}
+	smart_str_free(&buf);
+	return error;
+}
+
+static cbor_error enc_sequence_iterator(enc_context *ctx, zval *values, smart_str *buf)
+{
+	cbor_error error = 0;
+	zend_class_entry *ce = Z_OBJCE_P(values);
+	zend_object_iterator *it = ce->get_iterator(ce, values, 0);
+	ENC_CHECK_EXCEPTION();
+	if (it->funcs->rewind) {
+		(*it->funcs->rewind)(it);
+	}
+	ENC_CHECK_EXCEPTION();
+	while ((*it->funcs->valid)(it) == SUCCESS) {
+		ENC_CHECK_EXCEPTION();
+		zval *value = (*it->funcs->get_current_data)(it);
+		ENC_CHECK_EXCEPTION();
+		ENC_CHECK(enc_process(ctx, value, buf, NULL));
+		(*it->funcs->move_forward)(it);
+		ENC_CHECK_EXCEPTION();
+	}
+	ENC_CHECK_EXCEPTION();
+ENCODED:
+	if (it) {
+		zend_iterator_dtor(it);
+	}
+	return error;
+}
+
+/* Encode each value of an iterable back to back, i.e. CBOR sequence (RFC 8742). */
+cbor_error cbor_encode_sequence(zval *values, zend_string **data, cbor_encode_args *args)
+{
+	cbor_error error = 0;
+	enc_context ctx;
+	smart_str buf = {0};
+	enc_context_init(&ctx, args);
+	if (Z_TYPE_P(values) == IS_ARRAY) {
+		zval *value;
+		ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(values), value) {
+			if ((error = enc_process(&ctx, value, &buf, NULL)) != 0) {
+				break;
+			}
+		} ZEND_HASH_FOREACH_END();
+	} else {
+		assert(Z_TYPE_P(values) == IS_OBJECT);
+		error = enc_sequence_iterator(&ctx, values, &buf);
+	}
+	enc_context_free(&ctx);
 	if (!error) {
 		*data = smart_str_extract(&buf);
 	} else {
@@ -159,6 +324,58 @@ cbor_error cbor_encode(zval *value, zend_string **data, cbor_encode_args *args)
 	return error;
 }
 
+cbor_encode_context *cbor_encode_new(const cbor_encode_args *args)
+{
+	enc_context *ctx = emalloc(sizeof *ctx);
+	enc_context_init(ctx, args);
+	return ctx;
+}
+
+void cbor_encode_delete(cbor_encode_context *ctx)
+{
+	enc_context_free(ctx);
+	efree(ctx);
+}
+
+cbor_error cbor_encode_process(cbor_encode_context *ctx, zval *value, smart_str *buf, cbor_encode_args *args)
+{
+	cbor_error error = enc_process(ctx, value, buf, NULL);
+	if (error) {
+		args->error_args = ctx->args.error_args;
+	}
+	return error;
+}
+
+cbor_error cbor_encode_process_stream(cbor_encode_context *ctx, zval *value, smart_str *buf, php_stream *stream, size_t *written, cbor_encode_args *args)
+{
+	cbor_error error = enc_process(ctx, value, buf, stream);
+	*written = ctx->written;
+	if (error) {
+		args->error_args = ctx->args.error_args;
+	}
+	return error;
+}
+
+/* Write out the stream buffer if it reaches min_len. */
+static cbor_error enc_flush(enc_context *ctx, size_t min_len)
+{
+	smart_str *buf = ctx->buf;
+	size_t len;
+	if (!ctx->stream || buf != ctx->stream_buf || !buf->s) {
+		return 0;  /* not streaming or buffering elsewhere, e.g. keys to sort */
+	}
+	len = ZSTR_LEN(buf->s);
+	if (len < min_len || !len) {
+		return 0;
+	}
+	if (php_stream_write(ctx->stream, ZSTR_VAL(buf->s), len) != (ssize_t)len) {
+		return CBOR_ERROR_IO;
+	}
+	ctx->written += len;
+	ZSTR_LEN(buf->s) = 0;
+	return 0;
+}
+
 static cbor_error enc_zval(enc_context *ctx, zval *value)
 {
 	cbor_error error = 0;
@@ -208,6 +425,12 @@ RETRY:
 			error = enc_tag(ctx, value);
 		} else if (ce == CBOR_CE(shareable)) {
 			error = enc_shareable(ctx, value);
+		} else if (ce == CBOR_CE(lazyvalue)) {
+			/* encoded as the decoded value, not as a Traversable */
+			if ((value = cbor_lazy_value_get(value)) == NULL) {
+				ENC_RESULT(CBOR_ERROR_EXCEPTION);
+			}
+			goto RETRY;
 		} else if (ce == zend_standard_class_def) {
 			if (ctx->args.shared_ref && (Z_REFCOUNT_P(value) > 1 || is_ref || ctx->in_enc_params)) {
 				error = enc_ref_counted(ctx, value);
@@ -275,6 +498,9 @@ RETRY:
 	}
 ENCODED:
 	ctx->cur_depth--;
+	if (ctx->stream && !error) {
+		error = enc_flush(ctx, STREAM_CHUNK_SIZE);
+	}
 	return error;
 }
 
@@ -351,12 +577,26 @@ static cbor_error enc_string_len(enc_context *ctx, const char *value, size_t len
 	}
 	if (to_text) {
 		if (!(ctx->args.e_flags & CBOR_UNSAFE_TEXT)
-				&& !is_utf8((uint8_t *)value, length)) {
-			return CBOR_ERROR_UTF8;
+				&& !(v_str && ZSTR_IS_VALID_UTF8(v_str))) {
+			if (!is_utf8((uint8_t *)value, length)) {
+				return CBOR_ERROR_UTF8;
+			}
+			if (v_str) {
+				ZSTR_SET_VALID_UTF8(v_str);
+			}
 		}
 	}
 	cbor_di_write_int(ctx->buf, to_text ? DI_TSTR : DI_BSTR, length);
-	if (length) {
+	if (length >= STREAM_CHUNK_SIZE && ctx->stream && ctx->buf == ctx->stream_buf) {
+		/* write large string directly */
+		if ((error = enc_flush(ctx, 0)) != 0) {
+			return error;
+		}
+		if (php_stream_write(ctx->stream, value, length) != (ssize_t)length) {
+			return CBOR_ERROR_IO;
+		}
+		ctx->written += length;
+	} else if (length) {
 		char *ptr = smart_str_extend(ctx->buf, length);
 		memcpy(ptr, value, length);
 	}
@@ -417,37 +657,84 @@ static bool convert_string_to_int(zend_string *str, uint64_t *value, bool *is_ne
 	return true;
 }
 
-static int bucket_cmp_key_cde(Bucket *a, Bucket *b)
+static cbor_error enc_str_key(enc_context *ctx, zend_string *key, bool to_text, bool use_int_key)
 {
-	assert(a->key && b->key);
-	return zend_binary_strcmp(ZSTR_VAL(a->key), ZSTR_LEN(a->key), ZSTR_VAL(b->key), ZSTR_LEN(b->key));
+	uint64_t key_int;
+	bool is_negative;
+	if (use_int_key && convert_string_to_int(key, &key_int, &is_negative)) {
+		enc_xint(ctx, key_int, is_negative);
+		return 0;
+	}
+	if (UNEXPECTED(!(ctx->args.e_flags & (CBOR_KEY_BYTE | CBOR_KEY_TEXT)))) {
+		return E_DESC(CBOR_ERROR_INVALID_FLAGS, NO_KEY_STRING_FLAG);
+	}
+	return enc_string(ctx, key, to_text);
 }
 
-static cbor_error enc_cde_map(enc_context *ctx, HashTable *ht)
+/* Copy the encoded interned key from the cache, skipping UTF-8 check and integer conversion. */
+static cbor_error enc_cached_str_key(enc_context *ctx, zend_string *key, bool to_text, bool use_int_key)
 {
-	if (GC_REFCOUNT(ht) > 1) {
-		return CBOR_ERROR_INTERNAL;
+#if ZEND_ULONG_MAX < UINTPTR_MAX
+#error "Unimplemented: maybe use pointer as a binary string key?"
+#endif
+	HashTable **table = &ctx->key_cache[(to_text ? 1 : 0) | (use_int_key ? 2 : 0)];
+	zend_ulong key_index = (zend_ulong)key;
+	zval *cached, new_value;
+	cbor_error error;
+	size_t start;
+	assert(ZSTR_IS_INTERNED(key) && !ctx->srns);
+	if (*table && (cached = zend_hash_index_find(*table, key_index)) != NULL) {
+		smart_str_append(ctx->buf, Z_STR_P(cached));
+		return 0;
+	}
+	if (ZSTR_LEN(key) >= STREAM_CHUNK_SIZE) {
+		return enc_str_key(ctx, key, to_text, use_int_key);  /* may be written to the stream directly */
+	}
+	start = ctx->buf->s ? ZSTR_LEN(ctx->buf->s) : 0;
+	if ((error = enc_str_key(ctx, key, to_text, use_int_key)) != 0) {
+		return error;
+	}
+	if (to_text && ctx->args.e_flags & CBOR_UNSAFE_TEXT) {
+		return 0;  /* not validated */
+	}
+	if (!*table) {
+		*table = zend_new_array(0);
+	} else if (zend_hash_num_elements(*table) >= KEY_CACHE_LIMIT) {
+		return 0;
 	}
-	zend_ulong count = zend_hash_num_elements(ht);
+	ZVAL_STRINGL(&new_value, ZSTR_VAL(ctx->buf->s) + start, ZSTR_LEN(ctx->buf->s) - start);
+	zend_hash_index_add_new(*table, key_index, &new_value);
+	return 0;
+}
+
+static int cde_key_cmp(const void *a_p, const void *b_p)
+{
+	const cde_key *a = (const cde_key *)a_p, *b = (const cde_key *)b_p;
+	return zend_binary_strcmp(a->key, a->length, b->key, b->length);
+}
+
+static void cde_key_swap(void *a_p, void *b_p)
+{
+	cde_key tmp = *(cde_key *)a_p;
+	*(cde_key *)a_p = *(cde_key *)b_p;
+	*(cde_key *)b_p = tmp;
+}
+
+/* Write the map of the encoded keys in the arena, sorted bytewise lexicographically. */
+static cbor_error enc_cde_map(enc_context *ctx, cde_key *keys, uint32_t count, const char *arena)
+{
+	cbor_error error = 0;
 	cbor_di_write_int(ctx->buf, DI_MAP, count);
 	if (!count) {
 		return 0;
 	}
-	cbor_error error = 0;
-	zend_hash_sort(ht, bucket_cmp_key_cde, false);
-	zend_string *key;
-	zval *val;
-	ZEND_HASH_FOREACH_STR_KEY_VAL(ht, key, val) {
-		if (!key) {
-			ENC_RESULT(CBOR_ERROR_INTERNAL);
-		}
-		smart_str_append(ctx->buf, key);
-		ENC_CHECK(enc_zval(ctx, val));
-		count--;
+	for (uint32_t i = 0; i < count; i++) {
+		keys[i].key = arena + keys[i].offset;
 	}
-	ZEND_HASH_FOREACH_END();
-	if (count) {
-		ENC_RESULT(CBOR_ERROR_INTERNAL);
+	zend_sort(keys, count, sizeof *keys, cde_key_cmp, cde_key_swap);
+	for (uint32_t i = 0; i < count; i++) {
+		smart_str_appendl(ctx->buf, keys[i].key, keys[i].length);
+		ENC_CHECK(enc_zval(ctx, &keys[i].value));
 	}
 ENCODED:
 	return error;
@@ -473,10 +760,11 @@ static cbor_error enc_hash(enc_context *ctx, zval *value, hash_type type)
 	}
 	is_list = type == HASH_ARRAY && zend_array_is_list(ht);
 	count = zend_hash_num_elements(ht);
-	smart_str key_buf = {0};
-	HashTable *cde_ht = NULL;
+	smart_str key_buf = {0};  /* arena of the encoded keys */
+	cde_key *cde_keys = NULL;
+	uint32_t cde_count = 0;
 	if (count && ctx->args.e_flags & CBOR_CDE && !is_list) {
-		cde_ht = zend_new_array((uint32_t)max(0, min(SIZE_INIT_LIMIT, count)));
+		cde_keys = safe_emalloc(count, sizeof *cde_keys, 0);
 	} else if (type == HASH_OBJ && count) {  // HASH_OBJ is not anywhere yet
 		is_indef_length = true;
 		cbor_di_write_indef(ctx->buf, is_list ? DI_ARRAY : DI_MAP);
@@ -491,24 +779,21 @@ static cbor_error enc_hash(enc_context *ctx, zval *value, hash_type type)
 		smart_str *out_buf = ctx->buf;
 		ZEND_HASH_FOREACH_KEY_VAL_IND(ht, index, key, val) {
 			if (!is_list) {
-				if (cde_ht) {
+				size_t key_offset = 0;
+				if (cde_keys) {
 					ctx->buf = &key_buf;
+					key_offset = key_buf.s ? ZSTR_LEN(key_buf.s) : 0;
 				}
 				if (key) {
-					uint64_t key_int;
-					bool is_negative;
 					/* check property visibility if it is object and not stdClass */
 					if (type == HASH_OBJ && *ZSTR_VAL(key) == '\0' && ZSTR_LEN(key) > 0) {
 						ctx->buf = out_buf;
 						continue; /* skip if not a public property */
 					}
-					if (use_int_key && convert_string_to_int(key, &key_int, &is_negative)) {
-						enc_xint(ctx, key_int, is_negative);
-						error = 0;
-					} else if (UNEXPECTED(key_flag_error)) {
-						error = E_DESC(CBOR_ERROR_INVALID_FLAGS, NO_KEY_STRING_FLAG);
+					if (ZSTR_IS_INTERNED(key) && !ctx->srns && (to_text || use_int_key) && !key_flag_error) {
+						error = enc_cached_str_key(ctx, key, to_text, use_int_key);
 					} else {
-						error = enc_string(ctx, key, to_text);
+						error = enc_str_key(ctx, key, to_text, use_int_key);
 					}
 				} else if (!use_int_key) {
 					char num_str[ZEND_LTOA_BUF_LEN];
@@ -522,20 +807,21 @@ static cbor_error enc_hash(enc_context *ctx, zval *value, hash_type type)
 					enc_long(ctx, (zend_long)index);
 					error = 0;
 				}
-				if (cde_ht) {
-					zend_string *key_cbor = smart_str_extract(&key_buf);
+				if (cde_keys) {
 					ctx->buf = out_buf;
 					if (EXPECTED(!error)) {
-						Z_TRY_ADDREF_P(val);
-						zend_hash_add_new(cde_ht, key_cbor, val);
+						/* the value is copied as encoding values may modify the hash */
+						cde_key *entry = &cde_keys[cde_count++];
+						entry->offset = key_offset;
+						entry->length = ZSTR_LEN(key_buf.s) - key_offset;
+						ZVAL_COPY(&entry->value, val);
 					}
-					zend_string_release(key_cbor);
 				}
 			}
 			if (UNEXPECTED(error)) {
 				break;
 			}
-			if (!cde_ht) {
+			if (!cde_keys) {
 				if ((error = enc_zval(ctx, val)) != 0) {
 					break;
 				}
@@ -551,11 +837,15 @@ static cbor_error enc_hash(enc_context *ctx, zval *value, hash_type type)
 	if (type != HASH_ARRAY) {
 		zend_release_properties(ht);
 	}
-	if (cde_ht) {
+	if (cde_keys) {
 		if (!error) {
-			error = enc_cde_map(ctx, cde_ht);
+			error = enc_cde_map(ctx, cde_keys, cde_count, key_buf.s ? ZSTR_VAL(key_buf.s) : NULL);
+		}
+		for (uint32_t i = 0; i < cde_count; i++) {
+			zval_ptr_dtor(&cde_keys[i].value);
 		}
-		zend_array_destroy(cde_ht);
+		efree(cde_keys);
+		smart_str_free(&key_buf);
 	} else if (is_indef_length) {
 		cbor_di_write_break(ctx->buf);
 	}
@@ -861,83 +1151,210 @@ ENCODED:
 
 static void init_srns_stack(enc_context *ctx)
 {
-	srns_item *srns = (srns_item *)emalloc(sizeof *srns);
+	srns_item *srns = (srns_item *)ecalloc(1, sizeof *srns);
 	ctx->srns = srns;
-	srns->next_index = 0;
-	srns->str_table[0] = zend_new_array(0);
-	srns->str_table[1] = zend_new_array(0);
+}
+
+static void clean_srns_table(srns_table *table)
+{
+	if (!table->count) {
+		return;
+	}
+	for (uint32_t i = 0; i <= table->mask; i++) {
+		if (table->slots[i].str) {
+			zend_string_release(table->slots[i].str);
+		}
+	}
+	memset(table->slots, 0, sizeof *table->slots * (table->mask + 1));
+	table->count = 0;
+	if (table->arena.s) {
+		ZSTR_LEN(table->arena.s) = 0;
+	}
 }
 
 static void free_srns_stack(enc_context *ctx)
 {
 	srns_item *srns = ctx->srns;
 	if (srns) {
-		zend_array_release(srns->str_table[0]);
-		zend_array_release(srns->str_table[1]);
+		for (int i = 0; i < 2; i++) {
+			clean_srns_table(&srns->table[i]);
+			if (srns->table[i].slots) {
+				efree(srns->table[i].slots);
+			}
+			smart_str_free(&srns->table[i].arena);
+		}
 		efree(srns);
 	}
 }
 
+static void clean_srns_stack(srns_item *srns)
+{
+	srns->next_index = 0;
+	clean_srns_table(&srns->table[0]);
+	clean_srns_table(&srns->table[1]);
+}
+
+#define SRNS_ENTRY_STR(table, entry)  ((entry)->str ? ZSTR_VAL((entry)->str) : ZSTR_VAL((table)->arena.s) + (entry)->offset)
+
+/* Return the slot of the string, or the empty slot to put it in. */
+static srns_entry *srns_lookup(srns_table *table, const char *value, size_t length, zend_string *v_str, zend_ulong hash)
+{
+	uint32_t i = (uint32_t)hash & table->mask;
+	for (;;) {
+		srns_entry *entry = &table->slots[i];
+		if (!entry->hash) {
+			return entry;
+		}
+		if (entry->hash == hash && entry->length == length
+				&& ((v_str && entry->str == v_str) || !memcmp(SRNS_ENTRY_STR(table, entry), value, length))) {
+			return entry;
+		}
+		i = (i + 1) & table->mask;
+	}
+}
+
+static void srns_grow(srns_table *table)
+{
+	srns_entry *old_slots = table->slots;
+	uint32_t old_size = old_slots ? table->mask + 1 : 0;
+	uint32_t size = old_size ? old_size * 2 : SRNS_TABLE_INIT_SIZE;
+	table->slots = safe_emalloc(size, sizeof *table->slots, 0);
+	memset(table->slots, 0, sizeof *table->slots * size);
+	table->mask = size - 1;
+	for (uint32_t i = 0; i < old_size; i++) {
+		srns_entry *entry = &old_slots[i];
+		if (entry->hash) {
+			uint32_t j = (uint32_t)entry->hash & table->mask;
+			while (table->slots[j].hash) {
+				j = (j + 1) & table->mask;
+			}
+			table->slots[j] = *entry;
+		}
+	}
+	if (old_slots) {
+		efree(old_slots);
+	}
+}
+
 static cbor_error enc_string_ref(enc_context *ctx, const char *value, size_t length, zend_string *v_str, bool to_text)
 {
-	cbor_error error = 0;
 	srns_item *srns = ctx->srns;
-	HashTable *str_table;
-	int table_index;
-	zval new_index, *str_index;
-	bool created = false;
+	srns_table *table;
+	srns_entry *entry;
+	zend_ulong hash;
+	bool can_add;
 	assert(ctx->srns);
-	table_index = to_text ? 1 : 0;
-	if (!v_str) {
-		v_str = zend_string_init_fast(value, length);
-		created = true;
-	}
-	str_table = srns->str_table[table_index];
-	str_index = zend_hash_find(str_table, v_str);
-	if (str_index) {
-		enc_tag_bare(ctx, CBOR_TAG_STRING_REF);
-		enc_long(ctx, Z_LVAL_P(str_index));
-		goto ENCODED;
+	if (length < SRNS_MIN_LENGTH) {
+		return CBOR_STATUS_VALUE_FOLLOWS;
+	}
+	table = &srns->table[to_text ? 1 : 0];
+	can_add = cbor_is_len_string_ref(length, srns->next_index);
+	if (!can_add && !table->count) {
+		return CBOR_STATUS_VALUE_FOLLOWS;
+	}
+	hash = v_str ? ZSTR_HASH(v_str) : zend_hash_func(value, length);
+	if (table->count) {
+		entry = srns_lookup(table, value, length, v_str, hash);
+		if (entry->hash) {
+			enc_tag_bare(ctx, CBOR_TAG_STRING_REF);
+			enc_long(ctx, entry->index);
+			return 0;
+		}
 	}
-	if (!cbor_is_len_string_ref(length, srns->next_index)) {
-		ENC_RESULT(CBOR_STATUS_VALUE_FOLLOWS);
+	if (!can_add) {
+		return CBOR_STATUS_VALUE_FOLLOWS;
 	}
 	if (!(~srns->next_index)) {  /* until max - 1 for simplicity */
-		ENC_RESULT(CBOR_ERROR_INTERNAL);
+		return CBOR_ERROR_INTERNAL;
 	}
-	ZVAL_LONG(&new_index, srns->next_index);
-	srns->next_index++;
-	if (!zend_hash_add_new(str_table, v_str, &new_index)) {
-		ENC_RESULT(CBOR_ERROR_INTERNAL);
+	if (!table->slots || (table->count + 1) * 2 > table->mask + 1) {
+		srns_grow(table);
 	}
-	error = CBOR_STATUS_VALUE_FOLLOWS;
-ENCODED:
-	if (created) {
-		zend_string_release(v_str);
+	entry = srns_lookup(table, value, length, v_str, hash);
+	assert(!entry->hash);
+	entry->hash = hash;
+	entry->length = length;
+	entry->index = srns->next_index++;
+	if (v_str) {
+		entry->str = zend_string_copy(v_str);
+	} else {
+		entry->offset = table->arena.s ? ZSTR_LEN(table->arena.s) : 0;
+		smart_str_appendl(&table->arena, value, length);
+	}
+	table->count++;
+	return CBOR_STATUS_VALUE_FOLLOWS;
+}
+
+static void clean_shared_refs(shared_refs *refs)
+{
+	if (!refs->count) {
+		return;
+	}
+	for (uint32_t i = 0; i < refs->count; i++) {
+		zval_ptr_dtor(&refs->values[i]);
+	}
+	memset(refs->slots, 0, sizeof *refs->slots * (refs->mask + 1));
+	refs->count = 0;
+}
+
+static uint32_t shared_refs_hash(const zend_refcounted *counted)
+{
+	return (uint32_t)(((uint64_t)(uintptr_t)counted * UINT64_C(0x9e3779b97f4a7c15)) >> 32);
+}
+
+/* Return the slot of the counted value, or the empty slot to put it in. */
+static uint32_t *shared_refs_lookup(shared_refs *refs, const zend_refcounted *counted)
+{
+	uint32_t i = shared_refs_hash(counted) & refs->mask;
+	for (;;) {
+		uint32_t *slot = &refs->slots[i];
+		if (!*slot || Z_COUNTED(refs->values[*slot - 1]) == counted) {
+			return slot;
+		}
+		i = (i + 1) & refs->mask;
+	}
+}
+
+static void shared_refs_grow(shared_refs *refs)
+{
+	uint32_t size = refs->size ? refs->size * 2 : SHARED_REFS_INIT_SIZE;
+	refs->values = safe_erealloc(refs->values, size, sizeof *refs->values, 0);
+	refs->size = size;
+	/* keep the load factor of the slots at most 1/2 */
+	if (refs->slots) {
+		efree(refs->slots);
+	}
+	refs->slots = safe_emalloc(size, 2 * sizeof *refs->slots, 0);
+	memset(refs->slots, 0, sizeof *refs->slots * size * 2);
+	refs->mask = size * 2 - 1;
+	for (uint32_t i = 0; i < refs->count; i++) {
+		*shared_refs_lookup(refs, Z_COUNTED(refs->values[i])) = i + 1;
 	}
-	return error;
 }
 
 static cbor_error enc_ref_counted(enc_context *ctx, zval *value)
 {
-#if ZEND_ULONG_MAX < UINTPTR_MAX
-#error "Unimplemented: maybe use pointer as a binary string key?"
-#endif
+	shared_refs *refs = &ctx->refs;
+	uint32_t *slot;
 	assert(!(ctx->args.e_flags & CBOR_CDE));
-	zend_ulong key_index = (zend_ulong)Z_COUNTED_P(value);
-	zval new_index, *ref_index;
 	assert(Z_REFCOUNTED_P(value));
-	if ((ref_index = zend_hash_index_find(ctx->refs, key_index)) != NULL) {
-		enc_tag_bare(ctx, CBOR_TAG_SHARED_REF);
-		enc_long(ctx, Z_LVAL_P(ref_index));
-		return 0;
+	if (refs->count) {
+		slot = shared_refs_lookup(refs, Z_COUNTED_P(value));
+		if (*slot) {
+			enc_tag_bare(ctx, CBOR_TAG_SHARED_REF);
+			enc_long(ctx, *slot - 1);
+			return 0;
+		}
 	}
-	ZVAL_LONG(&new_index, zend_hash_num_elements(ctx->refs));
-	if (!zend_hash_index_add_new(ctx->refs, key_index, &new_index)
-			|| !zend_hash_next_index_insert_new(ctx->ref_lock, value)) {
-		return CBOR_ERROR_INTERNAL;
+	if (refs->count >= refs->size) {
+		if (refs->size >= UINT32_MAX / 4) {
+			return CBOR_ERROR_INTERNAL;
+		}
+		shared_refs_grow(refs);
 	}
-	Z_TRY_ADDREF_P(value);
+	slot = shared_refs_lookup(refs, Z_COUNTED_P(value));
+	ZVAL_COPY(&refs->values[refs->count], value);
+	*slot = ++refs->count;
 	enc_tag_bare(ctx, CBOR_TAG_SHAREABLE);
 	return CBOR_STATUS_VALUE_FOLLOWS;
 }
@@ -970,58 +1387,87 @@ static zend_result call_fn(zval *object, zend_string *func_str, zval *retval_ptr
 	return call_user_function(NULL, object, &func_name, retval_ptr, param_count, params);
 }
 
-static cbor_error enc_datetime(enc_context *ctx, zval *value)
+static char *put_digits(char *ptr, uint32_t value, int width)
 {
-	cbor_error error;
-	zval r_value;
-	zval params[1];
-	zend_string *r_str;
-	size_t i, len;
-	if (!ctx->str[EXT_STR_DATE_FORMAT_FN]) {
-		ctx->str[EXT_STR_DATE_FORMAT_FN] = MAKE_ZSTR("format");
-		ctx->str[EXT_STR_DATE_FORMAT] = MAKE_ZSTR("Y-m-d\\TH:i:s.uP");
-	}
-	ZVAL_NEW_STR(&params[0], ctx->str[EXT_STR_DATE_FORMAT]);
-	if (call_fn(value, ctx->str[EXT_STR_DATE_FORMAT_FN], &r_value, 1, params) != SUCCESS) {
-		return CBOR_ERROR_INTERNAL;
+	for (int i = width - 1; i >= 0; i--) {
+		ptr[i] = '0' + value % 10;
+		value /= 10;
 	}
-	r_str = Z_STR(r_value);
+	return ptr + width;
+}
+
+static cbor_error enc_datetime(enc_context *ctx, zval *value)
+{
+	timelib_time *t = Z_PHPDATE_P(value)->time;
 	/* 0         1         2         3   */
 	/* 012345678901234567890123456789012 */
 	/* 2001-02-03T04:05:06.000007+08:09  */
-	len = 32;
-	if (ZSTR_LEN(r_str) != len) {
-		ENC_RESULT(CBOR_ERROR_INTERNAL);
+	char buf[32];
+	char *ptr = buf;
+	size_t len;
+	int offset;
+	if (!t) {
+		zend_throw_error(NULL, "The DateTimeInterface object has not been correctly initialized by its constructor");
+		return CBOR_ERROR_EXCEPTION;
 	}
-	r_str = zend_string_separate(r_str, false);
-	/* remove redundant fractional zeros */
-	for (i = 25; ; i--) {
-		assert(i >= 19);
-		if (ZSTR_VAL(r_str)[i] != '0') {
-			if (ZSTR_VAL(r_str)[i] != '.') {
-				i++;
-			}
-			break;
+	if (ctx->args.datetime == OPT_EPOCH) {
+		enc_tag_bare(ctx, CBOR_TAG_EPOCH);
+		if (t->us == 0) {
+			enc_xint(ctx, t->sse >= 0 ? (uint64_t)t->sse : (uint64_t)-(t->sse + 1), t->sse < 0);
+		} else {
+			zval d_value;
+			ZVAL_DOUBLE(&d_value, (double)t->sse + (double)t->us / 1000000);
+			enc_z_double(ctx, &d_value);
 		}
+		return 0;
 	}
-	if (i < 26) {
-		memmove(&ZSTR_VAL(r_str)[i], &ZSTR_VAL(r_str)[26], len - 26);
-		len -= 26 - i;
-	}
-	if (memcmp(&ZSTR_VAL(r_str)[len - 6], "+00:00", 6) == 0) {
-		/* convert +00:00 to Z */
-		len -= 5;
-		ZSTR_VAL(r_str)[len - 1] = 'Z';
+	if (t->y < 0 || t->y > 9999) {
+		return CBOR_ERROR_UNSUPPORTED_VALUE;
+	}
+	ptr = put_digits(ptr, (uint32_t)t->y, 4);
+	*ptr++ = '-';
+	ptr = put_digits(ptr, (uint32_t)t->m, 2);
+	*ptr++ = '-';
+	ptr = put_digits(ptr, (uint32_t)t->d, 2);
+	*ptr++ = 'T';
+	ptr = put_digits(ptr, (uint32_t)t->h, 2);
+	*ptr++ = ':';
+	ptr = put_digits(ptr, (uint32_t)t->i, 2);
+	*ptr++ = ':';
+	ptr = put_digits(ptr, (uint32_t)t->s, 2);
+	if (t->us) {
+		*ptr++ = '.';
+		ptr = put_digits(ptr, (uint32_t)t->us, 6);
+		while (ptr[-1] == '0') {  /* remove redundant fractional zeros */
+			ptr--;
+		}
 	}
-	if (len != 32) {
-		ZSTR_VAL(r_str)[len] = '\0';
-		r_str = zend_string_truncate(r_str, len, false);
+	if (!t->is_localtime) {
+		offset = 0;
+	} else if (t->zone_type == TIMELIB_ZONETYPE_ABBR) {
+		offset = t->z + t->dst * 3600;
+	} else {
+		/* TIMELIB_ZONETYPE_ID keeps the offset of the instant including DST */
+		offset = t->z;
 	}
+	if (offset == 0) {
+		*ptr++ = 'Z';
+	} else {
+		*ptr++ = offset < 0 ? '-' : '+';
+		offset = offset < 0 ? -offset : offset;
+		ptr = put_digits(ptr, (uint32_t)(offset / 3600) % 100, 2);
+		*ptr++ = ':';
+		ptr = put_digits(ptr, (uint32_t)(offset % 3600) / 60, 2);
+	}
+	len = ptr - buf;
+	assert(len <= sizeof buf);
 	enc_tag_bare(ctx, CBOR_TAG_DATETIME);
-	error = enc_string(ctx, r_str, true);
-ENCODED:
-	zend_string_release(r_str);
-	return error;
+	if (ctx->srns) {
+		return enc_string_len(ctx, buf, len, NULL, true);
+	}
+	cbor_di_write_int(ctx->buf, DI_TSTR, len);
+	memcpy(smart_str_extend(ctx->buf, len), buf, len);
+	return 0;
 }
 
 static cbor_error enc_bignum(enc_context *ctx, zval *value)
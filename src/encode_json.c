@@ -0,0 +1,691 @@
+/**
+ * @author SATO Kentaro
+ * @license BSD-2-Clause
+ */
+
+#include "cbor.h"
+#include "codec.h"
+#include "di_encoder.h"
+#include "tags.h"
+#include "types.h"
+#include "utf8.h"
+#include <Zend/zend_smart_str.h>
+#include <Zend/zend_sort.h>
+#include <Zend/zend_strtod.h>
+#include <assert.h>
+
+#define PAIR_STACK_INIT_SIZE  16
+
+#define IS_WS(c)  ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+#define IS_DIGIT(c)  ((c) >= '0' && (c) <= '9')
+
+/* key/value pair of the map being written */
+typedef struct {
+	size_t offset;  /* of the key in the buffer */
+	size_t key_len;
+	size_t len;  /* of the key and the value */
+	zend_long str_index;  /* of the key in the stringref table, or -1 */
+	const char *key;  /* set on sorting; NULL if dropped as a duplicate */
+	size_t value_offset, value_len;  /* of the value taken on duplicate keys */
+} json_pair;
+
+typedef struct {
+	cbor_encode_args args;
+	const char *ptr, *start, *end;
+	smart_str *buf;
+	smart_str str_buf;  /* unescaped string */
+	uint32_t cur_depth;
+	/* string ref */
+	HashTable *str_table[2];
+	uint32_t next_index;
+	zend_long str_index;  /* of the last string written, or -1 */
+	/* keys of the maps */
+	json_pair *pairs;
+	size_t pair_count, pair_size;
+	smart_str sort_buf;
+} json_context;
+
+static cbor_error json_value(json_context *ctx);
+
+static void skip_ws(json_context *ctx)
+{
+	const char *ptr = ctx->ptr;
+	while (ptr < ctx->end && IS_WS(*ptr)) {
+		ptr++;
+	}
+	ctx->ptr = ptr;
+}
+
+/* Return the error of the unexpected character, or the end of the text. */
+static cbor_error unexpected(json_context *ctx)
+{
+	return ctx->ptr < ctx->end ? CBOR_ERROR_SYNTAX : CBOR_ERROR_TRUNCATED_DATA;
+}
+
+static size_t head_len(uint64_t val)
+{
+	return val <= DI_INFO_INT0_MAX ? 1 : val <= 0xff ? 2 : val <= 0xffff ? 3 : val <= 0xffffffff ? 5 : 9;
+}
+
+/* Replace the 1-byte placeholder at the offset with the head of the container ending at the end of the buffer. */
+static void write_head(json_context *ctx, size_t offset, uint8_t di_type, uint64_t count)
+{
+	smart_str *buf = ctx->buf;
+	size_t end = ZSTR_LEN(buf->s);
+	size_t len = head_len(count);
+	if (len > 1) {
+		smart_str_extend(buf, len - 1);
+		memmove(ZSTR_VAL(buf->s) + offset + len, ZSTR_VAL(buf->s) + offset + 1, end - offset - 1);
+	}
+	/* rewrite in place; the buffer is not reallocated as it has the room already */
+	ZSTR_LEN(buf->s) = offset;
+	cbor_di_write_int(buf, di_type, count);
+	ZSTR_LEN(buf->s) = end + len - 1;
+}
+
+static void write_double(json_context *ctx, double value)
+{
+	int float_type = ctx->args.e_flags & (CBOR_FLOAT16 | CBOR_FLOAT32);
+	if (float_type == (CBOR_FLOAT16 | CBOR_FLOAT32)) {
+		int size = test_fp64_size(value);
+		if (size == 2) {
+			float_type = CBOR_FLOAT16;
+		} else if (size == 4) {
+			float_type = CBOR_FLOAT32;
+		}
+	}
+	if (float_type == CBOR_FLOAT16) {
+		cbor_di_write_float16(ctx->buf, cbor_float_64_to_16(value));
+	} else if (float_type == CBOR_FLOAT32) {
+		cbor_di_write_float32(ctx->buf, cbor_to_fp32(value));
+	} else {
+		cbor_di_write_float64(ctx->buf, value);
+	}
+}
+
+static cbor_error json_number(json_context *ctx)
+{
+	const char *ptr = ctx->ptr, *end = ctx->end;
+	const char *num_start = ptr;
+	bool is_negative = *ptr == '-';
+	bool is_int = true;
+	if (is_negative) {
+		ptr++;
+	}
+	ctx->ptr = ptr;
+	if (ptr >= end) {
+		return CBOR_ERROR_TRUNCATED_DATA;
+	}
+	if (*ptr == '0') {
+		ptr++;
+	} else if (IS_DIGIT(*ptr)) {
+		while (ptr < end && IS_DIGIT(*ptr)) {
+			ptr++;
+		}
+	} else {
+		return CBOR_ERROR_SYNTAX;
+	}
+	const char *int_end = ptr;
+	if (ptr < end && *ptr == '.') {
+		is_int = false;
+		ctx->ptr = ++ptr;
+		if (ptr >= end || !IS_DIGIT(*ptr)) {
+			return unexpected(ctx);
+		}
+		while (ptr < end && IS_DIGIT(*ptr)) {
+			ptr++;
+		}
+	}
+	if (ptr < end && (*ptr == 'e' || *ptr == 'E')) {
+		is_int = false;
+		ptr++;
+		if (ptr < end && (*ptr == '+' || *ptr == '-')) {
+			ptr++;
+		}
+		ctx->ptr = ptr;
+		if (ptr >= end || !IS_DIGIT(*ptr)) {
+			return unexpected(ctx);
+		}
+		while (ptr < end && IS_DIGIT(*ptr)) {
+			ptr++;
+		}
+	}
+	ctx->ptr = ptr;
+	if (is_int) {
+		/* decimal string to uint64_t; integers out of the CBOR range are written as float */
+		const char *digit = num_start + is_negative;
+		uint64_t value = 0;
+		for (; digit < int_end; digit++) {
+			int ch_dec = *digit - '0';
+			if (value > (UINT64_C(0xffffffffffffffff) - ch_dec) / 10) {
+				break;
+			}
+			value = value * 10 + ch_dec;
+		}
+		if (digit == int_end) {
+			if (!is_negative || !value) {
+				cbor_di_write_int(ctx->buf, DI_UINT, value);
+				return 0;
+			}
+			cbor_di_write_int(ctx->buf, DI_NINT, value - 1);
+			return 0;
+		}
+		if (is_negative && digit + 1 == int_end && !memcmp(num_start, "-18446744073709551616", sizeof "-18446744073709551616" - 1)) {
+			cbor_di_write_int(ctx->buf, DI_NINT, UINT64_C(0xffffffffffffffff));
+			return 0;
+		}
+	}
+	write_double(ctx, zend_strtod(num_start, NULL));
+	return 0;
+}
+
+static bool read_hex4(const char *ptr, uint32_t *value)
+{
+	uint32_t cp = 0;
+	for (int i = 0; i < 4; i++) {
+		char c = ptr[i];
+		cp <<= 4;
+		if (IS_DIGIT(c)) {
+			cp |= c - '0';
+		} else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+			cp |= (c | 0x20) - 'a' + 10;
+		} else {
+			return false;
+		}
+	}
+	*value = cp;
+	return true;
+}
+
+static void append_utf8(smart_str *buf, uint32_t cp)
+{
+	if (cp < 0x80) {
+		smart_str_appendc(buf, (char)cp);
+	} else if (cp < 0x800) {
+		char *ptr = smart_str_extend(buf, 2);
+		*ptr++ = (char)(0xc0 | (cp >> 6));
+		*ptr++ = (char)(0x80 | (cp & 0x3f));
+	} else if (cp < 0x10000) {
+		char *ptr = smart_str_extend(buf, 3);
+		*ptr++ = (char)(0xe0 | (cp >> 12));
+		*ptr++ = (char)(0x80 | ((cp >> 6) & 0x3f));
+		*ptr++ = (char)(0x80 | (cp & 0x3f));
+	} else {
+		char *ptr = smart_str_extend(buf, 4);
+		*ptr++ = (char)(0xf0 | (cp >> 18));
+		*ptr++ = (char)(0x80 | ((cp >> 12) & 0x3f));
+		*ptr++ = (char)(0x80 | ((cp >> 6) & 0x3f));
+		*ptr++ = (char)(0x80 | (cp & 0x3f));
+	}
+}
+
+/* Unescape the rest of the string into str_buf; ptr is at the first backslash. */
+static cbor_error unescape_string(json_context *ctx, const char *ptr)
+{
+	const char *end = ctx->end;
+	smart_str *buf = &ctx->str_buf;
+	for (;;) {
+		const char *chunk = ptr;
+		while (ptr < end && *ptr != '"' && *ptr != '\\' && (uint8_t)*ptr >= 0x20) {
+			ptr++;
+		}
+		smart_str_appendl(buf, chunk, ptr - chunk);
+		ctx->ptr = ptr;
+		if (ptr >= end) {
+			return CBOR_ERROR_TRUNCATED_DATA;
+		}
+		if (*ptr == '"') {
+			ctx->ptr = ptr + 1;
+			return 0;
+		}
+		if (*ptr != '\\') {
+			return CBOR_ERROR_SYNTAX;  /* control character */
+		}
+		if (++ptr >= end) {
+			return CBOR_ERROR_TRUNCATED_DATA;
+		}
+		char c;
+		switch (*ptr++) {
+		case '"': c = '"'; break;
+		case '\\': c = '\\'; break;
+		case '/': c = '/'; break;
+		case 'b': c = '\b'; break;
+		case 'f': c = '\f'; break;
+		case 'n': c = '\n'; break;
+		case 'r': c = '\r'; break;
+		case 't': c = '\t'; break;
+		case 'u': {
+			uint32_t cp, cp_low;
+			if (end - ptr < 4) {
+				return CBOR_ERROR_TRUNCATED_DATA;
+			}
+			if (!read_hex4(ptr, &cp)) {
+				return CBOR_ERROR_SYNTAX;
+			}
+			ptr += 4;
+			if (cp >= 0xdc00 && cp <= 0xdfff) {
+				return CBOR_ERROR_UTF8;  /* lone low surrogate */
+			}
+			if (cp >= 0xd800 && cp <= 0xdbff) {
+				ctx->ptr = ptr;
+				if (end - ptr < 6 || ptr[0] != '\\' || ptr[1] != 'u'
+						|| !read_hex4(ptr + 2, &cp_low) || cp_low < 0xdc00 || cp_low > 0xdfff) {
+					return CBOR_ERROR_UTF8;
+				}
+				ptr += 6;
+				cp = 0x10000 + ((cp - 0xd800) << 10) + (cp_low - 0xdc00);
+			}
+			append_utf8(buf, cp);
+			continue;
+		}
+		default:
+			ctx->ptr = ptr - 1;
+			return CBOR_ERROR_SYNTAX;
+		}
+		smart_str_appendc(buf, c);
+	}
+}
+
+/* Write the string as a stringref if it has been seen, or register it if it is long enough. */
+static cbor_error write_string_ref(json_context *ctx, const char *value, size_t length, bool to_text)
+{
+	HashTable *str_table = ctx->str_table[to_text ? 1 : 0];
+	zval new_index, *str_index;
+	str_index = zend_hash_str_find(str_table, value, length);
+	if (str_index) {
+		ctx->str_index = Z_LVAL_P(str_index);
+		cbor_di_write_int(ctx->buf, DI_TAG, CBOR_TAG_STRING_REF);
+		cbor_di_write_int(ctx->buf, DI_UINT, Z_LVAL_P(str_index));
+		return 0;
+	}
+	if (!cbor_is_len_string_ref(length, ctx->next_index)) {
+		return CBOR_STATUS_VALUE_FOLLOWS;
+	}
+	if (!(~ctx->next_index)) {  /* until max - 1 for simplicity */
+		return CBOR_ERROR_INTERNAL;
+	}
+	ZVAL_LONG(&new_index, ctx->next_index);
+	ctx->str_index = ctx->next_index++;
+	zend_hash_str_add_new(str_table, value, length, &new_index);
+	return CBOR_STATUS_VALUE_FOLLOWS;
+}
+
+static cbor_error json_string(json_context *ctx, bool to_text)
+{
+	cbor_error error;
+	const char *ptr = ++ctx->ptr, *end = ctx->end;
+	const char *str_start = ptr;
+	const char *value = ptr;
+	size_t length;
+	/* the string without escapes is written from the text as is */
+	while (ptr < end && *ptr != '"' && *ptr != '\\' && (uint8_t)*ptr >= 0x20) {
+		ptr++;
+	}
+	if (ptr < end && *ptr == '"') {
+		length = ptr - value;
+		ctx->ptr = ptr + 1;
+	} else {
+		if (ctx->str_buf.s) {
+			ZSTR_LEN(ctx->str_buf.s) = 0;
+		}
+		smart_str_appendl(&ctx->str_buf, value, ptr - value);
+		if ((error = unescape_string(ctx, ptr)) != 0) {
+			return error;
+		}
+		smart_str_0(&ctx->str_buf);
+		value = ZSTR_VAL(ctx->str_buf.s);
+		length = ZSTR_LEN(ctx->str_buf.s);
+	}
+	ctx->str_index = -1;
+	if (ctx->str_table[0]) {
+		error = write_string_ref(ctx, value, length, to_text);
+		if (error != CBOR_STATUS_VALUE_FOLLOWS) {
+			return error;
+		}
+	}
+	if (to_text && !(ctx->args.e_flags & CBOR_UNSAFE_TEXT)
+			&& !is_utf8((const uint8_t *)value, length)) {
+		ctx->ptr = str_start;
+		return CBOR_ERROR_UTF8;
+	}
+	cbor_di_write_int(ctx->buf, to_text ? DI_TSTR : DI_BSTR, length);
+	if (length) {
+		char *dest = smart_str_extend(ctx->buf, length);
+		memcpy(dest, value, length);
+	}
+	return 0;
+}
+
+static cbor_error json_literal(json_context *ctx, const char *literal, size_t length)
+{
+	if ((size_t)(ctx->end - ctx->ptr) < length) {
+		return memcmp(ctx->ptr, literal, ctx->end - ctx->ptr) ? CBOR_ERROR_SYNTAX : CBOR_ERROR_TRUNCATED_DATA;
+	}
+	if (memcmp(ctx->ptr, literal, length)) {
+		return CBOR_ERROR_SYNTAX;
+	}
+	ctx->ptr += length;
+	return 0;
+}
+
+static cbor_error json_array(json_context *ctx)
+{
+	cbor_error error;
+	size_t offset = ZSTR_LEN(ctx->buf->s);
+	uint64_t count = 0;
+	smart_str_appendc(ctx->buf, 0);  /* placeholder of the head */
+	ctx->ptr++;
+	skip_ws(ctx);
+	if (ctx->ptr < ctx->end && *ctx->ptr == ']') {
+		ctx->ptr++;
+	} else {
+		for (;;) {
+			if ((error = json_value(ctx)) != 0) {
+				return error;
+			}
+			count++;
+			skip_ws(ctx);
+			if (ctx->ptr < ctx->end && *ctx->ptr == ',') {
+				ctx->ptr++;
+				continue;
+			}
+			if (ctx->ptr < ctx->end && *ctx->ptr == ']') {
+				ctx->ptr++;
+				break;
+			}
+			return unexpected(ctx);
+		}
+	}
+	write_head(ctx, offset, DI_ARRAY, count);
+	return 0;
+}
+
+static int pair_cmp_key_cde(const void *a_p, const void *b_p)
+{
+	const json_pair *a = (const json_pair *)a_p, *b = (const json_pair *)b_p;
+	int cmp = zend_binary_strcmp(a->key, a->key_len, b->key, b->key_len);
+	if (cmp) {
+		return cmp;
+	}
+	return a->offset < b->offset ? -1 : 1;  /* duplicate keys in the order of appearance */
+}
+
+/* Compare the keys; a key registered to the stringref table is identified by its index alone,
+ * as it is written either literally or as a stringref. */
+static int pair_cmp_key(const void *a_p, const void *b_p)
+{
+	const json_pair *a = (const json_pair *)a_p, *b = (const json_pair *)b_p;
+	if (a->str_index != b->str_index) {
+		return a->str_index < b->str_index ? -1 : 1;
+	}
+	if (a->str_index >= 0) {
+		return a->offset < b->offset ? -1 : 1;
+	}
+	return pair_cmp_key_cde(a_p, b_p);
+}
+
+static int pair_cmp_offset(const void *a_p, const void *b_p)
+{
+	const json_pair *a = (const json_pair *)a_p, *b = (const json_pair *)b_p;
+	return a->offset < b->offset ? -1 : 1;
+}
+
+static bool pair_key_equals(const json_pair *a, const json_pair *b)
+{
+	if (a->str_index != b->str_index) {
+		return false;
+	}
+	return a->str_index >= 0 || (a->key_len == b->key_len && !memcmp(a->key, b->key, a->key_len));
+}
+
+static void pair_swap(void *a, void *b)
+{
+	json_pair tmp = *(json_pair *)a;
+	*(json_pair *)a = *(json_pair *)b;
+	*(json_pair *)b = tmp;
+}
+
+/* Sort the pairs of the map by the encoded keys; the last one wins on duplicate keys. Return the number of the pairs. */
+static uint64_t sort_cde_pairs(json_context *ctx, size_t first, size_t content)
+{
+	smart_str *buf = ctx->buf;
+	json_pair *pairs = &ctx->pairs[first];
+	size_t count = ctx->pair_count - first;
+	char *base = ZSTR_VAL(buf->s);
+	uint64_t written = 0;
+	for (size_t i = 0; i < count; i++) {
+		pairs[i].key = base + pairs[i].offset;
+	}
+	zend_sort(pairs, count, sizeof *pairs, pair_cmp_key_cde, pair_swap);
+	if (ctx->sort_buf.s) {
+		ZSTR_LEN(ctx->sort_buf.s) = 0;
+	}
+	for (size_t i = 0; i < count; i++) {
+		if (i + 1 < count && pairs[i].key_len == pairs[i + 1].key_len
+				&& !memcmp(pairs[i].key, pairs[i + 1].key, pairs[i].key_len)) {
+			continue;
+		}
+		smart_str_appendl(&ctx->sort_buf, pairs[i].key, pairs[i].len);
+		written++;
+	}
+	if (ctx->sort_buf.s) {
+		memcpy(base + content, ZSTR_VAL(ctx->sort_buf.s), ZSTR_LEN(ctx->sort_buf.s));
+		ZSTR_LEN(buf->s) = content + ZSTR_LEN(ctx->sort_buf.s);
+	}
+	ctx->pair_count = first;
+	return written;
+}
+
+/* Drop the duplicate keys of the map; the value of the last one is taken at the place of the first one, as json_decode() does. */
+static cbor_error dedup_pairs(json_context *ctx, size_t first, size_t content, uint64_t *count)
+{
+	smart_str *buf = ctx->buf;
+	json_pair *pairs = &ctx->pairs[first];
+	size_t n = ctx->pair_count - first, i, j;
+	char *base = ZSTR_VAL(buf->s);
+	bool has_dup = false;
+	ctx->pair_count = first;
+	for (i = 0; i < n; i++) {
+		pairs[i].key = base + pairs[i].offset;
+		pairs[i].value_offset = pairs[i].offset + pairs[i].key_len;
+		pairs[i].value_len = pairs[i].len - pairs[i].key_len;
+	}
+	zend_sort(pairs, n, sizeof *pairs, pair_cmp_key, pair_swap);
+	for (i = 0; i < n; i = j) {
+		for (j = i + 1; j < n && pair_key_equals(&pairs[i], &pairs[j]); j++) {
+			pairs[j].key = NULL;
+		}
+		if (j - i > 1) {
+			pairs[i].value_offset = pairs[j - 1].value_offset;
+			pairs[i].value_len = pairs[j - 1].value_len;
+			has_dup = true;
+		}
+	}
+	if (!has_dup) {
+		return 0;
+	}
+	if (ctx->str_table[0]) {
+		/* the strings in the dropped values may be referred to later */
+		return CBOR_ERROR_DUPLICATE_KEY;
+	}
+	zend_sort(pairs, n, sizeof *pairs, pair_cmp_offset, pair_swap);
+	if (ctx->sort_buf.s) {
+		ZSTR_LEN(ctx->sort_buf.s) = 0;
+	}
+	*count = 0;
+	for (i = 0; i < n; i++) {
+		if (!pairs[i].key) {
+			continue;
+		}
+		smart_str_appendl(&ctx->sort_buf, pairs[i].key, pairs[i].key_len);
+		smart_str_appendl(&ctx->sort_buf, base + pairs[i].value_offset, pairs[i].value_len);
+		(*count)++;
+	}
+	memcpy(base + content, ZSTR_VAL(ctx->sort_buf.s), ZSTR_LEN(ctx->sort_buf.s));
+	ZSTR_LEN(buf->s) = content + ZSTR_LEN(ctx->sort_buf.s);
+	return 0;
+}
+
+static cbor_error json_object(json_context *ctx)
+{
+	cbor_error error;
+	size_t offset = ZSTR_LEN(ctx->buf->s);
+	size_t first = ctx->pair_count;
+	uint64_t count = 0;
+	bool is_cde = (ctx->args.e_flags & CBOR_CDE) != 0;
+	bool to_text = (ctx->args.e_flags & CBOR_KEY_TEXT) != 0;
+	smart_str_appendc(ctx->buf, 0);  /* placeholder of the head */
+	ctx->ptr++;
+	skip_ws(ctx);
+	if (ctx->ptr < ctx->end && *ctx->ptr == '}') {
+		ctx->ptr++;
+	} else {
+		for (;;) {
+			size_t pair_index = ctx->pair_count;
+			skip_ws(ctx);
+			if (ctx->ptr >= ctx->end || *ctx->ptr != '"') {
+				return unexpected(ctx);
+			}
+			if (UNEXPECTED(!(ctx->args.e_flags & (CBOR_KEY_BYTE | CBOR_KEY_TEXT)))) {
+				return E_DESC(CBOR_ERROR_INVALID_FLAGS, NO_KEY_STRING_FLAG);
+			}
+			if (ctx->pair_count >= ctx->pair_size) {
+				ctx->pair_size = ctx->pair_size ? ctx->pair_size * 2 : PAIR_STACK_INIT_SIZE;
+				ctx->pairs = safe_erealloc(ctx->pairs, ctx->pair_size, sizeof *ctx->pairs, 0);
+			}
+			ctx->pairs[ctx->pair_count++].offset = ZSTR_LEN(ctx->buf->s);
+			if ((error = json_string(ctx, to_text)) != 0) {
+				return error;
+			}
+			json_pair *pair = &ctx->pairs[pair_index];
+			pair->key_len = ZSTR_LEN(ctx->buf->s) - pair->offset;
+			pair->str_index = ctx->str_index;
+			skip_ws(ctx);
+			if (ctx->ptr >= ctx->end || *ctx->ptr != ':') {
+				return unexpected(ctx);
+			}
+			ctx->ptr++;
+			if ((error = json_value(ctx)) != 0) {
+				return error;
+			}
+			pair = &ctx->pairs[pair_index];  /* may be reallocated */
+			pair->len = ZSTR_LEN(ctx->buf->s) - pair->offset;
+			count++;
+			skip_ws(ctx);
+			if (ctx->ptr < ctx->end && *ctx->ptr == ',') {
+				ctx->ptr++;
+				continue;
+			}
+			if (ctx->ptr < ctx->end && *ctx->ptr == '}') {
+				ctx->ptr++;
+				break;
+			}
+			return unexpected(ctx);
+		}
+	}
+	if (is_cde && count) {
+		count = sort_cde_pairs(ctx, first, offset + 1);
+	} else if (count > 1) {
+		if ((error = dedup_pairs(ctx, first, offset + 1, &count)) != 0) {
+			return error;
+		}
+	} else {
+		ctx->pair_count = first;
+	}
+	write_head(ctx, offset, DI_MAP, count);
+	return 0;
+}
+
+static cbor_error json_value(json_context *ctx)
+{
+	cbor_error error = 0;
+	if (ctx->cur_depth++ > ctx->args.max_depth) {
+		return CBOR_ERROR_DEPTH;
+	}
+	skip_ws(ctx);
+	if (ctx->ptr >= ctx->end) {
+		return CBOR_ERROR_TRUNCATED_DATA;
+	}
+	switch (*ctx->ptr) {
+	case '{':
+		error = json_object(ctx);
+		break;
+	case '[':
+		error = json_array(ctx);
+		break;
+	case '"':
+		if (UNEXPECTED(!(ctx->args.e_flags & (CBOR_BYTE | CBOR_TEXT)))) {
+			error = E_DESC(CBOR_ERROR_INVALID_FLAGS, NO_STRING_FLAG);
+			break;
+		}
+		error = json_string(ctx, (ctx->args.e_flags & CBOR_TEXT) != 0);
+		break;
+	case 't':
+		if ((error = json_literal(ctx, ZEND_STRL("true"))) == 0) {
+			cbor_di_write_bool(ctx->buf, true);
+		}
+		break;
+	case 'f':
+		if ((error = json_literal(ctx, ZEND_STRL("false"))) == 0) {
+			cbor_di_write_bool(ctx->buf, false);
+		}
+		break;
+	case 'n':
+		if ((error = json_literal(ctx, ZEND_STRL("null"))) == 0) {
+			cbor_di_write_null(ctx->buf);
+		}
+		break;
+	default:
+		if (*ctx->ptr == '-' || IS_DIGIT(*ctx->ptr)) {
+			error = json_number(ctx);
+		} else {
+			error = CBOR_ERROR_SYNTAX;
+		}
+	}
+	ctx->cur_depth--;
+	return error;
+}
+
+cbor_error cbor_from_json(zend_string *json, zend_string **data, cbor_encode_args *args)
+{
+	cbor_error error;
+	json_context ctx;
+	smart_str buf = {0};
+	memset(&ctx, 0, sizeof ctx);
+	ctx.args = *args;
+	ctx.start = ctx.ptr = ZSTR_VAL(json);
+	ctx.end = ctx.start + ZSTR_LEN(json);
+	ctx.buf = &buf;
+	if (ctx.args.e_flags & CBOR_SELF_DESCRIBE) {
+		cbor_di_write_int(&buf, DI_TAG, CBOR_TAG_SELF_DESCRIBE);
+	}
+	if (ctx.args.string_ref == OPT_TRUE) {
+		cbor_di_write_int(&buf, DI_TAG, CBOR_TAG_STRING_REF_NS);
+		ctx.str_table[0] = zend_new_array(0);
+		ctx.str_table[1] = zend_new_array(0);
+	}
+	smart_str_alloc(&buf, ZSTR_LEN(json) / 2, false);  /* offsets are taken from buf.s */
+	error = json_value(&ctx);
+	if (!error) {
+		skip_ws(&ctx);
+		if (ctx.ptr != ctx.end) {
+			error = CBOR_ERROR_EXTRANEOUS_DATA;
+		}
+	}
+	if (ctx.str_table[0]) {
+		zend_array_destroy(ctx.str_table[0]);
+		zend_array_destroy(ctx.str_table[1]);
+	}
+	if (ctx.pairs) {
+		efree(ctx.pairs);
+	}
+	smart_str_free(&ctx.str_buf);
+	smart_str_free(&ctx.sort_buf);
+	if (!error) {
+		*data = smart_str_extract(&buf);
+	} else {
+		args->error_args.offset = ctx.ptr - ctx.start;
+		smart_str_free(&buf);
+	}
+	return error;
+}
@@ -0,0 +1,155 @@
+/**
+ * @author SATO Kentaro
+ * @license BSD-2-Clause
+ */
+
+#include "cbor.h"
+#include "codec.h"
+#include "compatibility.h"
+#include "types.h"
+#include <Zend/zend_exceptions.h>
+#include <Zend/zend_smart_str.h>
+#include <assert.h>
+
+#define BUFFER_KEEP_SIZE  (512 * 1024)
+
+typedef struct {
+	cbor_encode_args args;
+	cbor_encode_context *ctx;
+	smart_str buf;
+	bool is_processing;
+	zend_object std;
+} encoder_class;
+
+static zend_object_handlers encoder_handlers;
+
+static zend_object *encoder_create(zend_class_entry *ce)
+{
+	encoder_class *base = zend_object_alloc(sizeof(encoder_class), ce);
+	memset(&base->args, 0, sizeof base->args);
+	base->ctx = NULL;
+	memset(&base->buf, 0, sizeof base->buf);
+	base->is_processing = false;
+	zend_object_std_init(&base->std, ce);
+	base->std.handlers = &encoder_handlers;
+	return &base->std;
+}
+
+static void encoder_free(zend_object *obj)
+{
+	encoder_class *base = CUSTOM_OBJ(encoder_class, obj);
+	if (base->ctx) {
+		cbor_encode_delete(base->ctx);
+	}
+	smart_str_free(&base->buf);
+	zend_object_std_dtor(obj);
+}
+
+#define NO_REENTRANT(base)  do { \
+		if (base->is_processing) { \
+			zend_throw_error(NULL, "The operation is not permitted while encoding is in progress."); \
+			RETURN_THROWS(); \
+		} \
+	} while (0)
+
+PHP_METHOD(Cbor_Encoder, __construct)
+{
+	encoder_class *base = CUSTOM_OBJ(encoder_class, Z_OBJ_P(ZEND_THIS));
+	zend_long flags = CBOR_BYTE | CBOR_KEY_BYTE;
+	HashTable *options = NULL;
+	cbor_error error;
+	NO_REENTRANT(base);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "|lh!", &flags, &options) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	base->args.u_flags = (uint32_t)flags;
+	if ((error = cbor_set_encode_options(&base->args, options)) != 0
+			|| (error = cbor_check_encode_params(&base->args)) != 0) {
+		cbor_throw_error(error, false, &base->args.error_args);
+		RETURN_THROWS();
+	}
+	if (base->ctx) {
+		cbor_encode_delete(base->ctx);
+	}
+	base->ctx = cbor_encode_new(&base->args);
+}
+
+static zend_string *encoder_take_buffer(encoder_class *base)
+{
+	smart_str *buf = &base->buf;
+	zend_string *str;
+	assert(buf->s);
+	if (buf->a > BUFFER_KEEP_SIZE) {
+		/* give away the large buffer instead of keeping it */
+		str = smart_str_extract(buf);
+	} else {
+		str = zend_string_init(ZSTR_VAL(buf->s), ZSTR_LEN(buf->s), false);
+		ZSTR_LEN(buf->s) = 0;
+	}
+	return str;
+}
+
+#define REQUIRE_CTX(base)  do { \
+		if (!base->ctx) { \
+			zend_throw_error(NULL, "The encoder is not initialized."); \
+			RETURN_THROWS(); \
+		} \
+	} while (0)
+
+PHP_METHOD(Cbor_Encoder, encode)
+{
+	encoder_class *base = CUSTOM_OBJ(encoder_class, Z_OBJ_P(ZEND_THIS));
+	zval *value;
+	NO_REENTRANT(base);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "z", &value) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	REQUIRE_CTX(base);
+	cbor_encode_args args = base->args;
+	base->is_processing = true;
+	cbor_error error = cbor_encode_process(base->ctx, value, &base->buf, &args);
+	base->is_processing = false;
+	if (error) {
+		cbor_throw_error(error, false, &args.error_args);
+		RETURN_THROWS();
+	}
+	RETURN_STR(encoder_take_buffer(base));
+}
+
+PHP_METHOD(Cbor_Encoder, encodeToStream)
+{
+	encoder_class *base = CUSTOM_OBJ(encoder_class, Z_OBJ_P(ZEND_THIS));
+	zval *z_stream;
+	php_stream *stream;
+	zval *value;
+	size_t written = 0;
+	NO_REENTRANT(base);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "rz", &z_stream, &value) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	php_stream_from_zval(stream, z_stream);
+	REQUIRE_CTX(base);
+	cbor_encode_args args = base->args;
+	base->is_processing = true;
+	cbor_error error = cbor_encode_process_stream(base->ctx, value, &base->buf, stream, &written, &args);
+	base->is_processing = false;
+	if (error) {
+		cbor_throw_error(error, false, &args.error_args);
+		RETURN_THROWS();
+	}
+	RETURN_LONG((zend_long)written);
+}
+
+void cbor_minit_encoder()
+{
+	CBOR_CE(encoder)->create_object = &encoder_create;
+#if TARGET_PHP_API_LT_81
+	CBOR_CE(encoder)->serialize = zend_class_serialize_deny;
+	CBOR_CE(encoder)->unserialize = zend_class_unserialize_deny;
+#endif
+	memcpy(&encoder_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+	encoder_handlers.offset = XtOffsetOf(encoder_class, std);
+	encoder_handlers.free_obj = &encoder_free;
+	encoder_handlers.clone_obj = NULL;
+	encoder_handlers.compare = zend_objects_not_comparable;
+}
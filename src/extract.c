@@ -0,0 +1,782 @@
+/**
+ * @author SATO Kentaro
+ * @license BSD-2-Clause
+ */
+
+#include "cbor.h"
+#include "codec.h"
+#include "di_decoder.h"
+#include "tags.h"
+#include <assert.h>
+
+#define SKIP_STACK_INIT_SIZE  8
+#define IS_BREAK_AT(mem)  ((mem)->offset < (mem)->length && (mem)->ptr[(mem)->offset] == 0xff)
+
+typedef struct {
+	bool has_index;  /* int, or string of the canonical int form */
+	zend_long index;
+	const char *str;
+	size_t len;
+	char buf[ZEND_LTOA_BUF_LEN];
+} path_key;
+
+static void init_path_key(path_key *key, zval *element)
+{
+	ZVAL_DEREF(element);
+	if (Z_TYPE_P(element) == IS_LONG) {
+		/* int key of stdClass is a numeric string */
+		key->has_index = true;
+		key->index = Z_LVAL_P(element);
+		ZEND_LTOA(key->index, key->buf, sizeof key->buf);
+		key->str = key->buf;
+		key->len = strlen(key->buf);
+	} else {
+		zend_ulong index;
+		assert(Z_TYPE_P(element) == IS_STRING);
+		key->str = Z_STRVAL_P(element);
+		key->len = Z_STRLEN_P(element);
+		key->has_index = ZEND_HANDLE_NUMERIC_STR(key->str, key->len, index);
+		key->index = key->has_index ? (zend_long)index : 0;
+	}
+}
+
+/* Read the head at the offset and advance the offset past the head. */
+static cbor_error read_head(cbor_fragment *mem, const cbor_di_head **head, uint64_t *arg)
+{
+	const uint8_t *data = &mem->ptr[mem->offset];
+	size_t rem_len = mem->length - mem->offset;
+	if (!rem_len) {
+		return CBOR_ERROR_TRUNCATED_DATA;
+	}
+	*head = &cbor_di_heads[data[0]];
+	if (!(*head)->type) {
+		return CBOR_ERROR_MALFORMED_DATA;
+	}
+	if ((*head)->arg_len > rem_len - 1) {
+		return CBOR_ERROR_TRUNCATED_DATA;
+	}
+	*arg = cbor_di_read_arg(data, (*head)->arg_len);
+	if ((*head)->type == DI_SIMPLE8 && *arg <= 31) {
+		return CBOR_ERROR_MALFORMED_DATA;
+	}
+	mem->offset += 1 + (*head)->arg_len;
+	return 0;
+}
+
+/* Skip the data item at the offset without decoding; strings are skipped by their length. */
+cbor_error cbor_skip_item(cbor_fragment *mem, uint32_t max_depth)
+{
+	cbor_error error = 0;
+	const cbor_di_head *head;
+	uint64_t arg;
+	uint64_t remaining = 1;  /* items left in the definite-length containers */
+	uint64_t *indef_stack = NULL;  /* outer remaining of each indefinite-length container */
+	uint32_t depth = 0, stack_size = 0;
+	do {
+		if ((error = read_head(mem, &head, &arg)) != 0) {
+			break;
+		}
+		if (head->is_indef) {
+			if (depth >= max_depth) {
+				error = CBOR_ERROR_DEPTH;
+				break;
+			}
+			if (depth >= stack_size) {
+				stack_size = stack_size ? stack_size * 2 : SKIP_STACK_INIT_SIZE;
+				indef_stack = safe_erealloc(indef_stack, stack_size, sizeof *indef_stack, 0);
+			}
+			/* items are counted until the break */
+			indef_stack[depth++] = remaining ? remaining - 1 : 0;
+			remaining = 0;
+			continue;
+		}
+		switch (head->type) {
+		case DI_BSTR:
+		case DI_TSTR:
+			if (arg > mem->length - mem->offset) {
+				error = CBOR_ERROR_TRUNCATED_DATA;
+				goto FINALLY;
+			}
+			mem->offset += (size_t)arg;
+			break;
+		case DI_ARRAY:
+		case DI_MAP:
+			if (arg > mem->length - mem->offset) {
+				/* every element takes at least a byte */
+				error = CBOR_ERROR_TRUNCATED_DATA;
+				goto FINALLY;
+			}
+			if (remaining) {
+				remaining--;
+			}
+			remaining += (head->type == DI_MAP) ? arg * 2 : arg;
+			continue;
+		case DI_TAG:
+			continue;  /* content follows */
+		case DI_BREAK:
+			if (!depth) {
+				error = E_DESC(CBOR_ERROR_SYNTAX, BREAK_UNDERFLOW);
+				goto FINALLY;
+			}
+			if (remaining) {
+				error = E_DESC(CBOR_ERROR_SYNTAX, BREAK_UNEXPECTED);
+				goto FINALLY;
+			}
+			remaining = indef_stack[--depth];
+			continue;
+		}
+		if (remaining) {
+			remaining--;
+		}
+	} while (remaining || depth);
+FINALLY:
+	if (indef_stack) {
+		efree(indef_stack);
+	}
+	return error;
+}
+
+/* Compare the chunks of indefinite-length string at the offset with the key. */
+static cbor_error match_indef_string(cbor_fragment *mem, uint8_t type, const path_key *key, bool *matched)
+{
+	cbor_error error;
+	const cbor_di_head *head;
+	uint64_t arg;
+	size_t len = 0;
+	bool is_equal = true;
+	for (;;) {
+		if ((error = read_head(mem, &head, &arg)) != 0) {
+			return error;
+		}
+		if (head->type == DI_BREAK) {
+			break;
+		}
+		if (head->type != DI_BSTR && head->type != DI_TSTR) {
+			return E_DESC(CBOR_ERROR_SYNTAX, INDEF_STRING_CHUNK_TYPE);
+		}
+		if (head->type != type || head->is_indef) {
+			return E_DESC(CBOR_ERROR_SYNTAX, INCONSISTENT_STRING_TYPE);
+		}
+		if (arg > mem->length - mem->offset) {
+			return CBOR_ERROR_TRUNCATED_DATA;
+		}
+		if (is_equal) {
+			is_equal = arg <= key->len - len && !memcmp(&mem->ptr[mem->offset], key->str + len, (size_t)arg);
+			len += (size_t)arg;
+		}
+		mem->offset += (size_t)arg;
+	}
+	*matched = is_equal && len == key->len;
+	return 0;
+}
+
+/* Compare the map key at the offset with the key, and advance the offset past the map key. */
+static cbor_error match_key(cbor_fragment *mem, const path_key *key, const cbor_decode_args *args, bool *matched)
+{
+	cbor_error error;
+	const cbor_di_head *head;
+	uint64_t arg;
+	size_t start = mem->offset;
+	*matched = false;
+	if ((error = read_head(mem, &head, &arg)) != 0) {
+		return error;
+	}
+	switch (head->type) {
+	case DI_UINT:
+		*matched = args->flags & CBOR_INT_KEY && key->has_index && key->index >= 0 && (uint64_t)key->index == arg;
+		return 0;
+	case DI_NINT:
+		*matched = args->flags & CBOR_INT_KEY && key->has_index && key->index < 0 && (uint64_t)(-1 - key->index) == arg;
+		return 0;
+	case DI_BSTR:
+	case DI_TSTR:
+		if (!(args->flags & (head->type == DI_TSTR ? CBOR_KEY_TEXT : CBOR_KEY_BYTE))) {
+			break;
+		}
+		if (head->is_indef) {
+			return match_indef_string(mem, head->type, key, matched);
+		}
+		if (arg > mem->length - mem->offset) {
+			return CBOR_ERROR_TRUNCATED_DATA;
+		}
+		*matched = arg == key->len && !memcmp(&mem->ptr[mem->offset], key->str, key->len);
+		mem->offset += (size_t)arg;
+		return 0;
+	}
+	mem->offset = start;
+	return cbor_skip_item(mem, args->max_depth);
+}
+
+/* Skip the tags on the path at the offset; self-described content is descended into unless at the root, where the tag is kept on decoding. */
+static cbor_error skip_path_tags(cbor_fragment *mem, bool is_root)
+{
+	cbor_error error;
+	const cbor_di_head *head;
+	uint64_t arg;
+	size_t start;
+	while (mem->offset < mem->length && cbor_di_heads[mem->ptr[mem->offset]].type == DI_TAG) {
+		start = mem->offset;
+		if ((error = read_head(mem, &head, &arg)) != 0) {
+			return error;
+		}
+		if (is_root || arg != CBOR_TAG_SELF_DESCRIBE) {
+			/* the path cannot go through the tag */
+			mem->offset = start;
+			return CBOR_ERROR_UNSUPPORTED_TYPE;
+		}
+	}
+	return 0;
+}
+
+/* Move the offset to the element of the array or the map at the offset; *found is cleared if it is not there. */
+static cbor_error find_element(cbor_fragment *mem, const path_key *key, bool is_root, const cbor_decode_args *args, bool *found)
+{
+	cbor_error error;
+	const cbor_di_head *head;
+	uint64_t arg, i;
+	bool matched;
+	*found = false;
+	if ((error = skip_path_tags(mem, is_root)) != 0 || (error = read_head(mem, &head, &arg)) != 0) {
+		return error;
+	}
+	if (head->type == DI_ARRAY) {
+		if (!key->has_index || key->index < 0) {
+			return 0;
+		}
+		for (i = 0; head->is_indef ? !IS_BREAK_AT(mem) : i < arg; i++) {
+			if (i == (uint64_t)key->index) {
+				*found = true;
+				return 0;
+			}
+			if ((error = cbor_skip_item(mem, args->max_depth)) != 0) {
+				return error;
+			}
+		}
+	} else if (head->type == DI_MAP) {
+		for (i = 0; head->is_indef ? !IS_BREAK_AT(mem) : i < arg; i++) {
+			if ((error = match_key(mem, key, args, &matched)) != 0) {
+				return error;
+			}
+			if (matched) {
+				*found = true;
+				return 0;
+			}
+			if ((error = cbor_skip_item(mem, args->max_depth)) != 0) {
+				return error;
+			}
+		}
+	}
+	return 0;
+}
+
+static void skip_self_describe(cbor_fragment *mem, const cbor_decode_args *args)
+{
+	if (!(args->flags & CBOR_SELF_DESCRIBE)
+			&& mem->length - mem->offset >= sizeof CBOR_SELF_DESCRIBE_DATA - 1
+			&& !memcmp(&mem->ptr[mem->offset], CBOR_SELF_DESCRIBE_DATA, sizeof CBOR_SELF_DESCRIBE_DATA - 1)) {
+		mem->offset += sizeof CBOR_SELF_DESCRIBE_DATA - 1;
+	}
+}
+
+/* Decode the item at the path; siblings on the way are skipped, and value is set to null if the path is not found. */
+cbor_error cbor_extract(zend_string *data, HashTable *path, zval *value, cbor_decode_args *args)
+{
+	cbor_error error;
+	cbor_fragment mem;
+	cbor_decode_args item_args;
+	cbor_decode_context *ctx;
+	path_key key;
+	zval *element;
+	uint32_t depth = 0;
+	bool found = true;
+	ZVAL_NULL(value);
+	if ((error = cbor_init_fragment(&mem, data, args)) != 0) {
+		return error;
+	}
+	skip_self_describe(&mem, args);
+	ZEND_HASH_FOREACH_VAL(path, element) {
+		if (depth >= args->max_depth) {
+			error = CBOR_ERROR_DEPTH;
+			break;
+		}
+		init_path_key(&key, element);
+		if ((error = find_element(&mem, &key, !depth++, args, &found)) != 0 || !found) {
+			break;
+		}
+	} ZEND_HASH_FOREACH_END();
+	if (error) {
+		args->error_args.offset = mem.base + mem.offset;
+		return error;
+	}
+	if (!found) {
+		return 0;
+	}
+	item_args = *args;
+	item_args.flags |= CBOR_SELF_DESCRIBE;  /* the root tag is already skipped */
+	item_args.max_depth -= depth;
+	ctx = cbor_decode_new(&item_args, &mem);
+	error = cbor_decode_process(ctx);
+	error = cbor_decode_finish(ctx, &item_args, error, value);
+	cbor_decode_delete(ctx);
+	if (error) {
+		args->error_args = item_args.error_args;
+	}
+	return error;
+}
+
+#define INDEX_INIT_SIZE  16
+
+typedef struct {
+	size_t node;
+	size_t mark;  /* count of the pending offsets on open */
+	uint64_t remaining;  /* items left in the definite-length container */
+	bool is_indef;
+} index_open_item;
+
+static void *index_grow(void *ptr, size_t *size, size_t count, size_t elem_size)
+{
+	if (count < *size) {
+		return ptr;
+	}
+	*size = *size ? *size * 2 : INDEX_INIT_SIZE;
+	return safe_erealloc(ptr, *size, elem_size, 0);
+}
+
+/* Move the pending offsets of the elements to the table on closing the container. */
+static void index_close(cbor_index_table *table, index_open_item *open, const size_t *pending, size_t *pending_count, size_t end)
+{
+	cbor_index_node *node = &table->nodes[open->node];
+	size_t count = *pending_count - open->mark;
+	if (count) {
+		if (table->offset_count + count > table->offset_size) {
+			table->offset_size = table->offset_count + count + (table->offset_count >> 1);
+			table->offsets = safe_erealloc(table->offsets, table->offset_size, sizeof *table->offsets, 0);
+		}
+		memcpy(&table->offsets[table->offset_count], &pending[open->mark], count * sizeof *pending);
+	}
+	node->end = end;
+	node->first = table->offset_count;
+	node->count = count;
+	table->offset_count += count;
+	*pending_count = open->mark;
+}
+
+/* Scan the data item at the offset, recording the offsets of the elements of arrays and maps; tagged items other than self-described ones are skipped as a whole. */
+static cbor_error index_scan(cbor_fragment *mem, cbor_index_table *table, uint32_t max_depth)
+{
+	cbor_error error = 0;
+	const cbor_di_head *head;
+	uint64_t arg;
+	index_open_item *open = NULL, *top;
+	size_t *pending = NULL;  /* offsets of the elements of the open containers */
+	size_t pending_count = 0, pending_size = 0, start;
+	uint32_t depth = 0, open_size = 0;
+	for (;;) {
+		if (depth && open[depth - 1].is_indef && IS_BREAK_AT(mem)) {
+			top = &open[depth - 1];
+			if (table->nodes[top->node].is_map && (pending_count - top->mark) % 2) {
+				error = E_DESC(CBOR_ERROR_SYNTAX, BREAK_UNEXPECTED);
+				break;
+			}
+			index_close(table, top, pending, &pending_count, mem->offset);
+			mem->offset++;
+			depth--;
+			goto COMPLETED;
+		}
+		start = mem->offset;
+		if (depth) {
+			pending = index_grow(pending, &pending_size, pending_count, sizeof *pending);
+			pending[pending_count++] = start;
+		}
+		if ((error = read_head(mem, &head, &arg)) != 0) {
+			break;
+		}
+		while (depth && head->type == DI_TAG && arg == CBOR_TAG_SELF_DESCRIBE) {
+			/* the content is indexed in place of the element, as cbor_extract() descends into it */
+			start = mem->offset;
+			if ((error = read_head(mem, &head, &arg)) != 0) {
+				goto FINALLY;
+			}
+		}
+		switch (head->type) {
+		case DI_ARRAY:
+		case DI_MAP:
+			if (depth >= max_depth) {
+				error = CBOR_ERROR_DEPTH;
+				goto FINALLY;
+			}
+			if (!head->is_indef && arg > mem->length - mem->offset) {
+				/* every element takes at least a byte */
+				error = CBOR_ERROR_TRUNCATED_DATA;
+				goto FINALLY;
+			}
+			table->nodes = index_grow(table->nodes, &table->node_size, table->node_count, sizeof *table->nodes);
+			table->nodes[table->node_count].offset = start;
+			table->nodes[table->node_count].is_map = head->type == DI_MAP;
+			if (depth >= open_size) {
+				open_size = open_size ? open_size * 2 : INDEX_INIT_SIZE;
+				open = safe_erealloc(open, open_size, sizeof *open, 0);
+			}
+			top = &open[depth++];
+			top->node = table->node_count++;
+			top->mark = pending_count;
+			top->remaining = (head->type == DI_MAP) ? arg * 2 : arg;
+			top->is_indef = head->is_indef;
+			if (head->is_indef || top->remaining) {
+				continue;
+			}
+			index_close(table, top, pending, &pending_count, mem->offset);
+			depth--;
+			break;
+		case DI_BSTR:
+		case DI_TSTR:
+			if (head->is_indef) {
+				mem->offset = start;
+				error = cbor_skip_item(mem, max_depth - depth);
+			} else if (arg > mem->length - mem->offset) {
+				error = CBOR_ERROR_TRUNCATED_DATA;
+			} else {
+				mem->offset += (size_t)arg;
+			}
+			break;
+		case DI_TAG:
+			mem->offset = start;
+			error = cbor_skip_item(mem, max_depth - depth);
+			break;
+		case DI_BREAK:
+			error = depth ? E_DESC(CBOR_ERROR_SYNTAX, BREAK_UNEXPECTED) : E_DESC(CBOR_ERROR_SYNTAX, BREAK_UNDERFLOW);
+			break;
+		}
+		if (error) {
+			break;
+		}
+COMPLETED:
+		while (depth && !open[depth - 1].is_indef && --open[depth - 1].remaining == 0) {
+			index_close(table, &open[depth - 1], pending, &pending_count, mem->offset);
+			depth--;
+		}
+		if (!depth) {
+			break;
+		}
+	}
+FINALLY:
+	if (open) {
+		efree(open);
+	}
+	if (pending) {
+		efree(pending);
+	}
+	return error;
+}
+
+void cbor_index_free(cbor_index_table *table)
+{
+	if (table->nodes) {
+		efree(table->nodes);
+	}
+	if (table->offsets) {
+		efree(table->offsets);
+	}
+	memset(table, 0, sizeof *table);
+}
+
+/* Find the container at the offset; nodes are recorded in the order of the offset. */
+static const cbor_index_node *index_find_node(const cbor_index_table *table, size_t offset)
+{
+	size_t low = 0, high = table->node_count;
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+		const cbor_index_node *node = &table->nodes[mid];
+		if (node->offset == offset) {
+			return node;
+		}
+		if (node->offset < offset) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return NULL;
+}
+
+/* Set the offset and the length of the fragment to the element i of the container. */
+static void index_set_element(const cbor_index_table *table, const cbor_index_node *node, size_t i, cbor_fragment *mem)
+{
+	mem->offset = table->offsets[node->first + i];
+	mem->length = (i + 1 < node->count) ? table->offsets[node->first + i + 1] : node->end;
+}
+
+/* Narrow the fragment spanning the indexed item down to the item at the path; *found is cleared if it is not there. */
+cbor_error cbor_index_find(const cbor_index_table *table, cbor_fragment *mem, zval *path, uint32_t path_count, const cbor_decode_args *args, bool *found)
+{
+	cbor_error error;
+	const cbor_index_node *node;
+	path_key key;
+	size_t i, limit = mem->length;
+	bool matched;
+	*found = false;
+	for (uint32_t depth = 0; depth < path_count; depth++) {
+		if (depth >= args->max_depth) {
+			return CBOR_ERROR_DEPTH;
+		}
+		if ((error = skip_path_tags(mem, !depth)) != 0) {
+			return error;
+		}
+		if ((node = index_find_node(table, mem->offset)) == NULL) {
+			return 0;  /* not a container */
+		}
+		init_path_key(&key, &path[depth]);
+		if (!node->is_map) {
+			if (!key.has_index || key.index < 0 || (uint64_t)key.index >= node->count) {
+				return 0;
+			}
+			index_set_element(table, node, (size_t)key.index, mem);
+			continue;
+		}
+		for (i = 0; i < node->count; i += 2) {
+			mem->offset = table->offsets[node->first + i];
+			mem->length = limit;
+			if ((error = match_key(mem, &key, args, &matched)) != 0) {
+				return error;
+			}
+			if (matched) {
+				break;
+			}
+		}
+		if (i >= node->count) {
+			return 0;
+		}
+		index_set_element(table, node, i + 1, mem);
+	}
+	*found = true;
+	return 0;
+}
+
+/* Index the data item; the root item is recorded past the self-describe tag. */
+cbor_error cbor_index(zend_string *data, cbor_index_table *table, cbor_decode_args *args)
+{
+	cbor_error error;
+	cbor_fragment mem;
+	memset(table, 0, sizeof *table);
+	if ((error = cbor_init_fragment(&mem, data, args)) != 0) {
+		return error;
+	}
+	skip_self_describe(&mem, args);
+	table->root = mem.offset;
+	table->end = mem.length;
+	error = index_scan(&mem, table, args->max_depth);
+	if (!error && mem.offset != mem.length) {
+		error = CBOR_ERROR_EXTRANEOUS_DATA;
+	}
+	if (error) {
+		args->error_args.offset = mem.base + mem.offset;
+		cbor_index_free(table);
+	}
+	return error;
+}
+
+static const uint8_t reader_tokens[] = {
+	[DI_UINT] = CBOR_TOKEN_INT,
+	[DI_NINT] = CBOR_TOKEN_INT,
+	[DI_BSTR] = CBOR_TOKEN_BYTE,
+	[DI_TSTR] = CBOR_TOKEN_TEXT,
+	[DI_ARRAY] = CBOR_TOKEN_ARRAY,
+	[DI_MAP] = CBOR_TOKEN_MAP,
+	[DI_TAG] = CBOR_TOKEN_TAG,
+	[DI_FALSE] = CBOR_TOKEN_FALSE,
+	[DI_TRUE] = CBOR_TOKEN_TRUE,
+	[DI_NULL] = CBOR_TOKEN_NULL,
+	[DI_UNDEF] = CBOR_TOKEN_UNDEFINED,
+	[DI_SIMPLE0] = CBOR_TOKEN_SIMPLE,
+	[DI_SIMPLE8] = CBOR_TOKEN_SIMPLE,
+	[DI_FLOAT16] = CBOR_TOKEN_FLOAT,
+	[DI_FLOAT32] = CBOR_TOKEN_FLOAT,
+	[DI_FLOAT64] = CBOR_TOKEN_FLOAT,
+	[DI_BREAK] = CBOR_TOKEN_NONE,
+};
+
+/* Skip the chunks of indefinite-length string at the offset, counting the total length. */
+static cbor_error skip_indef_string(cbor_fragment *mem, uint8_t type, uint64_t *length)
+{
+	cbor_error error;
+	const cbor_di_head *head;
+	uint64_t arg;
+	*length = 0;
+	for (;;) {
+		if ((error = read_head(mem, &head, &arg)) != 0) {
+			return error;
+		}
+		if (head->type == DI_BREAK) {
+			return 0;
+		}
+		if (head->type != DI_BSTR && head->type != DI_TSTR) {
+			return E_DESC(CBOR_ERROR_SYNTAX, INDEF_STRING_CHUNK_TYPE);
+		}
+		if (head->type != type || head->is_indef) {
+			return E_DESC(CBOR_ERROR_SYNTAX, INCONSISTENT_STRING_TYPE);
+		}
+		if (arg > mem->length - mem->offset) {
+			return CBOR_ERROR_TRUNCATED_DATA;
+		}
+		*length += arg;
+		mem->offset += (size_t)arg;
+	}
+}
+
+/* Count the item read in the innermost container. */
+static void reader_consume(cbor_reader_state *state)
+{
+	cbor_reader_frame *top;
+	state->in_tag = false;
+	if (!state->depth) {
+		return;
+	}
+	top = &state->stack[state->depth - 1];
+	if (top->is_indef) {
+		top->has_key = !top->has_key;
+	} else {
+		top->remaining--;
+	}
+}
+
+/* Read the next token; arrays and maps are entered, and their end is read as a token. */
+cbor_error cbor_reader_next(cbor_reader_state *state, cbor_fragment *mem, uint32_t max_depth)
+{
+	cbor_error error = 0;
+	const cbor_di_head *head;
+	uint64_t arg;
+	cbor_reader_frame *top = state->depth ? &state->stack[state->depth - 1] : NULL;
+	state->is_left = false;
+	state->offset = mem->offset;
+	if (!state->in_tag) {
+		if (top && (top->is_indef ? IS_BREAK_AT(mem) : !top->remaining)) {
+			if (top->is_indef) {
+				if (top->is_map && top->has_key) {
+					return E_DESC(CBOR_ERROR_SYNTAX, BREAK_UNEXPECTED);
+				}
+				mem->offset++;
+			}
+			state->token = CBOR_TOKEN_END;
+			state->token_depth = --state->depth;
+			state->content = mem->offset;
+			return 0;
+		}
+		if (!top && mem->offset >= mem->length) {
+			state->token = CBOR_TOKEN_NONE;
+			state->token_depth = 0;
+			state->content = mem->offset;
+			return 0;
+		}
+	}
+	if ((error = read_head(mem, &head, &arg)) != 0) {
+		return error;
+	}
+	state->token = reader_tokens[head->type];
+	state->token_depth = state->depth;
+	state->type = head->type;
+	state->is_indef = head->is_indef;
+	state->arg = arg;
+	state->content = mem->offset;
+	switch (head->type) {
+	case DI_BSTR:
+	case DI_TSTR:
+		if (head->is_indef) {
+			error = skip_indef_string(mem, head->type, &state->length);
+		} else if (arg > mem->length - mem->offset) {
+			error = CBOR_ERROR_TRUNCATED_DATA;
+		} else {
+			state->length = arg;
+			mem->offset += (size_t)arg;
+		}
+		break;
+	case DI_ARRAY:
+	case DI_MAP:
+		if (state->depth >= max_depth) {
+			return CBOR_ERROR_DEPTH;
+		}
+		if (!head->is_indef && mem->limit && arg > mem->limit - mem->offset) {
+			/* every element takes at least a byte */
+			return CBOR_ERROR_TRUNCATED_DATA;
+		}
+		reader_consume(state);
+		if (state->depth >= state->stack_size) {
+			state->stack_size = state->stack_size ? state->stack_size * 2 : SKIP_STACK_INIT_SIZE;
+			state->stack = safe_erealloc(state->stack, state->stack_size, sizeof *state->stack, 0);
+		}
+		top = &state->stack[state->depth++];
+		top->remaining = (head->type == DI_MAP) ? arg * 2 : arg;
+		top->is_indef = head->is_indef;
+		top->is_map = head->type == DI_MAP;
+		top->has_key = false;
+		return 0;
+	case DI_TAG:
+		state->in_tag = true;
+		return 0;
+	case DI_BREAK:
+		return state->depth ? E_DESC(CBOR_ERROR_SYNTAX, BREAK_UNEXPECTED) : E_DESC(CBOR_ERROR_SYNTAX, BREAK_UNDERFLOW);
+	}
+	if (error) {
+		return error;
+	}
+	reader_consume(state);
+	return 0;
+}
+
+/* Leave the container or the tag of the current token after it is read as a whole. */
+void cbor_reader_leave(cbor_reader_state *state)
+{
+	if (state->token == CBOR_TOKEN_ARRAY || state->token == CBOR_TOKEN_MAP) {
+		state->depth--;
+	} else if (state->token == CBOR_TOKEN_TAG) {
+		reader_consume(state);
+	}
+	state->is_left = true;
+}
+
+/* Skip the elements of the container, or the content of the tag, of the current token. */
+cbor_error cbor_reader_skip(cbor_reader_state *state, cbor_fragment *mem, uint32_t max_depth)
+{
+	cbor_error error;
+	if (state->is_left || (state->token != CBOR_TOKEN_ARRAY && state->token != CBOR_TOKEN_MAP && state->token != CBOR_TOKEN_TAG)) {
+		return 0;
+	}
+	mem->offset = state->offset;
+	if ((error = cbor_skip_item(mem, max_depth - state->token_depth)) != 0) {
+		return error;
+	}
+	cbor_reader_leave(state);
+	return 0;
+}
+
+/* Get the string of the current token; chunks of indefinite-length string are joined. */
+zend_string *cbor_reader_string(const cbor_reader_state *state, const cbor_fragment *mem)
+{
+	const cbor_di_head *head;
+	uint64_t arg;
+	cbor_fragment chunk;
+	zend_string *str;
+	char *ptr;
+	if (!state->is_indef) {
+		return zend_string_init_fast((const char *)&mem->ptr[state->content], (size_t)state->length);
+	}
+	str = zend_string_alloc((size_t)state->length, false);
+	ptr = ZSTR_VAL(str);
+	chunk = *mem;
+	chunk.offset = state->content;
+	/* chunks are checked on reading the token */
+	while (read_head(&chunk, &head, &arg) == 0 && head->type != DI_BREAK) {
+		memcpy(ptr, &chunk.ptr[chunk.offset], (size_t)arg);
+		ptr += (size_t)arg;
+		chunk.offset += (size_t)arg;
+	}
+	*ptr = '\0';
+	return str;
+}
+
+void cbor_reader_free(cbor_reader_state *state)
+{
+	if (state->stack) {
+		efree(state->stack);
+	}
+	memset(state, 0, sizeof *state);
+}
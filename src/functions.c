@@ -6,6 +6,7 @@
 #include "cbor.h"
 #include "codec.h"
 #include <Zend/zend_exceptions.h>
+#include <Zend/zend_interfaces.h>
 #include <assert.h>
 
 /* {{{ proto string cbor_encode(mixed $value, int $flags = CBOR_BYTE, ?array $options = [...])
@@ -36,6 +37,69 @@ PHP_FUNCTION(cbor_encode)
 /* }}} */
 
 
+/* {{{ proto string cbor_encode_sequence(iterable $values, int $flags = CBOR_BYTE, ?array $options = [...])
+   Return a CBOR sequence of the values. */
+PHP_FUNCTION(cbor_encode_sequence)
+{
+	zval *values;
+	zend_long flags = CBOR_BYTE | CBOR_KEY_BYTE;
+	HashTable *options = NULL;
+	zend_string *str = NULL;
+	cbor_error error;
+	cbor_encode_args args;
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "z|lh!", &values, &flags, &options) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	if (Z_TYPE_P(values) != IS_ARRAY
+			&& (Z_TYPE_P(values) != IS_OBJECT || !instanceof_function(Z_OBJCE_P(values), zend_ce_traversable))) {
+		zend_argument_type_error(1, "must be of type iterable, %s given", zend_zval_type_name(values));
+		RETURN_THROWS();
+	}
+	args.u_flags = (uint32_t)flags;
+	if ((error = cbor_set_encode_options(&args, options)) == 0
+			&& (error = cbor_check_encode_params(&args)) == 0) {
+		error = cbor_encode_sequence(values, &str, &args);
+	}
+	if (error) {
+		cbor_throw_error(error, false, &args.error_args);
+		RETURN_THROWS();
+	}
+	assert(str);
+	RETURN_STR(str);
+}
+/* }}} */
+
+
+/* {{{ proto int cbor_encode_to_stream(resource $stream, mixed $value, int $flags = CBOR_BYTE, ?array $options = [...])
+   Write a CBOR encoded value to a stream. */
+PHP_FUNCTION(cbor_encode_to_stream)
+{
+	zval *z_stream;
+	php_stream *stream;
+	zval *value;
+	zend_long flags = CBOR_BYTE | CBOR_KEY_BYTE;
+	HashTable *options = NULL;
+	size_t written = 0;
+	cbor_error error;
+	cbor_encode_args args;
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "rz|lh!", &z_stream, &value, &flags, &options) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	php_stream_from_zval(stream, z_stream);
+	args.u_flags = (uint32_t)flags;
+	if ((error = cbor_set_encode_options(&args, options)) == 0
+			&& (error = cbor_check_encode_params(&args)) == 0) {
+		error = cbor_encode_to_stream(value, stream, &written, &args);
+	}
+	if (error) {
+		cbor_throw_error(error, false, &args.error_args);
+		RETURN_THROWS();
+	}
+	RETURN_LONG((zend_long)written);
+}
+/* }}} */
+
+
 /* {{{ proto mixed cbor_decode(string $data, int $flags = CBOR_BYTE, ?array $options = [...])
    Decode a CBOR encoded string. */
 PHP_FUNCTION(cbor_decode)
@@ -64,6 +128,159 @@ PHP_FUNCTION(cbor_decode)
 }
 /* }}} */
 
+
+/* {{{ proto int|false cbor_validate(string $data, int $flags = CBOR_BYTE, ?array $options = [...])
+   Return the length of a CBOR data item if it can be decoded, false otherwise. */
+PHP_FUNCTION(cbor_validate)
+{
+	zend_string *data;
+	zend_long flags = CBOR_BYTE | CBOR_KEY_BYTE;
+	HashTable *options = NULL;
+	size_t length = 0;
+	cbor_error error;
+	cbor_decode_args args;
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "S|lh!", &data, &flags, &options) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	cbor_init_decode_options(&args);
+	args.flags = (uint32_t)flags;
+	error = cbor_set_decode_options(&args, options);
+	if (error) {
+		cbor_free_decode_options(&args);
+		cbor_throw_error(error, true, &args.error_args);
+		RETURN_THROWS();
+	}
+	error = cbor_validate(data, &length, &args);
+	cbor_free_decode_options(&args);
+	if (error) {
+		RETURN_FALSE;
+	}
+	RETURN_LONG((zend_long)length);
+}
+/* }}} */
+
+
+/* {{{ proto mixed cbor_extract(string $data, array $path, int $flags = CBOR_BYTE, ?array $options = [...])
+   Decode the item at the path of a CBOR encoded string. */
+PHP_FUNCTION(cbor_extract)
+{
+	zend_string *data;
+	HashTable *path;
+	zend_long flags = CBOR_BYTE | CBOR_KEY_BYTE;
+	HashTable *options = NULL;
+	zval *element;
+	zval value;
+	cbor_error error;
+	cbor_decode_args args;
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "Sh|lh!", &data, &path, &flags, &options) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	ZEND_HASH_FOREACH_VAL(path, element) {
+		ZVAL_DEREF(element);
+		if (Z_TYPE_P(element) != IS_LONG && Z_TYPE_P(element) != IS_STRING) {
+			zend_argument_type_error(2, "must contain only int or string elements, %s given", zend_zval_type_name(element));
+			RETURN_THROWS();
+		}
+	} ZEND_HASH_FOREACH_END();
+	cbor_init_decode_options(&args);
+	args.flags = (uint32_t)flags;
+	error = cbor_set_decode_options(&args, options);
+	if (!error) {
+		error = cbor_extract(data, path, &value, &args);
+	}
+	cbor_free_decode_options(&args);
+	if (error) {
+		cbor_throw_error(error, true, &args.error_args);
+		RETURN_THROWS();
+	}
+	RETVAL_COPY_VALUE(&value);
+}
+/* }}} */
+
+
+/* {{{ proto Cbor\Index cbor_index(string $data, int $flags = CBOR_BYTE, ?array $options = [...])
+   Return the index of the containers in a CBOR encoded string. */
+PHP_FUNCTION(cbor_index)
+{
+	zend_string *data;
+	zend_long flags = CBOR_BYTE | CBOR_KEY_BYTE;
+	HashTable *options = NULL;
+	cbor_error error;
+	cbor_decode_args args;
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "S|lh!", &data, &flags, &options) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	cbor_init_decode_options(&args);
+	args.flags = (uint32_t)flags;
+	error = cbor_set_decode_options(&args, options);
+	if (!error) {
+		error = cbor_index_new(return_value, data, &args);
+	}
+	if (error) {
+		cbor_free_decode_options(&args);
+		cbor_throw_error(error, true, &args.error_args);
+		RETURN_THROWS();
+	}
+}
+/* }}} */
+
+
+/* {{{ proto string cbor_to_json(string $data, int $flags = CBOR_BYTE, ?array $options = [...])
+   Convert a CBOR encoded string to JSON text. */
+PHP_FUNCTION(cbor_to_json)
+{
+	zend_string *data;
+	zend_long flags = CBOR_BYTE | CBOR_KEY_BYTE;
+	HashTable *options = NULL;
+	zval value;
+	cbor_error error;
+	cbor_decode_args args;
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "S|lh!", &data, &flags, &options) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	cbor_init_decode_options(&args);
+	args.flags = (uint32_t)flags;
+	error = cbor_set_decode_options(&args, options);
+	if (!error) {
+		error = cbor_to_json(data, &value, &args);
+	}
+	cbor_free_decode_options(&args);
+	if (error) {
+		cbor_throw_error(error, true, &args.error_args);
+		RETURN_THROWS();
+	}
+	RETVAL_COPY_VALUE(&value);
+}
+/* }}} */
+
+/* {{{ proto string cbor_from_json(string $json, int $flags = CBOR_BYTE, ?array $options = [...])
+   Convert JSON text to a CBOR encoded string. */
+PHP_FUNCTION(cbor_from_json)
+{
+	zend_string *json;
+	zend_long flags = CBOR_BYTE | CBOR_KEY_BYTE;
+	HashTable *options = NULL;
+	zend_string *str = NULL;
+	cbor_error error;
+	cbor_encode_args args;
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "S|lh!", &json, &flags, &options) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	args.u_flags = (uint32_t)flags;
+	if ((error = cbor_set_encode_options(&args, options)) == 0
+			&& (error = cbor_check_encode_params(&args)) == 0) {
+		error = cbor_from_json(json, &str, &args);
+	}
+	if (error) {
+		/* the offset is of the JSON text */
+		cbor_throw_error(error, true, &args.error_args);
+		RETURN_THROWS();
+	}
+	assert(str);
+	RETURN_STR(str);
+}
+/* }}} */
+
 #define DESC_MSG(m)  do { \
 		desc_msg = ". " m; \
 		goto MSG_SET; \
@@ -126,6 +343,10 @@ void cbor_throw_error(cbor_error error, bool decoding, const cbor_error_args *ar
 	case CBOR_ERROR_UTF8:
 		message = "Invalid UTF-8 sequences";
 		break;
+	case CBOR_ERROR_IO:
+		message = decoding ? "Failed to read from the stream" : "Failed to write to the stream";
+		can_have_offset = false;
+		break;
 	case CBOR_ERROR_UNSUPPORTED_TYPE:
 		message = "Unsupported data type";
 		if (!decoding) {
@@ -212,6 +433,10 @@ void cbor_throw_error(cbor_error error, bool decoding, const cbor_error_args *ar
 			DESC_MSG("Incompatible type is marked as shareable. Specify option ['shared_ref' => 'shareable'] to circumvent this");
 		case CBOR_ERROR_TAG_TYPE__SHARE_NOT_INT:
 			DESC_MSG("Sharedref expects integer");
+		case CBOR_ERROR_TAG_TYPE__DATETIME_NOT_TEXT:
+			DESC_MSG("Date/time string expects text string");
+		case CBOR_ERROR_TAG_TYPE__EPOCH_NOT_NUM:
+			DESC_MSG("Epoch-based date/time expects integer or float");
 		}
 		break;
 	case CBOR_ERROR_TAG_VALUE:
@@ -223,6 +448,10 @@ void cbor_throw_error(cbor_error error, bool decoding, const cbor_error_args *ar
 			DESC_MSG("Shareable cannot have sharedref pointing to itself to create recursion under ['shared_ref' => 'unsafe_ref']. Specify option ['shared_ref' => 'shareable'] to circumvent this");
 		case CBOR_ERROR_TAG_VALUE__SHARE_RANGE:
 			DESC_MSG("Sharedref is out of range");
+		case CBOR_ERROR_TAG_VALUE__DATETIME_SYNTAX:
+			DESC_MSG("Date/time string is not in RFC 3339 format");
+		case CBOR_ERROR_TAG_VALUE__EPOCH_RANGE:
+			DESC_MSG("Epoch-based date/time is out of range");
 		}
 		break;
 	case CBOR_ERROR_INTERNAL:
@@ -0,0 +1,178 @@
+/**
+ * @author SATO Kentaro
+ * @license BSD-2-Clause
+ */
+
+#include "cbor.h"
+#include "codec.h"
+#include "compatibility.h"
+#include "types.h"
+#include <Zend/zend_exceptions.h>
+
+typedef struct {
+	cbor_decode_args args;
+	cbor_index_table table;
+	size_t data_len;  /* length of the indexed data */
+	zend_ulong data_hash;  /* hash of the indexed data, cached in the string */
+	zend_object std;
+} index_class;
+
+static zend_object_handlers index_handlers;
+
+static zend_object *index_create(zend_class_entry *ce)
+{
+	index_class *base = zend_object_alloc(sizeof(index_class), ce);
+	cbor_init_decode_options(&base->args);
+	memset(&base->table, 0, sizeof base->table);
+	base->data_len = 0;
+	base->data_hash = 0;
+	zend_object_std_init(&base->std, ce);
+	base->std.handlers = &index_handlers;
+	return &base->std;
+}
+
+static void index_free(zend_object *obj)
+{
+	index_class *base = CUSTOM_OBJ(index_class, obj);
+	cbor_index_free(&base->table);
+	cbor_free_decode_options(&base->args);
+	zend_object_std_dtor(obj);
+}
+
+cbor_error cbor_index_new(zval *value, zend_string *data, cbor_decode_args *args)
+{
+	cbor_index_table table;
+	cbor_error error = cbor_index(data, &table, args);
+	if (error) {
+		return error;
+	}
+	object_init_ex(value, CBOR_CE(index));
+	index_class *base = ZVAL_CUSTOM_OBJ(index_class, value);
+	base->args = *args;
+	base->table = table;
+	base->data_len = ZSTR_LEN(data);
+	base->data_hash = zend_string_hash_val(data);
+	return 0;
+}
+
+/* Check if the data is the one indexed; the hash is computed once per string. */
+static bool check_data(index_class *base, zend_string *data)
+{
+	if (ZSTR_LEN(data) != base->data_len || zend_string_hash_val(data) != base->data_hash) {
+		zend_argument_value_error(1, "must be the data the index is created from");
+		return false;
+	}
+	return true;
+}
+
+static bool check_path(zval *path, uint32_t path_count, uint32_t arg_num)
+{
+	for (uint32_t i = 0; i < path_count; i++) {
+		zval *element = &path[i];
+		ZVAL_DEREF(element);
+		if (Z_TYPE_P(element) != IS_LONG && Z_TYPE_P(element) != IS_STRING) {
+			zend_argument_type_error(arg_num + i, "must be of type string|int, %s given", zend_zval_type_name(element));
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Get the range of the item at the path; args are adjusted to decode the item. */
+static bool locate_item(index_class *base, zend_string *data, zval *path, uint32_t path_count, cbor_decode_args *args, bool *found)
+{
+	cbor_error error;
+	cbor_fragment mem;
+	*args = base->args;
+	*found = true;
+	if (!path_count) {
+		return true;  /* decoded with the original range */
+	}
+	mem.ptr = (const uint8_t *)ZSTR_VAL(data);
+	mem.base = 0;
+	mem.offset = base->table.root;
+	mem.length = mem.limit = base->table.end;
+	error = cbor_index_find(&base->table, &mem, path, path_count, args, found);
+	if (error) {
+		args->error_args.offset = mem.base + mem.offset;
+		cbor_throw_error(error, true, &args->error_args);
+		return false;
+	}
+	if (*found) {
+		args->flags |= CBOR_SELF_DESCRIBE;  /* the tag belongs to the item */
+		args->max_depth -= path_count;
+		args->offset = (zend_long)mem.offset;
+		args->length = (zend_long)(mem.length - mem.offset);
+	}
+	return true;
+}
+
+PHP_METHOD(Cbor_Index, __construct)
+{
+	/* private constructor */
+	zend_throw_error(NULL, "You cannot instantiate %s.", ZSTR_VAL(Z_OBJ_P(ZEND_THIS)->ce->name));
+	RETURN_THROWS();
+}
+
+PHP_METHOD(Cbor_Index, get)
+{
+	index_class *base = CUSTOM_OBJ(index_class, Z_OBJ_P(ZEND_THIS));
+	zend_string *data;
+	zval *path = NULL;
+	uint32_t path_count = 0;
+	cbor_decode_args args;
+	cbor_error error;
+	bool found;
+	zval value;
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "S*", &data, &path, &path_count) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	if (!check_data(base, data) || !check_path(path, path_count, 2) || !locate_item(base, data, path, path_count, &args, &found)) {
+		RETURN_THROWS();
+	}
+	if (!found) {
+		RETURN_NULL();
+	}
+	error = cbor_decode(data, &value, &args);
+	if (error) {
+		cbor_throw_error(error, true, &args.error_args);
+		RETURN_THROWS();
+	}
+	RETVAL_COPY_VALUE(&value);
+}
+
+PHP_METHOD(Cbor_Index, locate)
+{
+	index_class *base = CUSTOM_OBJ(index_class, Z_OBJ_P(ZEND_THIS));
+	zend_string *data;
+	zval *path = NULL;
+	uint32_t path_count = 0;
+	cbor_decode_args args;
+	bool found;
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "S*", &data, &path, &path_count) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	if (!check_data(base, data) || !check_path(path, path_count, 2) || !locate_item(base, data, path, path_count, &args, &found)) {
+		RETURN_THROWS();
+	}
+	if (!found) {
+		RETURN_NULL();
+	}
+	array_init_size(return_value, 2);
+	add_next_index_long(return_value, args.offset);
+	add_next_index_long(return_value, args.length != LEN_DEFAULT ? args.length : (zend_long)(base->data_len - (size_t)args.offset));
+}
+
+void cbor_minit_index()
+{
+	CBOR_CE(index)->create_object = &index_create;
+#if TARGET_PHP_API_LT_81
+	CBOR_CE(index)->serialize = zend_class_serialize_deny;
+	CBOR_CE(index)->unserialize = zend_class_unserialize_deny;
+#endif
+	memcpy(&index_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+	index_handlers.offset = XtOffsetOf(index_class, std);
+	index_handlers.free_obj = &index_free;
+	index_handlers.clone_obj = NULL;
+	index_handlers.compare = zend_objects_not_comparable;
+}
@@ -0,0 +1,223 @@
+/**
+ * @author SATO Kentaro
+ * @license BSD-2-Clause
+ */
+
+#include "cbor.h"
+#include "codec.h"
+#include "compatibility.h"
+#include "types.h"
+#include <Zend/zend_exceptions.h>
+#include <Zend/zend_interfaces.h>
+#include <ext/spl/spl_array.h>
+
+typedef struct {
+	zend_string *data;  /* string the item is read from; released on materialization */
+	size_t offset;
+	size_t length;
+	uint32_t count;  /* number of elements, or pairs of map */
+	cbor_decode_args args;
+	zval value;  /* materialized value */
+	zend_object std;
+} lazy_value_class;
+
+static zend_object_handlers lazy_value_handlers;
+
+static zend_object *lazy_value_create(zend_class_entry *ce)
+{
+	lazy_value_class *base = zend_object_alloc(sizeof(lazy_value_class), ce);
+	base->data = NULL;
+	base->offset = base->length = 0;
+	base->count = 0;
+	cbor_init_decode_options(&base->args);
+	ZVAL_UNDEF(&base->value);
+	zend_object_std_init(&base->std, ce);
+	base->std.handlers = &lazy_value_handlers;
+	return &base->std;
+}
+
+static void lazy_value_free(zend_object *obj)
+{
+	lazy_value_class *base = CUSTOM_OBJ(lazy_value_class, obj);
+	if (base->data) {
+		zend_string_release(base->data);
+	}
+	zval_ptr_dtor(&base->value);
+	cbor_free_decode_options(&base->args);
+	zend_object_std_dtor(obj);
+}
+
+void cbor_lazy_value_init(zval *value, zend_string *data, size_t offset, size_t length, uint32_t count, const cbor_decode_args *args)
+{
+	object_init_ex(value, CBOR_CE(lazyvalue));
+	lazy_value_class *base = ZVAL_CUSTOM_OBJ(lazy_value_class, value);
+	base->data = zend_string_copy(data);
+	base->offset = offset;
+	base->length = length;
+	base->count = count;
+	base->args = *args;
+}
+
+/* Decode the item on the first access; nested containers may be lazy values again. */
+static zval *get_value(lazy_value_class *base)
+{
+	if (Z_TYPE(base->value) == IS_UNDEF) {
+		cbor_decode_args args = base->args;
+		cbor_error error = cbor_decode_item(base->data, base->offset, base->length, &base->value, &args);
+		if (error) {
+			cbor_throw_error(error, true, &args.error_args);
+			return NULL;
+		}
+		zend_string_release(base->data);
+		base->data = NULL;
+	}
+	return &base->value;
+}
+
+/* Get the decoded value of the lazy value, or NULL with an exception thrown. */
+zval *cbor_lazy_value_get(zval *value)
+{
+	return get_value(ZVAL_CUSTOM_OBJ(lazy_value_class, value));
+}
+
+static bool check_offset(zval *offset)
+{
+	ZVAL_DEREF(offset);
+	if (Z_TYPE_P(offset) != IS_LONG && Z_TYPE_P(offset) != IS_STRING) {
+		zend_argument_type_error(1, "must be of type string|int, %s given", zend_zval_type_name(offset));
+		return false;
+	}
+	return true;
+}
+
+/* Find the element of the array, or the property of stdClass, whose int key is a numeric string. */
+static zval *find_element(zval *value, zval *offset)
+{
+	ZVAL_DEREF(offset);
+	if (Z_TYPE_P(value) == IS_ARRAY) {
+		if (Z_TYPE_P(offset) == IS_LONG) {
+			return zend_hash_index_find(Z_ARRVAL_P(value), (zend_ulong)Z_LVAL_P(offset));
+		}
+		return zend_symtable_find(Z_ARRVAL_P(value), Z_STR_P(offset));
+	}
+	if (Z_TYPE_P(offset) == IS_LONG) {
+		char num_str[ZEND_LTOA_BUF_LEN];
+		ZEND_LTOA(Z_LVAL_P(offset), num_str, sizeof num_str);
+		return zend_hash_str_find(Z_OBJPROP_P(value), num_str, strlen(num_str));
+	}
+	return zend_hash_find(Z_OBJPROP_P(value), Z_STR_P(offset));
+}
+
+PHP_METHOD(Cbor_LazyValue, __construct)
+{
+	/* private constructor */
+	zend_throw_error(NULL, "You cannot instantiate %s.", ZSTR_VAL(Z_OBJ_P(ZEND_THIS)->ce->name));
+	RETURN_THROWS();
+}
+
+PHP_METHOD(Cbor_LazyValue, getValue)
+{
+	lazy_value_class *base = CUSTOM_OBJ(lazy_value_class, Z_OBJ_P(ZEND_THIS));
+	zval *value;
+	zend_parse_parameters_none();
+	if ((value = get_value(base)) == NULL) {
+		RETURN_THROWS();
+	}
+	RETURN_COPY(value);
+}
+
+PHP_METHOD(Cbor_LazyValue, offsetExists)
+{
+	lazy_value_class *base = CUSTOM_OBJ(lazy_value_class, Z_OBJ_P(ZEND_THIS));
+	zval *offset, *value, *element;
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "z", &offset) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	if (!check_offset(offset) || (value = get_value(base)) == NULL) {
+		RETURN_THROWS();
+	}
+	element = find_element(value, offset);
+	RETURN_BOOL(element != NULL && Z_TYPE_P(element) != IS_NULL);
+}
+
+PHP_METHOD(Cbor_LazyValue, offsetGet)
+{
+	lazy_value_class *base = CUSTOM_OBJ(lazy_value_class, Z_OBJ_P(ZEND_THIS));
+	zval *offset, *value, *element;
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "z", &offset) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	if (!check_offset(offset) || (value = get_value(base)) == NULL) {
+		RETURN_THROWS();
+	}
+	element = find_element(value, offset);
+	if (element == NULL) {
+		RETURN_NULL();
+	}
+	RETURN_COPY_DEREF(element);
+}
+
+PHP_METHOD(Cbor_LazyValue, offsetSet)
+{
+	zval *offset, *value;
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "zz", &offset, &value) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	zend_throw_error(NULL, "%s is read-only.", ZSTR_VAL(Z_OBJ_P(ZEND_THIS)->ce->name));
+	RETURN_THROWS();
+}
+
+PHP_METHOD(Cbor_LazyValue, offsetUnset)
+{
+	zval *offset;
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "z", &offset) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	zend_throw_error(NULL, "%s is read-only.", ZSTR_VAL(Z_OBJ_P(ZEND_THIS)->ce->name));
+	RETURN_THROWS();
+}
+
+PHP_METHOD(Cbor_LazyValue, getIterator)
+{
+	lazy_value_class *base = CUSTOM_OBJ(lazy_value_class, Z_OBJ_P(ZEND_THIS));
+	zval *value;
+	zend_parse_parameters_none();
+	if ((value = get_value(base)) == NULL) {
+		RETURN_THROWS();
+	}
+	object_init_ex(return_value, spl_ce_ArrayIterator);
+	zend_call_known_instance_method_with_1_params(spl_ce_ArrayIterator->constructor, Z_OBJ_P(return_value), NULL, value);
+}
+
+PHP_METHOD(Cbor_LazyValue, count)
+{
+	lazy_value_class *base = CUSTOM_OBJ(lazy_value_class, Z_OBJ_P(ZEND_THIS));
+	zend_parse_parameters_none();
+	/* the count is known from the head without decoding */
+	RETURN_LONG((zend_long)base->count);
+}
+
+PHP_METHOD(Cbor_LazyValue, jsonSerialize)
+{
+	lazy_value_class *base = CUSTOM_OBJ(lazy_value_class, Z_OBJ_P(ZEND_THIS));
+	zval *value;
+	zend_parse_parameters_none();
+	if ((value = get_value(base)) == NULL) {
+		RETURN_THROWS();
+	}
+	RETURN_COPY(value);
+}
+
+void cbor_minit_lazy_value()
+{
+	CBOR_CE(lazyvalue)->create_object = &lazy_value_create;
+#if TARGET_PHP_API_LT_81
+	CBOR_CE(lazyvalue)->serialize = zend_class_serialize_deny;
+	CBOR_CE(lazyvalue)->unserialize = zend_class_unserialize_deny;
+#endif
+	memcpy(&lazy_value_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+	lazy_value_handlers.offset = XtOffsetOf(lazy_value_class, std);
+	lazy_value_handlers.free_obj = &lazy_value_free;
+	lazy_value_handlers.clone_obj = NULL;
+	lazy_value_handlers.compare = zend_objects_not_comparable;
+}
@@ -103,7 +103,7 @@ static cbor_error uint32_option(uint32_t *opt_value, const char *name, size_t na
 cbor_error cbor_override_encode_options(cbor_encode_args *args, HashTable *options)
 {
 	cbor_error error = 0;
-	CHECK_ERROR(bool_option(&args->datetime, ZEND_STRL("datetime"), options));
+	CHECK_ERROR(bool_n_option(&args->datetime, ZEND_STRL("datetime"), "epoch\0", options));
 	CHECK_ERROR(bool_option(&args->bignum, ZEND_STRL("bignum"), options));
 	CHECK_ERROR(bool_option(&args->decimal, ZEND_STRL("decimal"), options));
 	CHECK_ERROR(bool_option(&args->uri, ZEND_STRL("uri"), options));
@@ -117,7 +117,7 @@ cbor_error cbor_set_encode_options(cbor_encode_args *args, HashTable *options)
 	args->max_depth = 64;
 	args->string_ref = 0;
 	args->shared_ref = 0;
-	args->datetime = true;
+	args->datetime = OPT_TRUE;
 	args->bignum = true;
 	args->decimal = true;
 	args->uri = true;
@@ -161,6 +161,9 @@ void cbor_init_decode_options(cbor_decode_args *args)
 	args->length = LEN_DEFAULT;
 	args->string_ref = true;
 	args->shared_ref = 0;
+	args->string_cache = OPT_TRUE;
+	args->datetime = false;
+	args->lazy = 0;
 	args->edn.indent = 0;
 	args->edn.indent_char = 0;
 	args->edn.space = true;
@@ -188,6 +191,9 @@ cbor_error cbor_set_decode_options(cbor_decode_args *args, HashTable *options)
 	CHECK_ERROR(long_option(&args->length, ZEND_STRL("length"), 0, ZEND_LONG_MAX, options, true));
 	CHECK_ERROR(bool_option(&args->string_ref, ZEND_STRL("string_ref"), options));
 	CHECK_ERROR(bool_n_option(&args->shared_ref, ZEND_STRL("shared_ref"), "shareable\0shareable_only\0unsafe_ref\0", options));
+	CHECK_ERROR(bool_n_option(&args->string_cache, ZEND_STRL("string_cache"), "all\0", options));
+	CHECK_ERROR(bool_option(&args->datetime, ZEND_STRL("datetime"), options));
+	CHECK_ERROR(uint32_option(&args->lazy, ZEND_STRL("lazy"), 0, 0xffffffff, options));
 	if (args->flags & CBOR_EDN) {
 		zval *opt_val;
 		opt_val = zend_hash_str_find_deref(options, ZEND_STRL("indent"));
@@ -33,7 +33,13 @@ extern zend_class_entry
 	*CBOR_CE(float32),
 	*CBOR_CE(tag),
 	*CBOR_CE(shareable),
-	*CBOR_CE(decoder)
+	*CBOR_CE(decoder),
+	*CBOR_CE(encoder),
+	*CBOR_CE(sequencereader),
+	*CBOR_CE(lazyvalue),
+	*CBOR_CE(index),
+	*CBOR_CE(reader),
+	*CBOR_CE(writer)
 	/* ce end */
 ;
 
@@ -0,0 +1,476 @@
+/**
+ * @author SATO Kentaro
+ * @license BSD-2-Clause
+ */
+
+#include "cbor.h"
+#include "codec.h"
+#include "compatibility.h"
+#include "di.h"
+#include "types.h"
+#include "utf8.h"
+#include <Zend/zend_exceptions.h>
+
+#define READ_CHUNK_SIZE  8192
+
+typedef struct {
+	cbor_decode_args args;
+	zend_string *data;  /* string the tokens are read from */
+	zval z_stream;  /* or stream whose content is mapped to memory or read into the buffer */
+	zend_string *buffer;  /* window of the stream not supporting mmap; mem.base is its offset in the stream */
+	size_t stream_end;  /* of the data to read from the stream, or SIZE_MAX */
+	bool is_eof;
+	cbor_fragment mem;
+	cbor_reader_state state;
+	zend_object std;
+} reader_class;
+
+static zend_object_handlers reader_handlers;
+
+static zend_object *reader_create(zend_class_entry *ce)
+{
+	reader_class *base = zend_object_alloc(sizeof(reader_class), ce);
+	cbor_init_decode_options(&base->args);
+	base->data = NULL;
+	ZVAL_UNDEF(&base->z_stream);
+	base->buffer = NULL;
+	base->stream_end = SIZE_MAX;
+	base->is_eof = false;
+	memset(&base->mem, 0, sizeof base->mem);
+	memset(&base->state, 0, sizeof base->state);
+	zend_object_std_init(&base->std, ce);
+	base->std.handlers = &reader_handlers;
+	return &base->std;
+}
+
+static void reader_release(reader_class *base)
+{
+	if (base->data) {
+		zend_string_release(base->data);
+		base->data = NULL;
+	}
+	if (Z_TYPE(base->z_stream) != IS_UNDEF) {
+		/* the stream may have been closed already on shutdown */
+		php_stream *stream = zend_fetch_resource2_ex(&base->z_stream, NULL, php_file_le_stream(), php_file_le_pstream());
+		if (stream && !base->buffer) {
+			php_stream_mmap_unmap(stream);
+		}
+		zval_ptr_dtor(&base->z_stream);  /* closes the stream */
+		ZVAL_UNDEF(&base->z_stream);
+	}
+	if (base->buffer) {
+		zend_string_release(base->buffer);
+		base->buffer = NULL;
+	}
+	base->stream_end = SIZE_MAX;
+	base->is_eof = false;
+	memset(&base->mem, 0, sizeof base->mem);
+	cbor_reader_free(&base->state);
+}
+
+static void reader_free(zend_object *obj)
+{
+	reader_class *base = CUSTOM_OBJ(reader_class, obj);
+	reader_release(base);
+	cbor_free_decode_options(&base->args);
+	zend_object_std_dtor(obj);
+}
+
+static bool init_args(cbor_decode_args *args, zend_long flags, HashTable *options)
+{
+	cbor_init_decode_options(args);
+	args->flags = (uint32_t)flags;
+	cbor_error error = cbor_set_decode_options(args, options);
+	if (error) {
+		cbor_free_decode_options(args);
+		cbor_throw_error(error, true, NULL);
+		return false;
+	}
+	return true;
+}
+
+/* Set the range of the data to read; 'offset' and 'length' options are applied. */
+static bool init_mem(reader_class *base, const char *ptr, size_t len)
+{
+	cbor_fragment *mem = &base->mem;
+	const cbor_decode_args *args = &base->args;
+	size_t offset = (size_t)args->offset;
+	if (offset > len
+			|| (args->length != LEN_DEFAULT && (size_t)args->length > len - offset)) {
+		cbor_error_args error_args = {0};
+		error_args.offset = len;
+		cbor_throw_error(CBOR_ERROR_TRUNCATED_DATA, true, &error_args);
+		return false;
+	}
+	mem->ptr = (const uint8_t *)ptr;
+	mem->base = 0;
+	mem->offset = offset;
+	mem->length = args->length != LEN_DEFAULT ? offset + (size_t)args->length : len;
+	mem->limit = mem->length;
+	return true;
+}
+
+/* Drop the data before the offset from the buffer; tokens before the offset are no longer referred to. */
+static void compact_buffer(reader_class *base)
+{
+	cbor_fragment *mem = &base->mem;
+	char *ptr = ZSTR_VAL(base->buffer);
+	if (!mem->offset) {
+		return;
+	}
+	memmove(ptr, &ptr[mem->offset], mem->length - mem->offset);
+	mem->length -= mem->offset;
+	if (mem->limit) {
+		mem->limit -= mem->offset;
+	}
+	mem->base += mem->offset;
+	mem->offset = 0;
+}
+
+/* Read more data from the stream into the buffer, growing the buffer if it is full; return false at the end of data. */
+static bool fill_buffer(reader_class *base)
+{
+	cbor_fragment *mem = &base->mem;
+	php_stream *stream;
+	size_t size = ZSTR_LEN(base->buffer);
+	size_t read_len;
+	ssize_t result;
+	if (base->is_eof) {
+		return false;
+	}
+	stream = zend_fetch_resource2_ex(&base->z_stream, NULL, php_file_le_stream(), php_file_le_pstream());
+	if (mem->length == size) {
+		size *= 2;
+		base->buffer = zend_string_realloc(base->buffer, size, false);
+		mem->ptr = (const uint8_t *)ZSTR_VAL(base->buffer);
+	}
+	read_len = size - mem->length;
+	if (base->stream_end - (mem->base + mem->length) < read_len) {
+		read_len = base->stream_end - (mem->base + mem->length);
+	}
+	if (!stream || !read_len
+			|| (result = php_stream_read(stream, ZSTR_VAL(base->buffer) + mem->length, read_len)) <= 0) {
+		base->is_eof = true;
+		mem->limit = mem->length;
+		return false;
+	}
+	mem->length += (size_t)result;
+	return true;
+}
+
+/* Read the next token from the stream; the buffer is refilled while the token is truncated,
+ * so that it holds the current token, including the string, but not the data before it. */
+static cbor_error stream_next(reader_class *base)
+{
+	cbor_fragment *mem = &base->mem;
+	cbor_error error;
+	size_t offset;
+	compact_buffer(base);
+	if (mem->offset == mem->length) {
+		fill_buffer(base);  /* to tell the end of data or a break */
+	}
+	offset = mem->offset;
+	while ((error = cbor_reader_next(&base->state, mem, base->args.max_depth)) == CBOR_ERROR_TRUNCATED_DATA
+			&& fill_buffer(base)) {
+		mem->offset = offset;
+	}
+	if (!error && base->state.token == CBOR_TOKEN_NONE
+			&& base->stream_end != SIZE_MAX && mem->base + mem->length < base->stream_end) {
+		/* shorter than the 'length' option */
+		error = CBOR_ERROR_TRUNCATED_DATA;
+	}
+	return error;
+}
+
+/* Skip the current container or tag token by token, so that the buffer does not hold the whole item. */
+static cbor_error stream_skip(reader_class *base)
+{
+	cbor_reader_state *state = &base->state;
+	cbor_reader_state token = *state;
+	size_t token_base = base->mem.base;
+	cbor_error error;
+	if (state->is_left || (state->token != CBOR_TOKEN_ARRAY && state->token != CBOR_TOKEN_MAP && state->token != CBOR_TOKEN_TAG)) {
+		return 0;
+	}
+	do {
+		if ((error = stream_next(base)) != 0) {
+			return error;
+		}
+	} while (state->in_tag || state->depth > token.token_depth);
+	/* restore the token as cbor_reader_skip() leaves it; the offsets relative to the compacted buffer
+	 * may wrap around, and offset() gets the original one by adding mem.base back */
+	state->token = token.token;
+	state->token_depth = token.token_depth;
+	state->type = token.type;
+	state->is_indef = token.is_indef;
+	state->arg = token.arg;
+	state->offset = token.offset + token_base - base->mem.base;
+	state->content = token.content + token_base - base->mem.base;
+	state->is_left = true;
+	return 0;
+}
+
+/* Throw the error at the offset and stop reading. */
+static void throw_error(reader_class *base, cbor_error error, size_t offset)
+{
+	cbor_error_args error_args = {0};
+	error_args.offset = offset;
+	base->mem.offset = base->mem.length;
+	if (base->buffer) {
+		base->is_eof = true;
+		base->stream_end = base->mem.base + base->mem.length;
+	}
+	base->state.depth = 0;
+	base->state.in_tag = false;
+	base->state.token = CBOR_TOKEN_NONE;
+	cbor_throw_error(error, true, &error_args);
+}
+
+static bool check_token(bool is_valid, const char *desc)
+{
+	if (!is_valid) {
+		zend_throw_error(NULL, "The current token is not %s.", desc);
+		return false;
+	}
+	return true;
+}
+
+PHP_METHOD(Cbor_Reader, __construct)
+{
+	reader_class *base = CUSTOM_OBJ(reader_class, Z_OBJ_P(ZEND_THIS));
+	zend_string *data;
+	zend_long flags = CBOR_BYTE | CBOR_KEY_BYTE;
+	HashTable *options = NULL;
+	cbor_decode_args args;
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "S|lh!", &data, &flags, &options) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	if (!init_args(&args, flags, options)) {
+		RETURN_THROWS();
+	}
+	reader_release(base);
+	cbor_free_decode_options(&base->args);
+	base->args = args;
+	if (!init_mem(base, ZSTR_VAL(data), ZSTR_LEN(data))) {
+		RETURN_THROWS();
+	}
+	base->data = zend_string_copy(data);
+}
+
+PHP_METHOD(Cbor_Reader, fromFile)
+{
+	zend_string *filename;
+	zend_long flags = CBOR_BYTE | CBOR_KEY_BYTE;
+	HashTable *options = NULL;
+	cbor_decode_args args;
+	php_stream *stream;
+	char *ptr;
+	size_t len = 0;
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "P|lh!", &filename, &flags, &options) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	if (!init_args(&args, flags, options)) {
+		RETURN_THROWS();
+	}
+	stream = php_stream_open_wrapper(ZSTR_VAL(filename), "rb", REPORT_ERRORS, NULL);
+	if (!stream) {
+		cbor_free_decode_options(&args);
+		cbor_throw_error(CBOR_ERROR_IO, true, NULL);
+		RETURN_THROWS();
+	}
+	ptr = php_stream_mmap_range(stream, 0, PHP_STREAM_MMAP_ALL, PHP_STREAM_MAP_MODE_SHARED_READONLY, &len);
+	object_init_ex(return_value, CBOR_CE(reader));
+	reader_class *base = CUSTOM_OBJ(reader_class, Z_OBJ_P(return_value));
+	base->args = args;
+	php_stream_to_zval(stream, &base->z_stream);
+	if (!ptr) {
+		/* read through the buffer, e.g. for an empty file or a stream not supporting mmap */
+		cbor_fragment *mem = &base->mem;
+		size_t offset = (size_t)args.offset;
+		if (offset && php_stream_seek(stream, (zend_off_t)offset, SEEK_SET) != 0) {
+			cbor_error_args error_args = {0};
+			error_args.offset = offset;
+			zval_ptr_dtor(return_value);
+			ZVAL_NULL(return_value);
+			cbor_throw_error(CBOR_ERROR_TRUNCATED_DATA, true, &error_args);
+			RETURN_THROWS();
+		}
+		base->buffer = zend_string_alloc(READ_CHUNK_SIZE, false);
+		base->stream_end = args.length != LEN_DEFAULT ? offset + (size_t)args.length : SIZE_MAX;
+		mem->ptr = (const uint8_t *)ZSTR_VAL(base->buffer);
+		mem->base = offset;
+		mem->offset = mem->length = mem->limit = 0;
+		return;
+	}
+	if (!init_mem(base, ptr, len)) {
+		zval_ptr_dtor(return_value);
+		ZVAL_NULL(return_value);
+		RETURN_THROWS();
+	}
+}
+
+PHP_METHOD(Cbor_Reader, next)
+{
+	reader_class *base = CUSTOM_OBJ(reader_class, Z_OBJ_P(ZEND_THIS));
+	zend_parse_parameters_none();
+	cbor_error error = base->buffer ? stream_next(base) : cbor_reader_next(&base->state, &base->mem, base->args.max_depth);
+	if (error) {
+		throw_error(base, error, base->mem.base + base->mem.offset);
+		RETURN_THROWS();
+	}
+	RETURN_LONG(base->state.token);
+}
+
+PHP_METHOD(Cbor_Reader, depth)
+{
+	reader_class *base = CUSTOM_OBJ(reader_class, Z_OBJ_P(ZEND_THIS));
+	zend_parse_parameters_none();
+	RETURN_LONG((zend_long)base->state.token_depth);
+}
+
+PHP_METHOD(Cbor_Reader, offset)
+{
+	reader_class *base = CUSTOM_OBJ(reader_class, Z_OBJ_P(ZEND_THIS));
+	zend_parse_parameters_none();
+	RETURN_LONG((zend_long)(base->mem.base + base->state.offset));
+}
+
+PHP_METHOD(Cbor_Reader, length)
+{
+	reader_class *base = CUSTOM_OBJ(reader_class, Z_OBJ_P(ZEND_THIS));
+	cbor_reader_state *state = &base->state;
+	zend_parse_parameters_none();
+	if (!check_token(state->token == CBOR_TOKEN_BYTE || state->token == CBOR_TOKEN_TEXT
+			|| state->token == CBOR_TOKEN_ARRAY || state->token == CBOR_TOKEN_MAP, "a string, an array or a map")) {
+		RETURN_THROWS();
+	}
+	if (state->token == CBOR_TOKEN_BYTE || state->token == CBOR_TOKEN_TEXT) {
+		RETURN_LONG((zend_long)state->length);
+	}
+	if (state->is_indef) {
+		RETURN_NULL();
+	}
+	RETURN_LONG((zend_long)state->arg);  /* not larger than the data */
+}
+
+PHP_METHOD(Cbor_Reader, intValue)
+{
+	reader_class *base = CUSTOM_OBJ(reader_class, Z_OBJ_P(ZEND_THIS));
+	cbor_reader_state *state = &base->state;
+	zend_parse_parameters_none();
+	if (!check_token(state->token == CBOR_TOKEN_INT || state->token == CBOR_TOKEN_TAG || state->token == CBOR_TOKEN_SIMPLE, "an integer, a tag or a simple value")) {
+		RETURN_THROWS();
+	}
+	if (state->arg > (uint64_t)ZEND_LONG_MAX) {
+		cbor_error_args error_args = {0};
+		error_args.offset = base->mem.base + state->offset;
+		cbor_throw_error(E_DESC(CBOR_ERROR_UNSUPPORTED_VALUE, INT_RANGE), true, &error_args);
+		RETURN_THROWS();
+	}
+	if (state->type == DI_NINT) {
+		RETURN_LONG(-1 - (zend_long)state->arg);
+	}
+	RETURN_LONG((zend_long)state->arg);
+}
+
+PHP_METHOD(Cbor_Reader, floatValue)
+{
+	reader_class *base = CUSTOM_OBJ(reader_class, Z_OBJ_P(ZEND_THIS));
+	cbor_reader_state *state = &base->state;
+	zend_parse_parameters_none();
+	if (!check_token(state->token == CBOR_TOKEN_FLOAT, "a float")) {
+		RETURN_THROWS();
+	}
+	if (state->type == DI_FLOAT16) {
+		RETURN_DOUBLE(cbor_from_fp16i((cbor_fp16i)state->arg));
+	} else if (state->type == DI_FLOAT32) {
+		binary32_alias binary32;
+		binary32.i = (uint32_t)state->arg;
+		RETURN_DOUBLE(cbor_from_fp32(binary32.f));
+	}
+	binary64_alias binary64;
+	binary64.i = state->arg;
+	RETURN_DOUBLE(binary64.f);
+}
+
+PHP_METHOD(Cbor_Reader, stringValue)
+{
+	reader_class *base = CUSTOM_OBJ(reader_class, Z_OBJ_P(ZEND_THIS));
+	cbor_reader_state *state = &base->state;
+	zend_string *str;
+	zend_parse_parameters_none();
+	if (!check_token(state->token == CBOR_TOKEN_BYTE || state->token == CBOR_TOKEN_TEXT, "a string")) {
+		RETURN_THROWS();
+	}
+	str = cbor_reader_string(state, &base->mem);
+	if (state->token == CBOR_TOKEN_TEXT && !(base->args.flags & CBOR_UNSAFE_TEXT)
+			&& !is_utf8((const uint8_t *)ZSTR_VAL(str), ZSTR_LEN(str))) {
+		cbor_error_args error_args = {0};
+		error_args.offset = base->mem.base + state->offset;
+		zend_string_release(str);
+		cbor_throw_error(CBOR_ERROR_UTF8, true, &error_args);
+		RETURN_THROWS();
+	}
+	RETURN_STR(str);
+}
+
+PHP_METHOD(Cbor_Reader, skip)
+{
+	reader_class *base = CUSTOM_OBJ(reader_class, Z_OBJ_P(ZEND_THIS));
+	zend_parse_parameters_none();
+	cbor_error error = base->buffer ? stream_skip(base) : cbor_reader_skip(&base->state, &base->mem, base->args.max_depth);
+	if (error) {
+		throw_error(base, error, base->mem.base + base->mem.offset);
+		RETURN_THROWS();
+	}
+}
+
+PHP_METHOD(Cbor_Reader, decode)
+{
+	reader_class *base = CUSTOM_OBJ(reader_class, Z_OBJ_P(ZEND_THIS));
+	cbor_reader_state *state = &base->state;
+	zend_parse_parameters_none();
+	if (!check_token(state->token != CBOR_TOKEN_NONE && state->token != CBOR_TOKEN_END && !state->is_left, "a data item to decode")) {
+		RETURN_THROWS();
+	}
+	cbor_decode_args args = base->args;  /* Make a copy of decoding args. */
+	args.flags |= CBOR_SELF_DESCRIBE;  /* the tag belongs to the item */
+	args.max_depth -= state->token_depth;
+	cbor_fragment mem;
+	cbor_decode_context *ctx;
+	cbor_error error;
+	for (;;) {
+		mem = base->mem;
+		mem.offset = state->offset;
+		ctx = cbor_decode_new(&args, &mem);
+		error = cbor_decode_process(ctx);
+		if (error != CBOR_ERROR_TRUNCATED_DATA || !base->buffer || !fill_buffer(base)) {
+			break;
+		}
+		/* decode the item again with more data of the stream */
+		cbor_decode_delete(ctx);
+	}
+	error = cbor_decode_finish(ctx, &args, error, return_value);
+	cbor_decode_delete(ctx);
+	if (error) {
+		/* the item can still be skipped */
+		cbor_throw_error(error, true, &args.error_args);
+		RETURN_THROWS();
+	}
+	base->mem.offset = mem.offset;
+	cbor_reader_leave(state);
+}
+
+void cbor_minit_reader()
+{
+	CBOR_CE(reader)->create_object = &reader_create;
+#if TARGET_PHP_API_LT_81
+	CBOR_CE(reader)->serialize = zend_class_serialize_deny;
+	CBOR_CE(reader)->unserialize = zend_class_unserialize_deny;
+#endif
+	memcpy(&reader_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+	reader_handlers.offset = XtOffsetOf(reader_class, std);
+	reader_handlers.free_obj = &reader_free;
+	reader_handlers.clone_obj = NULL;
+	reader_handlers.compare = zend_objects_not_comparable;
+}
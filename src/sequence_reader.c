@@ -0,0 +1,252 @@
+/**
+ * @author SATO Kentaro
+ * @license BSD-2-Clause
+ */
+
+#include "cbor.h"
+#include "codec.h"
+#include "compatibility.h"
+#include "types.h"
+#include <Zend/zend_exceptions.h>
+#include <Zend/zend_interfaces.h>
+#include <assert.h>
+
+typedef struct {
+	cbor_decode_args args;
+	zend_string *data;  /* string the sequence is read from */
+	zval z_stream;  /* or stream whose content is mapped to memory */
+	cbor_fragment mem;
+	size_t start_offset;
+	size_t cur_offset;  /* offset of the current item */
+	zval value;
+	zend_object std;
+} sequence_reader_class;
+
+static zend_object_handlers sequence_reader_handlers;
+
+static zend_object *sequence_reader_create(zend_class_entry *ce)
+{
+	sequence_reader_class *base = zend_object_alloc(sizeof(sequence_reader_class), ce);
+	cbor_init_decode_options(&base->args);
+	base->data = NULL;
+	ZVAL_UNDEF(&base->z_stream);
+	memset(&base->mem, 0, sizeof base->mem);
+	base->start_offset = base->cur_offset = 0;
+	ZVAL_UNDEF(&base->value);
+	zend_object_std_init(&base->std, ce);
+	base->std.handlers = &sequence_reader_handlers;
+	return &base->std;
+}
+
+static void sequence_reader_release(sequence_reader_class *base)
+{
+	if (base->data) {
+		zend_string_release(base->data);
+		base->data = NULL;
+	}
+	if (Z_TYPE(base->z_stream) != IS_UNDEF) {
+		/* the stream may have been closed already on shutdown */
+		php_stream *stream = zend_fetch_resource2_ex(&base->z_stream, NULL, php_file_le_stream(), php_file_le_pstream());
+		if (stream) {
+			php_stream_mmap_unmap(stream);
+		}
+		zval_ptr_dtor(&base->z_stream);  /* closes the stream */
+		ZVAL_UNDEF(&base->z_stream);
+	}
+	memset(&base->mem, 0, sizeof base->mem);
+	zval_ptr_dtor(&base->value);
+	ZVAL_UNDEF(&base->value);
+}
+
+static void sequence_reader_free(zend_object *obj)
+{
+	sequence_reader_class *base = CUSTOM_OBJ(sequence_reader_class, obj);
+	sequence_reader_release(base);
+	cbor_free_decode_options(&base->args);
+	zend_object_std_dtor(obj);
+}
+
+static bool init_args(cbor_decode_args *args, zend_long flags, HashTable *options)
+{
+	cbor_init_decode_options(args);
+	args->flags = (uint32_t)flags;
+	cbor_error error = cbor_set_decode_options(args, options);
+	if (error) {
+		cbor_free_decode_options(args);
+		cbor_throw_error(error, true, NULL);
+		return false;
+	}
+	return true;
+}
+
+/* Set the range of the data to read; 'offset' and 'length' options are applied. */
+static bool init_mem(sequence_reader_class *base, const char *ptr, size_t len)
+{
+	cbor_fragment *mem = &base->mem;
+	const cbor_decode_args *args = &base->args;
+	size_t offset = (size_t)args->offset;
+	if (offset > len
+			|| (args->length != LEN_DEFAULT && (size_t)args->length > len - offset)) {
+		cbor_error_args error_args = {0};
+		error_args.offset = len;
+		cbor_throw_error(CBOR_ERROR_TRUNCATED_DATA, true, &error_args);
+		return false;
+	}
+	mem->ptr = (const uint8_t *)ptr;
+	mem->base = 0;
+	mem->offset = offset;
+	mem->length = args->length != LEN_DEFAULT ? offset + (size_t)args->length : len;
+	mem->limit = mem->length;
+	base->start_offset = base->cur_offset = mem->offset;
+	return true;
+}
+
+/* Decode the next data item in place. */
+static bool read_item(sequence_reader_class *base)
+{
+	cbor_fragment *mem = &base->mem;
+	zval_ptr_dtor(&base->value);
+	ZVAL_UNDEF(&base->value);
+	base->cur_offset = mem->offset;
+	if (mem->offset >= mem->length) {
+		return true;
+	}
+	cbor_decode_args args = base->args;  /* Make a copy of decoding args. */
+	cbor_decode_context *ctx = cbor_decode_new(&args, mem);
+	cbor_error error = cbor_decode_process(ctx);
+	error = cbor_decode_finish(ctx, &args, error, &base->value);
+	cbor_decode_delete(ctx);
+	if (error) {
+		mem->offset = mem->length;  /* stop iteration */
+		cbor_throw_error(error, true, &args.error_args);
+		return false;
+	}
+	return true;
+}
+
+PHP_METHOD(Cbor_SequenceReader, __construct)
+{
+	sequence_reader_class *base = CUSTOM_OBJ(sequence_reader_class, Z_OBJ_P(ZEND_THIS));
+	zend_string *data;
+	zend_long flags = CBOR_BYTE | CBOR_KEY_BYTE;
+	HashTable *options = NULL;
+	cbor_decode_args args;
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "S|lh!", &data, &flags, &options) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	if (!init_args(&args, flags, options)) {
+		RETURN_THROWS();
+	}
+	sequence_reader_release(base);
+	cbor_free_decode_options(&base->args);
+	base->args = args;
+	if (!init_mem(base, ZSTR_VAL(data), ZSTR_LEN(data))) {
+		RETURN_THROWS();
+	}
+	base->data = zend_string_copy(data);
+}
+
+PHP_METHOD(Cbor_SequenceReader, fromFile)
+{
+	zend_string *filename;
+	zend_long flags = CBOR_BYTE | CBOR_KEY_BYTE;
+	HashTable *options = NULL;
+	cbor_decode_args args;
+	php_stream *stream;
+	char *ptr;
+	size_t len = 0;
+	zend_string *data = NULL;
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "P|lh!", &filename, &flags, &options) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	if (!init_args(&args, flags, options)) {
+		RETURN_THROWS();
+	}
+	stream = php_stream_open_wrapper(ZSTR_VAL(filename), "rb", REPORT_ERRORS, NULL);
+	if (!stream) {
+		cbor_free_decode_options(&args);
+		cbor_throw_error(CBOR_ERROR_IO, true, NULL);
+		RETURN_THROWS();
+	}
+	ptr = php_stream_mmap_range(stream, 0, PHP_STREAM_MMAP_ALL, PHP_STREAM_MAP_MODE_SHARED_READONLY, &len);
+	if (!ptr) {
+		/* fall back to reading the whole content, e.g. for an empty file or a stream not supporting mmap */
+		data = php_stream_copy_to_mem(stream, PHP_STREAM_COPY_ALL, false);
+		php_stream_close(stream);
+		stream = NULL;
+		if (!data) {
+			data = ZSTR_EMPTY_ALLOC();
+		}
+		ptr = ZSTR_VAL(data);
+		len = ZSTR_LEN(data);
+	}
+	object_init_ex(return_value, CBOR_CE(sequencereader));
+	sequence_reader_class *base = CUSTOM_OBJ(sequence_reader_class, Z_OBJ_P(return_value));
+	base->args = args;
+	base->data = data;
+	if (stream) {
+		php_stream_to_zval(stream, &base->z_stream);
+	}
+	if (!init_mem(base, ptr, len)) {
+		zval_ptr_dtor(return_value);
+		ZVAL_NULL(return_value);
+		RETURN_THROWS();
+	}
+}
+
+PHP_METHOD(Cbor_SequenceReader, current)
+{
+	sequence_reader_class *base = CUSTOM_OBJ(sequence_reader_class, Z_OBJ_P(ZEND_THIS));
+	zend_parse_parameters_none();
+	if (Z_TYPE(base->value) == IS_UNDEF) {
+		RETURN_NULL();
+	}
+	RETURN_COPY(&base->value);
+}
+
+PHP_METHOD(Cbor_SequenceReader, key)
+{
+	sequence_reader_class *base = CUSTOM_OBJ(sequence_reader_class, Z_OBJ_P(ZEND_THIS));
+	zend_parse_parameters_none();
+	RETURN_LONG((zend_long)base->cur_offset);
+}
+
+PHP_METHOD(Cbor_SequenceReader, next)
+{
+	sequence_reader_class *base = CUSTOM_OBJ(sequence_reader_class, Z_OBJ_P(ZEND_THIS));
+	zend_parse_parameters_none();
+	if (!read_item(base)) {
+		RETURN_THROWS();
+	}
+}
+
+PHP_METHOD(Cbor_SequenceReader, rewind)
+{
+	sequence_reader_class *base = CUSTOM_OBJ(sequence_reader_class, Z_OBJ_P(ZEND_THIS));
+	zend_parse_parameters_none();
+	base->mem.offset = base->start_offset;
+	if (!read_item(base)) {
+		RETURN_THROWS();
+	}
+}
+
+PHP_METHOD(Cbor_SequenceReader, valid)
+{
+	sequence_reader_class *base = CUSTOM_OBJ(sequence_reader_class, Z_OBJ_P(ZEND_THIS));
+	zend_parse_parameters_none();
+	RETURN_BOOL(Z_TYPE(base->value) != IS_UNDEF);
+}
+
+void cbor_minit_sequence_reader()
+{
+	CBOR_CE(sequencereader)->create_object = &sequence_reader_create;
+#if TARGET_PHP_API_LT_81
+	CBOR_CE(sequencereader)->serialize = zend_class_serialize_deny;
+	CBOR_CE(sequencereader)->unserialize = zend_class_unserialize_deny;
+#endif
+	memcpy(&sequence_reader_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+	sequence_reader_handlers.offset = XtOffsetOf(sequence_reader_class, std);
+	sequence_reader_handlers.free_obj = &sequence_reader_free;
+	sequence_reader_handlers.clone_obj = NULL;
+	sequence_reader_handlers.compare = zend_objects_not_comparable;
+}
@@ -1001,4 +1001,10 @@ void cbor_minit_types()
 
 	cbor_minit_types_float_cast();
 	cbor_minit_decoder();
+	cbor_minit_encoder();
+	cbor_minit_sequence_reader();
+	cbor_minit_lazy_value();
+	cbor_minit_index();
+	cbor_minit_reader();
+	cbor_minit_writer();
 }
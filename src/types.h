@@ -56,3 +56,21 @@ cbor_fp16i cbor_float_64_to_16_cast(double value);
 
 /* decoder */
 void cbor_minit_decoder();
+
+/* encoder */
+void cbor_minit_encoder();
+
+/* sequence_reader */
+void cbor_minit_sequence_reader();
+
+/* lazy_value */
+void cbor_minit_lazy_value();
+
+/* index */
+void cbor_minit_index();
+
+/* reader */
+void cbor_minit_reader();
+
+/* writer */
+void cbor_minit_writer();
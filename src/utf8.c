@@ -4,6 +4,20 @@
  */
 
 #include "cbor.h"
+#include "cpu_id.h"
+#include "utf8.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define UTF8_SIMD  /* SSE2 is always available */
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2  __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+#endif
+
+#define SIMD_MIN_LEN  16  /* shorter strings are validated without dispatch */
 
 /*
 Copyright (c) 2008-2010 Bjoern Hoehrmann <bjoern@hoehrmann.de>
@@ -40,7 +54,9 @@ static const uint8_t utf8d[] = {
 	12,36,12,12,12,12,12,12,12,12,12,12,
 };
 
-bool cbor_is_utf8(const uint8_t *str, size_t len)
+typedef bool (utf8_validator)(const uint8_t *str, size_t len);
+
+static bool is_utf8_dfa(const uint8_t *str, size_t len)
 {
 	uint32_t state = 0;
 	const uint8_t *end = str + len;
@@ -59,6 +75,200 @@ bool cbor_is_utf8(const uint8_t *str, size_t len)
 	return state == UTF8_ACCEPT;
 }
 
+#ifdef UTF8_SIMD
+
+/* Skip 16 bytes of ASCII at once while on a character boundary, and run the DFA otherwise. */
+static bool is_utf8_sse2(const uint8_t *str, size_t len)
+{
+	uint32_t state = UTF8_ACCEPT;
+	const uint8_t *end = str + len;
+	while (str < end) {
+		if (state == UTF8_ACCEPT) {
+			while (end - str >= 16 && !_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)str))) {
+				str += 16;
+			}
+		}
+		const uint8_t *block_end = (end - str > 16) ? str + 16 : end;
+		while (str < block_end) {
+			state = utf8d[256 + state + utf8d[*str++]];
+		}
+		if (state == UTF8_REJECT) {
+			return false;
+		}
+	}
+	return state == UTF8_ACCEPT;
+}
+
+/*
+ * Validate 32 bytes per step with nibble lookup tables, after
+ * "Validating UTF-8 In Less Than One Instruction Per Byte" by John Keiser, Daniel Lemire.
+ * Each bit of the looked up values stands for an error class of a pair of bytes.
+ */
+#define U8E_TOO_SHORT  (1 << 0)  /* 11______ 0_______, 11______ 11______ */
+#define U8E_TOO_LONG  (1 << 1)  /* 0_______ 10______ */
+#define U8E_OVERLONG_3  (1 << 2)  /* 11100000 100_____ */
+#define U8E_TOO_LARGE  (1 << 3)  /* 11110100 1001____, 11110100 101_____, 11110101+ 10______ */
+#define U8E_SURROGATE  (1 << 4)  /* 11101101 101_____ */
+#define U8E_OVERLONG_2  (1 << 5)  /* 1100000_ 10______ */
+#define U8E_TOO_LARGE_1000  (1 << 6)  /* 11110101+ 1000____ */
+#define U8E_OVERLONG_4  (1 << 6)  /* 11110000 1000____ */
+#define U8E_TWO_CONTS  (1 << 7)  /* 10______ 10______ */
+#define U8E_CARRY  (U8E_TOO_SHORT | U8E_TOO_LONG | U8E_TWO_CONTS)
+
+#define AVX2_TABLE(...)  _mm256_setr_epi8(__VA_ARGS__, __VA_ARGS__)
+
+TARGET_AVX2
+static __m256i avx2_prev(__m256i input, __m256i prev_input, int n)
+{
+	/* input shifted by n bytes, filled with the tail of prev_input */
+	__m256i prev_tail = _mm256_permute2x128_si256(prev_input, input, 0x21);
+	switch (n) {
+	case 1:
+		return _mm256_alignr_epi8(input, prev_tail, 16 - 1);
+	case 2:
+		return _mm256_alignr_epi8(input, prev_tail, 16 - 2);
+	default:
+		return _mm256_alignr_epi8(input, prev_tail, 16 - 3);
+	}
+}
+
+TARGET_AVX2
+static __m256i avx2_check_block(__m256i input, __m256i prev_input)
+{
+	const __m256i nibble_mask = _mm256_set1_epi8(0x0f);
+	__m256i prev1 = avx2_prev(input, prev_input, 1);
+	__m256i byte_1_high = _mm256_shuffle_epi8(AVX2_TABLE(
+		/* 0_______ ________ */
+		U8E_TOO_LONG, U8E_TOO_LONG, U8E_TOO_LONG, U8E_TOO_LONG,
+		U8E_TOO_LONG, U8E_TOO_LONG, U8E_TOO_LONG, U8E_TOO_LONG,
+		/* 10______ ________ */
+		U8E_TWO_CONTS, U8E_TWO_CONTS, U8E_TWO_CONTS, U8E_TWO_CONTS,
+		/* 1100____ ________ */
+		U8E_TOO_SHORT | U8E_OVERLONG_2,
+		/* 1101____ ________ */
+		U8E_TOO_SHORT,
+		/* 1110____ ________ */
+		U8E_TOO_SHORT | U8E_OVERLONG_3 | U8E_SURROGATE,
+		/* 1111____ ________ */
+		U8E_TOO_SHORT | U8E_TOO_LARGE | U8E_TOO_LARGE_1000 | U8E_OVERLONG_4
+	), _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble_mask));
+	__m256i byte_1_low = _mm256_shuffle_epi8(AVX2_TABLE(
+		/* ____0000 ________ */
+		U8E_CARRY | U8E_OVERLONG_3 | U8E_OVERLONG_2 | U8E_OVERLONG_4,
+		/* ____0001 ________ */
+		U8E_CARRY | U8E_OVERLONG_2,
+		/* ____001_ ________ */
+		U8E_CARRY,
+		U8E_CARRY,
+		/* ____0100 ________ */
+		U8E_CARRY | U8E_TOO_LARGE,
+		/* ____0101 ________, ____011_ ________ */
+		U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+		U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+		U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+		/* ____1___ ________ */
+		U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+		U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+		U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+		U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+		U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+		/* ____1101 ________ */
+		U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000 | U8E_SURROGATE,
+		U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000,
+		U8E_CARRY | U8E_TOO_LARGE | U8E_TOO_LARGE_1000
+	), _mm256_and_si256(prev1, nibble_mask));
+	__m256i byte_2_high = _mm256_shuffle_epi8(AVX2_TABLE(
+		/* ________ 0_______ */
+		U8E_TOO_SHORT, U8E_TOO_SHORT, U8E_TOO_SHORT, U8E_TOO_SHORT,
+		U8E_TOO_SHORT, U8E_TOO_SHORT, U8E_TOO_SHORT, U8E_TOO_SHORT,
+		/* ________ 1000____ */
+		U8E_TOO_LONG | U8E_OVERLONG_2 | U8E_TWO_CONTS | U8E_OVERLONG_3 | U8E_TOO_LARGE_1000 | U8E_OVERLONG_4,
+		/* ________ 1001____ */
+		U8E_TOO_LONG | U8E_OVERLONG_2 | U8E_TWO_CONTS | U8E_OVERLONG_3 | U8E_TOO_LARGE,
+		/* ________ 101_____ */
+		U8E_TOO_LONG | U8E_OVERLONG_2 | U8E_TWO_CONTS | U8E_SURROGATE | U8E_TOO_LARGE,
+		U8E_TOO_LONG | U8E_OVERLONG_2 | U8E_TWO_CONTS | U8E_SURROGATE | U8E_TOO_LARGE,
+		/* ________ 11______ */
+		U8E_TOO_SHORT, U8E_TOO_SHORT, U8E_TOO_SHORT, U8E_TOO_SHORT
+	), _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble_mask));
+	__m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+	/* the 3rd and 4th bytes of a sequence must be continuations, where TWO_CONTS is expected */
+	__m256i is_third = _mm256_subs_epu8(avx2_prev(input, prev_input, 2), _mm256_set1_epi8((char)(0xe0 - 0x80)));
+	__m256i is_fourth = _mm256_subs_epu8(avx2_prev(input, prev_input, 3), _mm256_set1_epi8((char)(0xf0 - 0x80)));
+	__m256i must_23_80 = _mm256_and_si256(_mm256_or_si256(is_third, is_fourth), _mm256_set1_epi8((char)0x80));
+	return _mm256_xor_si256(must_23_80, special);
+}
+
+TARGET_AVX2
+static bool is_utf8_avx2(const uint8_t *str, size_t len)
+{
+	const uint8_t *ptr = str, *end = str + len;
+	/* the last bytes that cannot end a block unless a sequence continues */
+	const __m256i incomplete_max = _mm256_setr_epi8(
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		(char)(0xf0 - 1), (char)(0xe0 - 1), (char)(0xc0 - 1));
+	__m256i error = _mm256_setzero_si256();
+	__m256i prev_input = _mm256_setzero_si256();
+	__m256i prev_incomplete = _mm256_setzero_si256();
+	while (end - ptr >= 32) {
+		__m256i input = _mm256_loadu_si256((const __m256i *)ptr);
+		if (!_mm256_movemask_epi8(input)) {
+			error = _mm256_or_si256(error, prev_incomplete);
+			prev_incomplete = _mm256_setzero_si256();
+		} else {
+			error = _mm256_or_si256(error, avx2_check_block(input, prev_input));
+			prev_incomplete = _mm256_subs_epu8(input, incomplete_max);
+		}
+		prev_input = input;
+		ptr += 32;
+	}
+	if (!_mm256_testz_si256(error, error)) {
+		return false;
+	}
+	/* back to the start of the last sequence that might be incomplete for the DFA to validate the rest */
+	for (int i = 1; i <= 3 && ptr - i >= str; i++) {
+		uint8_t c = ptr[-i];
+		if (c >= 0xc0) {
+			ptr -= i;
+			break;
+		}
+		if (c < 0x80) {
+			break;
+		}
+	}
+	return is_utf8_dfa(ptr, end - ptr);
+}
+
+static bool has_avx2()
+{
+	int cpu_id[4];
+	if (!get_cpu_id(1, cpu_id) || !(cpu_id[2] & CPU_ID_1_2_OSXSAVE)
+			|| (get_xcr0() & XCR0_YMM_STATE) != XCR0_YMM_STATE) {
+		return false;
+	}
+	return get_cpu_id(7, cpu_id) && (cpu_id[1] & CPU_ID_7_1_AVX2);
+}
+
+#endif
+
+static utf8_validator *utf8_validate = &is_utf8_dfa;
+
+void cbor_minit_utf8()
+{
+#ifdef UTF8_SIMD
+	utf8_validate = has_avx2() ? &is_utf8_avx2 : &is_utf8_sse2;
+#endif
+}
+
+bool cbor_is_utf8(const uint8_t *str, size_t len)
+{
+	if (len < SIMD_MIN_LEN) {
+		return is_utf8_dfa(str, len);
+	}
+	return (*utf8_validate)(str, len);
+}
+
 uint32_t cbor_next_utf8(const uint8_t **str, const uint8_t *end)
 {
 	uint32_t state = 0;
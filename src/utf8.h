@@ -5,5 +5,6 @@
 
 #define is_utf8(str, len) cbor_is_utf8(str, len)
 
+void cbor_minit_utf8();
 bool cbor_is_utf8(const uint8_t *str, size_t len);
 uint32_t cbor_next_utf8(const uint8_t **str, const uint8_t *end);
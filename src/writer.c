@@ -0,0 +1,501 @@
+/**
+ * @author SATO Kentaro
+ * @license BSD-2-Clause
+ */
+
+#include "cbor.h"
+#include "codec.h"
+#include "compatibility.h"
+#include "di_encoder.h"
+#include "tags.h"
+#include "types.h"
+#include "utf8.h"
+#include <Zend/zend_exceptions.h>
+#include <Zend/zend_smart_str.h>
+
+#define WRITER_STACK_INIT_SIZE  8
+#define WRITER_CHUNK_SIZE  (64 * 1024)
+#define BUFFER_KEEP_SIZE  (512 * 1024)
+
+typedef struct {
+	uint64_t remaining;  /* items left in the definite-length container */
+	bool is_indef;
+	bool is_map;
+	bool has_key;  /* key of indefinite-length map is written without the value */
+} writer_frame;
+
+typedef struct {
+	cbor_encode_args args;
+	cbor_encode_context *ctx;  /* to encode values */
+	smart_str buf;
+	zval z_stream;  /* flush destination of buf if defined */
+	writer_frame *stack;  /* open containers */
+	uint32_t depth, stack_size;
+	bool in_tag;  /* content of the tag follows */
+	bool is_processing;
+	zend_object std;
+} writer_class;
+
+static zend_object_handlers writer_handlers;
+
+static zend_object *writer_create(zend_class_entry *ce)
+{
+	writer_class *base = zend_object_alloc(sizeof(writer_class), ce);
+	memset(&base->args, 0, sizeof base->args);
+	base->ctx = NULL;
+	memset(&base->buf, 0, sizeof base->buf);
+	ZVAL_UNDEF(&base->z_stream);
+	base->stack = NULL;
+	base->depth = base->stack_size = 0;
+	base->in_tag = false;
+	base->is_processing = false;
+	zend_object_std_init(&base->std, ce);
+	base->std.handlers = &writer_handlers;
+	return &base->std;
+}
+
+static void writer_release(writer_class *base)
+{
+	if (base->ctx) {
+		cbor_encode_delete(base->ctx);
+		base->ctx = NULL;
+	}
+	smart_str_free(&base->buf);
+	zval_ptr_dtor(&base->z_stream);
+	ZVAL_UNDEF(&base->z_stream);
+	if (base->stack) {
+		efree(base->stack);
+		base->stack = NULL;
+	}
+	base->depth = base->stack_size = 0;
+	base->in_tag = false;
+}
+
+static void writer_free(zend_object *obj)
+{
+	writer_class *base = CUSTOM_OBJ(writer_class, obj);
+	writer_release(base);
+	zend_object_std_dtor(obj);
+}
+
+#define NO_REENTRANT(base)  do { \
+		if (base->is_processing) { \
+			zend_throw_error(NULL, "The operation is not permitted while encoding is in progress."); \
+			RETURN_THROWS(); \
+		} \
+	} while (0)
+
+#define REQUIRE_CTX(base)  do { \
+		if (!base->ctx) { \
+			zend_throw_error(NULL, "The writer is not initialized."); \
+			RETURN_THROWS(); \
+		} \
+	} while (0)
+
+static php_stream *get_stream(writer_class *base)
+{
+	if (Z_TYPE(base->z_stream) == IS_UNDEF) {
+		return NULL;
+	}
+	/* the stream may have been closed */
+	return zend_fetch_resource2_ex(&base->z_stream, NULL, php_file_le_stream(), php_file_le_pstream());
+}
+
+/* Write out the buffer to the stream if it reaches min_len. */
+static bool flush_buffer(writer_class *base, size_t min_len)
+{
+	smart_str *buf = &base->buf;
+	php_stream *stream;
+	size_t len;
+	if (Z_TYPE(base->z_stream) == IS_UNDEF || !buf->s) {
+		return true;
+	}
+	len = ZSTR_LEN(buf->s);
+	if (len < min_len || !len) {
+		return true;
+	}
+	if ((stream = get_stream(base)) == NULL || php_stream_write(stream, ZSTR_VAL(buf->s), len) != (ssize_t)len) {
+		cbor_throw_error(CBOR_ERROR_IO, false, NULL);
+		return false;
+	}
+	ZSTR_LEN(buf->s) = 0;
+	return true;
+}
+
+/* Check if an item can be written; the self-describe tag is written before a top-level item. */
+static bool begin_item(writer_class *base)
+{
+	if (base->in_tag) {
+		return true;  /* checked on the tag */
+	}
+	if (base->depth) {
+		writer_frame *top = &base->stack[base->depth - 1];
+		if (!top->is_indef && !top->remaining) {
+			zend_throw_error(NULL, "The number of items exceeds the length of the container.");
+			return false;
+		}
+	} else if (base->args.e_flags & CBOR_SELF_DESCRIBE) {
+		cbor_di_write_int(&base->buf, DI_TAG, CBOR_TAG_SELF_DESCRIBE);
+	}
+	return true;
+}
+
+/* Count the item written in the innermost container; a completed top-level item is flushed. */
+static bool end_item(writer_class *base)
+{
+	base->in_tag = false;
+	if (!base->depth) {
+		return flush_buffer(base, 0);
+	}
+	writer_frame *top = &base->stack[base->depth - 1];
+	if (top->is_indef) {
+		top->has_key = !top->has_key;
+	} else {
+		top->remaining--;
+	}
+	return flush_buffer(base, WRITER_CHUNK_SIZE);
+}
+
+static void write_float(writer_class *base, double value)
+{
+	int float_type = base->args.e_flags & (CBOR_FLOAT16 | CBOR_FLOAT32);
+	if (float_type == (CBOR_FLOAT16 | CBOR_FLOAT32)) {
+		int size = test_fp64_size(value);
+		if (size == 2) {
+			float_type = CBOR_FLOAT16;
+		} else if (size == 4) {
+			float_type = CBOR_FLOAT32;
+		}
+	}
+	if (float_type == CBOR_FLOAT16) {
+		cbor_di_write_float16(&base->buf, cbor_float_64_to_16(value));
+	} else if (float_type == CBOR_FLOAT32) {
+		cbor_di_write_float32(&base->buf, cbor_to_fp32(value));
+	} else {
+		cbor_di_write_float64(&base->buf, value);
+	}
+}
+
+static bool write_string(writer_class *base, zend_string *value, bool to_text)
+{
+	size_t length = ZSTR_LEN(value);
+	if (to_text && !(base->args.e_flags & CBOR_UNSAFE_TEXT)
+			&& !ZSTR_IS_VALID_UTF8(value)) {
+		if (!is_utf8((uint8_t *)ZSTR_VAL(value), length)) {
+			cbor_throw_error(CBOR_ERROR_UTF8, false, NULL);
+			return false;
+		}
+		ZSTR_SET_VALID_UTF8(value);
+	}
+	if (!begin_item(base)) {
+		return false;
+	}
+	cbor_di_write_int(&base->buf, to_text ? DI_TSTR : DI_BSTR, length);
+	if (length >= WRITER_CHUNK_SIZE && Z_TYPE(base->z_stream) != IS_UNDEF) {
+		/* write large string directly */
+		php_stream *stream;
+		if (!flush_buffer(base, 0)) {
+			return false;
+		}
+		if ((stream = get_stream(base)) == NULL || php_stream_write(stream, ZSTR_VAL(value), length) != (ssize_t)length) {
+			cbor_throw_error(CBOR_ERROR_IO, false, NULL);
+			return false;
+		}
+	} else if (length) {
+		smart_str_appendl(&base->buf, ZSTR_VAL(value), length);
+	}
+	return end_item(base);
+}
+
+static bool start_container(writer_class *base, uint8_t di_type, zend_long count, bool is_indef)
+{
+	writer_frame *top;
+	if (!is_indef && count < 0) {
+		zend_argument_value_error(1, "must be greater than or equal to 0");
+		return false;
+	}
+	if (base->depth >= base->args.max_depth) {
+		cbor_throw_error(CBOR_ERROR_DEPTH, false, NULL);
+		return false;
+	}
+	if (!begin_item(base)) {
+		return false;
+	}
+	if (is_indef) {
+		cbor_di_write_indef(&base->buf, di_type);
+	} else {
+		cbor_di_write_int(&base->buf, di_type, (uint64_t)count);
+	}
+	base->in_tag = false;
+	if (base->depth >= base->stack_size) {
+		base->stack_size = base->stack_size ? base->stack_size * 2 : WRITER_STACK_INIT_SIZE;
+		base->stack = safe_erealloc(base->stack, base->stack_size, sizeof *base->stack, 0);
+	}
+	top = &base->stack[base->depth++];
+	top->remaining = (di_type == DI_MAP) ? (uint64_t)count * 2 : (uint64_t)count;
+	top->is_indef = is_indef;
+	top->is_map = di_type == DI_MAP;
+	top->has_key = false;
+	return true;
+}
+
+PHP_METHOD(Cbor_Writer, __construct)
+{
+	writer_class *base = CUSTOM_OBJ(writer_class, Z_OBJ_P(ZEND_THIS));
+	zend_long flags = CBOR_BYTE | CBOR_KEY_BYTE;
+	HashTable *options = NULL;
+	zval *z_stream = NULL;
+	cbor_encode_args args;
+	cbor_error error;
+	NO_REENTRANT(base);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "|lh!r!", &flags, &options, &z_stream) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	memset(&args, 0, sizeof args);
+	args.u_flags = (uint32_t)flags;
+	if ((error = cbor_set_encode_options(&args, options)) != 0
+			|| (error = cbor_check_encode_params(&args)) != 0) {
+		cbor_throw_error(error, false, &args.error_args);
+		RETURN_THROWS();
+	}
+	writer_release(base);
+	base->args = args;
+	args.e_flags &= ~CBOR_SELF_DESCRIBE;  /* written by the writer before a top-level item */
+	base->ctx = cbor_encode_new(&args);
+	if (z_stream) {
+		ZVAL_COPY(&base->z_stream, z_stream);
+	}
+}
+
+PHP_METHOD(Cbor_Writer, startArray)
+{
+	writer_class *base = CUSTOM_OBJ(writer_class, Z_OBJ_P(ZEND_THIS));
+	zend_long count = 0;
+	bool is_null = true;
+	NO_REENTRANT(base);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "|l!", &count, &is_null) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	REQUIRE_CTX(base);
+	if (!start_container(base, DI_ARRAY, count, is_null)) {
+		RETURN_THROWS();
+	}
+}
+
+PHP_METHOD(Cbor_Writer, startMap)
+{
+	writer_class *base = CUSTOM_OBJ(writer_class, Z_OBJ_P(ZEND_THIS));
+	zend_long count = 0;
+	bool is_null = true;
+	NO_REENTRANT(base);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "|l!", &count, &is_null) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	REQUIRE_CTX(base);
+	if (!start_container(base, DI_MAP, count, is_null)) {
+		RETURN_THROWS();
+	}
+}
+
+PHP_METHOD(Cbor_Writer, end)
+{
+	writer_class *base = CUSTOM_OBJ(writer_class, Z_OBJ_P(ZEND_THIS));
+	writer_frame *top;
+	NO_REENTRANT(base);
+	zend_parse_parameters_none();
+	if (!base->depth) {
+		zend_throw_error(NULL, "There is no container to end.");
+		RETURN_THROWS();
+	}
+	top = &base->stack[base->depth - 1];
+	if (base->in_tag) {
+		zend_throw_error(NULL, "The content of the tag is not written.");
+		RETURN_THROWS();
+	}
+	if (top->is_indef ? top->is_map && top->has_key : top->remaining != 0) {
+		zend_throw_error(NULL, "The number of items is less than the length of the container.");
+		RETURN_THROWS();
+	}
+	if (top->is_indef) {
+		cbor_di_write_break(&base->buf);
+	}
+	base->depth--;
+	if (!end_item(base)) {
+		RETURN_THROWS();
+	}
+}
+
+PHP_METHOD(Cbor_Writer, int)
+{
+	writer_class *base = CUSTOM_OBJ(writer_class, Z_OBJ_P(ZEND_THIS));
+	zend_long value;
+	NO_REENTRANT(base);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "l", &value) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	REQUIRE_CTX(base);
+	if (!begin_item(base)) {
+		RETURN_THROWS();
+	}
+	if (value >= 0) {
+		cbor_di_write_int(&base->buf, DI_UINT, (uint64_t)value);
+	} else {
+		cbor_di_write_int(&base->buf, DI_NINT, (uint64_t)-(value + 1));
+	}
+	if (!end_item(base)) {
+		RETURN_THROWS();
+	}
+}
+
+PHP_METHOD(Cbor_Writer, float)
+{
+	writer_class *base = CUSTOM_OBJ(writer_class, Z_OBJ_P(ZEND_THIS));
+	double value;
+	NO_REENTRANT(base);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "d", &value) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	REQUIRE_CTX(base);
+	if (!begin_item(base)) {
+		RETURN_THROWS();
+	}
+	write_float(base, value);
+	if (!end_item(base)) {
+		RETURN_THROWS();
+	}
+}
+
+PHP_METHOD(Cbor_Writer, text)
+{
+	writer_class *base = CUSTOM_OBJ(writer_class, Z_OBJ_P(ZEND_THIS));
+	zend_string *value;
+	NO_REENTRANT(base);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "S", &value) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	REQUIRE_CTX(base);
+	if (!write_string(base, value, true)) {
+		RETURN_THROWS();
+	}
+}
+
+PHP_METHOD(Cbor_Writer, bytes)
+{
+	writer_class *base = CUSTOM_OBJ(writer_class, Z_OBJ_P(ZEND_THIS));
+	zend_string *value;
+	NO_REENTRANT(base);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "S", &value) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	REQUIRE_CTX(base);
+	if (!write_string(base, value, false)) {
+		RETURN_THROWS();
+	}
+}
+
+PHP_METHOD(Cbor_Writer, tag)
+{
+	writer_class *base = CUSTOM_OBJ(writer_class, Z_OBJ_P(ZEND_THIS));
+	zend_long tag;
+	NO_REENTRANT(base);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "l", &tag) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	REQUIRE_CTX(base);
+	if (tag < 0) {
+		zend_argument_value_error(1, "must be greater than or equal to 0");
+		RETURN_THROWS();
+	}
+	if (!begin_item(base)) {
+		RETURN_THROWS();
+	}
+	cbor_di_write_int(&base->buf, DI_TAG, (uint64_t)tag);
+	base->in_tag = true;
+}
+
+PHP_METHOD(Cbor_Writer, value)
+{
+	writer_class *base = CUSTOM_OBJ(writer_class, Z_OBJ_P(ZEND_THIS));
+	zval *value;
+	php_stream *stream = NULL;
+	size_t start_len, written;
+	cbor_error error;
+	NO_REENTRANT(base);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "z", &value) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	REQUIRE_CTX(base);
+	start_len = base->buf.s ? ZSTR_LEN(base->buf.s) : 0;
+	if (!begin_item(base)) {
+		RETURN_THROWS();
+	}
+	if (Z_TYPE(base->z_stream) != IS_UNDEF) {
+		/* the buffer is emptied so that nothing written before is lost on error */
+		if (!flush_buffer(base, 0)) {
+			RETURN_THROWS();
+		}
+		if ((stream = get_stream(base)) == NULL) {
+			cbor_throw_error(CBOR_ERROR_IO, false, NULL);
+			RETURN_THROWS();
+		}
+	}
+	cbor_encode_args args = base->args;
+	base->is_processing = true;
+	if (stream) {
+		error = cbor_encode_process_stream(base->ctx, value, &base->buf, stream, &written, &args);
+	} else {
+		error = cbor_encode_process(base->ctx, value, &base->buf, &args);
+	}
+	base->is_processing = false;
+	if (error) {
+		if (!stream && base->buf.s) {
+			ZSTR_LEN(base->buf.s) = start_len;  /* including the self-describe tag */
+		}
+		cbor_throw_error(error, false, &args.error_args);
+		RETURN_THROWS();
+	}
+	if (!end_item(base)) {
+		RETURN_THROWS();
+	}
+}
+
+PHP_METHOD(Cbor_Writer, getData)
+{
+	writer_class *base = CUSTOM_OBJ(writer_class, Z_OBJ_P(ZEND_THIS));
+	smart_str *buf = &base->buf;
+	bool clear = true;
+	NO_REENTRANT(base);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "|b", &clear) != SUCCESS) {
+		RETURN_THROWS();
+	}
+	if (base->depth || base->in_tag) {
+		/* the data would end in the middle of the item */
+		zend_throw_error(NULL, "The data item is not complete.");
+		RETURN_THROWS();
+	}
+	if (!buf->s) {
+		RETURN_EMPTY_STRING();
+	}
+	if (clear && buf->a > BUFFER_KEEP_SIZE) {
+		/* give away the large buffer instead of keeping it */
+		RETURN_STR(smart_str_extract(buf));
+	}
+	RETVAL_STRINGL(ZSTR_VAL(buf->s), ZSTR_LEN(buf->s));
+	if (clear) {
+		ZSTR_LEN(buf->s) = 0;
+	}
+}
+
+void cbor_minit_writer()
+{
+	CBOR_CE(writer)->create_object = &writer_create;
+#if TARGET_PHP_API_LT_81
+	CBOR_CE(writer)->serialize = zend_class_serialize_deny;
+	CBOR_CE(writer)->unserialize = zend_class_unserialize_deny;
+#endif
+	memcpy(&writer_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+	writer_handlers.offset = XtOffsetOf(writer_class, std);
+	writer_handlers.free_obj = &writer_free;
+	writer_handlers.clone_obj = NULL;
+	writer_handlers.compare = zend_objects_not_comparable;
+}
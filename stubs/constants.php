@@ -107,6 +107,7 @@ const CBOR_ERROR_DEPTH = 3;
 const CBOR_ERROR_RECURSION = 4;
 const CBOR_ERROR_SYNTAX = 5;
 const CBOR_ERROR_UTF8 = 6;
+const CBOR_ERROR_IO = 7;
 const CBOR_ERROR_UNSUPPORTED_TYPE = 17;
 const CBOR_ERROR_UNSUPPORTED_VALUE = 18;
 const CBOR_ERROR_UNSUPPORTED_SIZE = 19;
@@ -32,8 +32,40 @@ run(function () {
     // CDE, eventually sorted (not repacked)
     $list = [3 => 3, 0 => 0, 1 => 1, 2 => 2];
     eq('0xa40000010102020303', cenc($list, CBOR_CDE | CBOR_INT_KEY));
+    $map = [];
+    foreach (range(999, 0) as $i) {
+        $map["k$i"] = [$i];
+    }
+    $sorted = $map;
+    uksort($sorted, fn ($a, $b) => strlen($a) <=> strlen($b) ?: strcmp($a, $b));
+    eq(cenc($sorted, CBOR_KEY_BYTE), cenc($map, CBOR_KEY_BYTE | CBOR_CDE));
+    eq('k999', array_key_first($map));  // not sorted in place
 
     cdecThrows(CBOR_ERROR_UNSUPPORTED_SIZE, '9b0000000100000000');
+
+    // large definite-length array
+    $list = range(0, 9999);
+    $list[5000] = ['a', [null]];
+    $encoded = cborEncode($list);
+    eq($list, cborDecode($encoded));
+    cdecThrows(CBOR_ERROR_TRUNCATED_DATA, bin2hex(substr($encoded, 0, -1)));
+    $decoder = new Cbor\Decoder();
+    $decoder->add(substr($encoded, 0, 1000));
+    eq(false, $decoder->process());
+    $decoder->add(substr($encoded, 1000));
+    eq(true, $decoder->process());
+    eq($list, $decoder->getValue());
+
+    // nested arrays claiming the same data
+    $size = 256 * 1024;
+    $data = '';
+    for ($i = 0; $i < 60; $i++) {
+        $data .= "\x9a" . pack('N', $size - 5 * ($i + 1) - 60);
+    }
+    $data .= str_repeat("\0", $size - strlen($data));
+    $usage = memory_get_usage();
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => cborDecode($data));
+    ok(memory_get_peak_usage() - $usage < 64 * $size);
 });
 
 ?>
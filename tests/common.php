@@ -273,6 +273,7 @@ function getErrorName(int|Throwable $code): string
                'CBOR_ERROR_RECURSION',
                'CBOR_ERROR_SYNTAX',
                'CBOR_ERROR_UTF8',
+               'CBOR_ERROR_IO',
          17 => 'CBOR_ERROR_UNSUPPORTED_TYPE',
                'CBOR_ERROR_UNSUPPORTED_VALUE',
                'CBOR_ERROR_UNSUPPORTED_SIZE',
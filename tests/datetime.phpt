@@ -25,7 +25,75 @@ run(function () {
     $dt->setTimeZone(new DateTimeZone('+0130'));
     eq('0xc0781b' . bin2hex('2001-02-03T05:35:06.7+01:30'), cenc($dt));
 
+    $dt->setTimeZone(new DateTimeZone('America/New_York'));
+    eq('0xc0781b' . bin2hex('2001-02-02T23:05:06.7-05:00'), cenc($dt));
+    $dt->setDate(2001, 7, 2);
+    eq('0xc0781b' . bin2hex('2001-07-02T23:05:06.7-04:00'), cenc($dt));
+    $dt->setTimeZone(new DateTimeZone('EST'));
+    eq('0xc0781b' . bin2hex('2001-07-02T22:05:06.7-05:00'), cenc($dt));
+    // string_ref
+    $dt = new DateTimeImmutable('2013-03-21T20:04:00Z');
+    eq('0xd9010082c074323031332d30332d32315432303a30343a30305ac0d81900', cenc([$dt, $dt], options: ['string_ref' => true]));
+    // out of range for the text
+    $y10k = (new DateTimeImmutable('@0'))->setDate(10000, 1, 1);
+    cencThrows(CBOR_ERROR_UNSUPPORTED_VALUE, $y10k);
+    cencThrows(CBOR_ERROR_UNSUPPORTED_VALUE, $y10k->setDate(-1, 1, 1));
+
+    // epoch
+    $dt = new DateTimeImmutable('@981173106');
+    eq('0xc11a3a7b8372', cenc($dt, options: ['datetime' => 'epoch']));
+    eq('0xc1fb41cd3dc1b959999a', cenc($dt->modify('+700 msec'), options: ['datetime' => 'epoch']));
+    eq('0xc11a3a7b8372', cenc($dt->setTimeZone(new DateTimeZone('+0130')), options: ['datetime' => 'epoch']));
+    eq('0xc120', cenc(new DateTimeImmutable('@-1'), options: ['datetime' => 'epoch']));
+    eq('0xc1f9b800', cenc(new DateTimeImmutable('1969-12-31T23:59:59.5Z'), CBOR_FLOAT16 | CBOR_FLOAT32, ['datetime' => 'epoch']));
+    eq('0xc11b0000003afff44180', cenc($y10k, options: ['datetime' => 'epoch']));
+    eq('0x82c074323031332d30332d32315432303a30343a30305ac11a514b67b0', cenc([
+        new DateTimeImmutable('2013-03-21T20:04:00Z'),
+        new Cbor\EncodeParams(new DateTimeImmutable('2013-03-21T20:04:00Z'), ['datetime' => 'epoch']),
+    ]));
+    cencThrows(CBOR_ERROR_INVALID_OPTIONS, $dt, options: ['datetime' => 'string']);
+
     cencThrows(CBOR_ERROR_UNSUPPORTED_TYPE, $dt, options: ['datetime' => false]);
+
+    // decode
+    $o = ['datetime' => true];
+    $fmt = fn (DateTimeImmutable $dt) => $dt->format('Y-m-d\TH:i:s.uP');
+    $rfc8949 = 'c074323031332d30332d32315432303a30343a30305a';
+    eq(Cbor\Tag::class, get_class(cdec($rfc8949)));
+    eq('2013-03-21T20:04:00.000000+00:00', $fmt(cdec($rfc8949, options: $o)));
+    eq('2013-03-21T20:04:00.000000+00:00', $fmt(cdec($rfc8949, CBOR_TEXT, $o)));
+    eq('2013-03-21T20:04:00.000000+00:00', $fmt(cdec('c07f6a323031332d30332d32316a5432303a30343a30305aff', options: $o)));
+    eq('2001-02-03T05:35:06.700000+01:30', $fmt(cdec('c0781b323030312d30322d30337430353a33353a30362e372b30313a3330', options: $o)));
+    eq('2001-02-03T04:05:06.123456-05:00', $fmt(cdec('c07823323030312d30322d30335430343a30353a30362e3132333435363738392d30353a3030', options: $o)));
+    eq('2001-02-03T04:05:06.000000+00:00', $fmt(cdec('c11a3a7b8372', options: $o)));
+    eq('2001-02-03T04:05:06.700000+00:00', $fmt(cdec('c1fb41cd3dc1b959999a', options: $o)));
+    eq('1969-12-31T23:59:59.500000+00:00', $fmt(cdec('c1f9b800', options: $o)));
+    eq('1969-12-31T23:59:59.500000+00:00', $fmt(cdec('c1f9b800', CBOR_FLOAT16, $o)));
+    eq('1969-12-31T23:59:59.000000+00:00', $fmt(cdec('c120', options: $o)));
+    $value = cdec('82d81cc100d81d00', options: $o + ['shared_ref' => 'shareable']);
+    ok($value[0] === $value[1]);
+    eq('1970-01-01T00:00:00.000000+00:00', $fmt($value[0]->value));
+    $value = cdec("d90100 82 $rfc8949 c0d81900", options: $o);
+    eq([$fmt(cdec($rfc8949, options: $o))], array_unique(array_map($fmt, $value)));
+    // round trip
+    $dt = new DateTimeImmutable('2001-02-03T04:05:06.7+01:30');
+    eq($fmt($dt), $fmt(cborDecode(cborEncode($dt), options: $o)));
+    eq($dt->getTimestamp(), cborDecode(cborEncode($dt, options: ['datetime' => 'epoch']), options: $o)->getTimestamp());
+    // errors
+    cdecThrows(CBOR_ERROR_TAG_TYPE, 'c04100', options: $o);
+    cdecThrows(CBOR_ERROR_TAG_TYPE, 'c04100', CBOR_BYTE | CBOR_TEXT, $o);
+    cdecThrows(CBOR_ERROR_TAG_TYPE, 'd90100 82 54323031332d30332d32315432303a30343a30305a c0d81900', CBOR_BYTE | CBOR_TEXT, $o);
+    eq(2, count(cdec("d90100 82 $rfc8949 c0d81900", CBOR_BYTE | CBOR_TEXT, $o)));
+    cdecThrows(CBOR_ERROR_TAG_TYPE, 'c001', options: $o);
+    cdecThrows(CBOR_ERROR_TAG_VALUE, 'c063616263', options: $o);
+    cdecThrows(CBOR_ERROR_TAG_VALUE, 'c074323031332d30322d32395432303a30343a30305a', options: $o);
+    cdecThrows(CBOR_ERROR_TAG_TYPE, 'c16161', options: $o);
+    cdecThrows(CBOR_ERROR_TAG_TYPE, 'c1f6', options: $o);
+    cdecThrows(CBOR_ERROR_TAG_VALUE, 'c1f97e00', options: $o);
+    cdecThrows(CBOR_ERROR_TAG_VALUE, 'c1f97c00', options: $o);
+    cdecThrows(CBOR_ERROR_TAG_VALUE, 'c11bffffffffffffffff', options: $o);
+    cdecThrows(CBOR_ERROR_TAG_VALUE, 'c13b7fffffffffffffff', options: $o);
+    cdecThrows(CBOR_ERROR_INVALID_OPTIONS, $rfc8949, options: ['datetime' => 'epoch']);
 });
 
 ?>
@@ -26,6 +26,13 @@ run(function () {
     $value = cdec($data, options: ['max_depth' => 5]);
     cencThrows(CBOR_ERROR_DEPTH, $value, options: ['max_depth' => 4]);
     eq('0x' . $data, cenc($value, options: ['max_depth' => 5]));
+
+    // deep nesting of containers
+    $data = str_repeat('81a16161', 50) . '7f6161ff';
+    cdecThrows(CBOR_ERROR_DEPTH, $data, CBOR_TEXT | CBOR_KEY_TEXT);
+    cdecThrows(CBOR_ERROR_DEPTH, $data, CBOR_TEXT | CBOR_KEY_TEXT, ['max_depth' => 100]);
+    $value = cdec($data, CBOR_TEXT | CBOR_KEY_TEXT, ['max_depth' => 101]);
+    eq('0x' . str_repeat('81a16161', 50) . '6161', cenc($value, CBOR_TEXT | CBOR_KEY_TEXT, ['max_depth' => 100]));
 });
 
 ?>
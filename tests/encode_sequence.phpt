@@ -0,0 +1,55 @@
+--TEST--
+encode sequence
+--SKIPIF--
+<?php if (!extension_loaded('cbor')) echo 'skip  extension is not loaded'; ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/common.php';
+
+run(function () {
+    eq('', cbor_encode_sequence([]));
+    eq('', cbor_encode_sequence(new ArrayIterator([])));
+    eq('0001820203', bin2hex(cbor_encode_sequence([0, 1, [2, 3]])));
+    eq('0001820203', bin2hex(cbor_encode_sequence(['a' => 0, 'b' => 1, 'c' => [2, 3]])));
+    eq('0001820203', bin2hex(cbor_encode_sequence((function () {
+        yield 0;
+        yield 1;
+        yield [2, 3];
+    })())));
+
+    $values = ['abc', ['abc', 'abc'], (object)['abc' => 'abc']];
+    $flags = CBOR_TEXT | CBOR_KEY_TEXT | CBOR_SELF_DESCRIBE;
+    $options = ['string_ref' => true];
+    $expected = implode('', array_map(fn ($v) => cbor_encode($v, $flags, $options), $values));
+    eq(bin2hex($expected), bin2hex(cbor_encode_sequence($values, $flags, $options)));
+    eq(bin2hex($expected), bin2hex(cbor_encode_sequence(new ArrayIterator($values), $flags, $options)));
+    // each item is decodable on its own
+    $decoder = new Cbor\Decoder($flags);
+    $decoder->add(cbor_encode_sequence($values, $flags, $options));
+    $decoded = [];
+    while ($decoder->process()) {
+        $decoded[] = $decoder->getValue();
+    }
+    eq($values, $decoded);
+
+    $obj = (object)[];
+    $values = [[$obj, $obj], [$obj]];
+    $options = ['shared_ref' => true];
+    $expected = implode('', array_map(fn ($v) => cbor_encode($v, options: $options), $values));
+    eq(bin2hex($expected), bin2hex(cbor_encode_sequence($values, options: $options)));
+
+    // errors
+    xThrows(CBOR_ERROR_UTF8, fn () => cbor_encode_sequence(['a', "\xff"], CBOR_TEXT));
+    xThrows(CBOR_ERROR_INVALID_FLAGS, fn () => cbor_encode_sequence([], CBOR_BYTE | CBOR_TEXT));
+    throws(TypeError::class, fn () => cbor_encode_sequence('a'));
+    throws(TypeError::class, fn () => cbor_encode_sequence((object)[]));
+    throws(LogicException::class, fn () => cbor_encode_sequence((function () {
+        yield 0;
+        throw new LogicException();
+    })()));
+});
+
+?>
+--EXPECT--
+Done.
@@ -0,0 +1,55 @@
+--TEST--
+encode to stream
+--SKIPIF--
+<?php if (!extension_loaded('cbor')) echo 'skip  extension is not loaded'; ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/common.php';
+
+function encodeToStream(mixed $value, int $flags = CBOR_BYTE | CBOR_KEY_BYTE, ?array $options = null): string
+{
+    $fp = fopen('php://memory', 'w+b');
+    $written = cbor_encode_to_stream($fp, $value, $flags, $options);
+    rewind($fp);
+    $data = stream_get_contents($fp);
+    fclose($fp);
+    eq(strlen($data), $written);
+    return $data;
+}
+
+run(function () {
+    eq('00', bin2hex(encodeToStream(0)));
+    $value = ['a' => [1.5, null, true], 'b' => (object)['c' => 'd'], 'c' => ['x', 'x', 'x']];
+    eq(bin2hex(cbor_encode($value)), bin2hex(encodeToStream($value)));
+    $flags = CBOR_TEXT | CBOR_KEY_TEXT | CBOR_SELF_DESCRIBE | CBOR_CDE;
+    $options = ['string_ref' => true];
+    eq(bin2hex(cbor_encode($value, $flags, $options)), bin2hex(encodeToStream($value, $flags, $options)));
+
+    // flushed in chunks
+    $s128k = str_repeat('0123456789abcdef', (1024 / 16) * 128);
+    $value = [array_fill(0, 10000, 'abc'), $s128k, [$s128k => $s128k], 'abc'];
+    eq(cbor_encode($value), encodeToStream($value));
+    eq(cbor_encode($value, CBOR_CDE), encodeToStream($value, CBOR_CDE));
+
+    // errors
+    $fp = fopen('php://memory', 'w+b');
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => cbor_encode_to_stream($fp, [fopen('php://memory', 'rb')]));
+    xThrows(CBOR_ERROR_INVALID_FLAGS, fn () => cbor_encode_to_stream($fp, 0, CBOR_BYTE | CBOR_TEXT));
+    $fp = fopen('php://memory', 'rb');
+    xThrows(CBOR_ERROR_IO, fn () => @cbor_encode_to_stream($fp, 0));
+
+    // encoder
+    $encoder = new Cbor\Encoder(CBOR_TEXT);
+    $fp = fopen('php://memory', 'w+b');
+    eq(2, $encoder->encodeToStream($fp, 'a'));
+    eq(strlen($s128k) + 5, $encoder->encodeToStream($fp, $s128k));
+    eq(1, $encoder->encodeToStream($fp, 0));
+    rewind($fp);
+    eq(cbor_encode('a', CBOR_TEXT) . cbor_encode($s128k, CBOR_TEXT) . cbor_encode(0), stream_get_contents($fp));
+    eq('6161', bin2hex($encoder->encode('a')));  // buffer is usable after streaming
+});
+
+?>
+--EXPECT--
+Done.
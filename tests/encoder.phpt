@@ -0,0 +1,83 @@
+--TEST--
+encoder
+--SKIPIF--
+<?php if (!extension_loaded('cbor')) echo 'skip  extension is not loaded'; ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/common.php';
+
+run(function () {
+    $encoder = new Cbor\Encoder();
+    ok(new Cbor\Encoder(options: null));
+    eq('00', bin2hex($encoder->encode(0)));
+    eq('8301820203820405', bin2hex($encoder->encode([1, [2, 3], [4, 5]])));
+    eq('4161', bin2hex($encoder->encode('a')));
+    // same output as cbor_encode()
+    $value = ['a' => [1.5, null, true], 'b' => (object)['c' => 'd']];
+    eq(bin2hex(cbor_encode($value)), bin2hex($encoder->encode($value)));
+    eq(bin2hex(cbor_encode($value)), bin2hex($encoder->encode($value)));
+
+    // flags and options
+    $encoder = new Cbor\Encoder(CBOR_TEXT | CBOR_KEY_TEXT | CBOR_SELF_DESCRIBE, ['string_ref' => true, 'shared_ref' => true]);
+    $value = ['abc', 'abc', 'abc'];
+    $obj = (object)[];
+    $value[] = $obj;
+    $value[] = $obj;
+    $encoded = cbor_encode($value, CBOR_TEXT | CBOR_KEY_TEXT | CBOR_SELF_DESCRIBE, ['string_ref' => true, 'shared_ref' => true]);
+    eq(bin2hex($encoded), bin2hex($encoder->encode($value)));
+    // namespaces and shared refs are not carried over to the next call
+    eq(bin2hex($encoded), bin2hex($encoder->encode($value)));
+
+    // cached keys follow the flags in effect
+    $encoder = new Cbor\Encoder(CBOR_KEY_TEXT | CBOR_INT_KEY);
+    $value = ['a' => 1, '10' => 2, 'x' => (object)['a' => 3]];
+    for ($i = 0; $i < 2; $i++) {
+        eq('a36161010a026178a1616103', bin2hex($encoder->encode($value)));
+        eq('a1416101', bin2hex($encoder->encode(new Cbor\EncodeParams(['a' => 1], ['flags' => CBOR_KEY_BYTE]))));
+        eq('a16161f5', bin2hex($encoder->encode(new Cbor\EncodeParams(['a' => true], ['flags_clear' => CBOR_INT_KEY]))));
+    }
+    $encoder = new Cbor\Encoder(CBOR_KEY_TEXT | CBOR_UNSAFE_TEXT);
+    eq('a161ff01', bin2hex($encoder->encode(["\xff" => 1])));
+    $encoder = new Cbor\Encoder(CBOR_KEY_TEXT);
+    xThrows(CBOR_ERROR_UTF8, fn () => $encoder->encode(["\xff" => 1]));
+    eq('a161ff01', bin2hex($encoder->encode(new Cbor\EncodeParams(["\xff" => 1], ['flags' => CBOR_UNSAFE_TEXT]))));
+    xThrows(CBOR_ERROR_UTF8, fn () => $encoder->encode(["\xff" => 1]));
+    eq('a1616101', bin2hex($encoder->encode(['a' => 1])));
+    xThrows(CBOR_ERROR_INVALID_FLAGS, fn () => $encoder->encode(new Cbor\EncodeParams(['a' => 1], ['flags_clear' => CBOR_KEY_TEXT])));
+
+    // errors
+    xThrows(CBOR_ERROR_INVALID_FLAGS, fn () => new Cbor\Encoder(CBOR_BYTE | CBOR_TEXT));
+    xThrows(CBOR_ERROR_INVALID_OPTIONS, fn () => new Cbor\Encoder(options: ['max_depth' => -1]));
+    $encoder = new Cbor\Encoder(CBOR_TEXT, ['max_depth' => 1]);
+    xThrows(CBOR_ERROR_DEPTH, fn () => $encoder->encode([[1]]));
+    xThrows(CBOR_ERROR_UTF8, fn () => $encoder->encode("\xff"));
+    eq('8101', bin2hex($encoder->encode([1])));  // not affected by the previous errors
+
+    // reentrance
+    $encoder = new Cbor\Encoder();
+    $instance = new class ($encoder) implements Cbor\Serializable {
+        public function __construct(private Cbor\Encoder $encoder)
+        {
+        }
+
+        public function cborSerialize(): mixed
+        {
+            return $this->encoder->encode(1);
+        }
+    };
+    throws(Error::class, fn () => $encoder->encode($instance));
+    eq('01', bin2hex($encoder->encode(1)));
+
+    // large data
+    $s128k = str_repeat('0123456789abcdef', (1024 / 16) * 128);
+    for ($i = 0; $i < 2; $i++) {
+        $encoded = $encoder->encode(array_fill(0, 8, $s128k));
+        eq(cbor_encode(array_fill(0, 8, $s128k)), $encoded);
+    }
+    eq('00', bin2hex($encoder->encode(0)));
+});
+
+?>
+--EXPECT--
+Done.
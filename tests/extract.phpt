@@ -0,0 +1,91 @@
+--TEST--
+cbor_extract()
+--SKIPIF--
+<?php if (!extension_loaded('cbor')) echo 'skip  extension is not loaded'; ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/common.php';
+
+function cext(string $hex, array $path, ...$args): mixed
+{
+    return cbor_extract(decodeHex($hex), $path, ...$args);
+}
+
+run(function () {
+    $f = CBOR_TEXT | CBOR_KEY_TEXT;
+    $value = ['header' => ['type' => 'ping', 'id' => 5], 'body' => [1, 2, [3, 4]], 'none' => null];
+    $data = cbor_encode($value, $f);
+    eq('ping', cbor_extract($data, ['header', 'type'], $f));
+    eq(5, cbor_extract($data, ['header', 'id'], $f));
+    eq((object)$value['header'], cbor_extract($data, ['header'], $f));
+    eq($value['header'], cbor_extract($data, ['header'], $f | CBOR_MAP_AS_ARRAY));
+    eq([3, 4], cbor_extract($data, ['body', 2], $f));
+    eq(4, cbor_extract($data, ['body', '2', 1], $f));
+    eq(cbor_decode($data, $f), cbor_extract($data, [], $f));
+    // not found
+    eq(null, cbor_extract($data, ['body', 3], $f));
+    eq(null, cbor_extract($data, ['body', -1], $f));
+    eq(null, cbor_extract($data, ['body', 'a'], $f));
+    eq(null, cbor_extract($data, ['header', 'type', 0], $f));
+    eq(null, cbor_extract($data, ['nope'], $f));
+    eq(null, cbor_extract($data, ['header']));  // text keys are not allowed by the flags
+    eq(null, cbor_extract($data, ['none'], $f));
+
+    // indefinite-length
+    eq(3, cext('bf 7f 6161 6162 ff 9f 01 02 ff 6163 03 ff', ['c'], $f));
+    eq(2, cext('bf 7f 6161 6162 ff 9f 01 02 ff 6163 03 ff', ['ab', 1], $f));
+    eq(null, cext('bf 7f 6161 6162 ff 9f 01 02 ff 6163 03 ff', ['ab', 2], $f));
+    eq(null, cext('bf 7f 6161 6162 ff 01 ff', ['a'], $f));
+
+    // int keys
+    eq('a', cext('a2 01 6161 20 6162', [1], $f | CBOR_INT_KEY));
+    eq('a', cext('a2 01 6161 20 6162', ['1'], $f | CBOR_INT_KEY));
+    eq('b', cext('a2 01 6161 20 6162', [-1], $f | CBOR_INT_KEY));
+    eq(null, cext('a2 01 6161 20 6162', [1], $f));
+    eq(0, cext('a1 6131 00', [1], $f));
+
+    // siblings are skipped without being decoded
+    eq(1, cext('a2 6161 f0 6162 01', ['b'], $f));
+    eq(1, cext('a2 6161 62c328 6162 01', ['b'], $f));
+    eq(2, cext('a2 6161 a1 f6 00 6162 02', ['b'], $f));
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => cext('a2 6161 f0 6162 01', ['a'], $f));
+
+    // tags
+    eq(1, cext('d9d9f7 a1 6161 01', ['a'], $f));
+    eq(new Cbor\Tag(1, 2), cext('a1 6161 c1 02', ['a'], $f));
+    eq(new Cbor\Tag(55799, 2), cext('a1 6161 d9d9f7 02', ['a'], $f));
+    eq(2, cext('a1 6161 d9d9f7 81 02', ['a', 0], $f));
+    eq(2, cext('a1 6161 d9d9f7 d9d9f7 81 02', ['a', 0], $f));
+    eq(null, cext('a1 6161 d9d9f7 02', ['a', 0], $f));
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => cext('d9d9f7 a1 6161 01', ['a'], $f | CBOR_SELF_DESCRIBE));
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => cext('a1 6161 c1 81 02', ['a', 0], $f));
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => cext('d9d9f7 d9d9f7 a1 6161 01', ['a'], $f));
+    eq([1], cext('d90100 81 01', [], $f));
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => cext('d90100 81 01', [0], $f));
+    try {
+        cext('a1 6161 c1 81 02', ['a', 0], $f);
+    } catch (Cbor\Exception $e) {
+        eqRegEx('/ at offset 3$/', $e->getMessage());
+    }
+
+    // errors
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => cext('a2 6161 01', ['b'], $f));
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => cext('a2 6161 63 6162 01', ['b'], $f));
+    xThrows(CBOR_ERROR_MALFORMED_DATA, fn () => cext('a2 6161 1c 6162 01', ['b'], $f));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => cext('bf 6161 82 01 ff', ['b'], $f));
+    xThrows(CBOR_ERROR_DEPTH, fn () => cbor_extract($data, ['header', 'type'], $f, ['max_depth' => 1]));
+    eq('ping', cbor_extract($data, ['header', 'type'], $f, ['max_depth' => 2]));
+    xThrows(CBOR_ERROR_DEPTH, fn () => cbor_extract($data, ['body'], $f, ['max_depth' => 1]));
+    xThrows(CBOR_ERROR_INVALID_OPTIONS, fn () => cbor_extract($data, [], $f, ['max_depth' => -1]));
+    throws(TypeError::class, fn () => cbor_extract($data, [1.5], $f));
+
+    // large data
+    $data = cbor_encode(['body' => array_fill(0, 10000, str_repeat('x', 100)), 'type' => 'ping'], $f);
+    eq('ping', cbor_extract($data, ['type'], $f));
+    eq(str_repeat('x', 100), cbor_extract($data, ['body', 9999], $f));
+});
+
+?>
+--EXPECT--
+Done.
@@ -0,0 +1,90 @@
+--TEST--
+cbor_from_json()
+--SKIPIF--
+<?php if (!extension_loaded('cbor')) echo 'skip  extension is not loaded'; ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/common.php';
+
+function fromJson(string $json, ...$args): string
+{
+    return bin2hex(cbor_from_json($json, ...$args));
+}
+
+run(function () {
+    $f = CBOR_TEXT | CBOR_KEY_TEXT;
+    $sameAsDecoded = function (string $json, int $flags, ?array $options = null) {
+        eq(bin2hex(cbor_encode(json_decode($json), $flags, $options)), fromJson($json, $flags, $options));
+    };
+    $json = '{"a":[1,-2,"x"],"b":{"c":1.5,"d":[true,false,null]},"e":"a\"\\\\\/\n\u0001あ😀","f":[],"g":{}}';
+    $sameAsDecoded($json, $f);
+    $sameAsDecoded($json, CBOR_BYTE | CBOR_KEY_BYTE);
+    $sameAsDecoded($json, $f | CBOR_FLOAT16 | CBOR_FLOAT32);
+    $sameAsDecoded(" [ 1 , { \"a\" : 2 } ]\r\n\t", $f);
+    $sameAsDecoded('[' . implode(',', range(0, 300)) . ']', $f);
+    $sameAsDecoded('[0,-0,1.0,-1.5e3,1E-2,9223372036854775807,-9223372036854775808,1e400]', $f);
+    eq('1bffffffffffffffff', fromJson('18446744073709551615'));
+    eq('3bffffffffffffffff', fromJson('-18446744073709551616'));
+    eq('fb43f0000000000000', fromJson('18446744073709551616'));
+    eq('d9d9f701', fromJson('1', CBOR_SELF_DESCRIBE));
+
+    // CDE
+    $json = '{"bb":1,"a":2,"c":{"y":[{"q":1,"p":2}],"x":2}}';
+    $sameAsDecoded($json, $f | CBOR_CDE);
+    eq('a2616103616200', fromJson('{"b":0,"a":1,"a":3}', $f | CBOR_CDE));  // the last one wins
+    eq('a2616201616103', fromJson('{"b":1,"a":1,"a":3}', $f));  // the last one wins at the first place
+
+    // duplicate keys
+    $sameAsDecoded('{"a":1,"b":2,"a":3,"c":4,"a":5}', $f);
+    $sameAsDecoded('{"a":{"x":1,"y":2,"x":3},"b":[{"z":1,"z":2}],"a":[1]}', $f);
+    $sameAsDecoded('{"a":1,"\\u0061":2}', $f);
+    eq('a1616103', fromJson('{"a":1,"\\u0061":2,"a":3}', $f));
+    eq('d90100a2616101616202', fromJson('{"a":1,"b":2}', $f, ['string_ref' => true]));
+    xThrows(CBOR_ERROR_DUPLICATE_KEY, fn () => fromJson('{"a":1,"a":2}', $f, ['string_ref' => true]));
+    xThrows(CBOR_ERROR_DUPLICATE_KEY, fn () => fromJson('{"abcd":"x","abcd":"y"}', $f, ['string_ref' => true]));
+    xThrows(CBOR_ERROR_DUPLICATE_KEY, fn () => fromJson('{"abcd":1,"efgh":2,"\\u0061bcd":3}', $f, ['string_ref' => true]));
+    $sameAsDecoded('[{"abcd":1,"efgh":2},{"efgh":3,"abcd":4}]', $f, ['string_ref' => true]);
+
+    // string_ref
+    $json = '["abc","abc",{"abc":"ab"},"ab"]';
+    $sameAsDecoded($json, $f, ['string_ref' => true]);
+    $sameAsDecoded($json, CBOR_BYTE | CBOR_KEY_TEXT, ['string_ref' => true]);
+    eq(fromJson($json, $f), fromJson($json, $f, ['string_ref' => 'explicit']));
+    xThrows(CBOR_ERROR_INVALID_FLAGS, fn () => fromJson($json, $f | CBOR_CDE, ['string_ref' => true]));
+
+    // errors
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => fromJson(''));
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => fromJson('[1,'));
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => fromJson('"abc'));
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => fromJson('tru'));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => fromJson('[1,]'));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => fromJson('{"a" 1}'));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => fromJson('{1:1}'));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => fromJson('1.e1'));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => fromJson('+1'));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => fromJson("\"a\nb\""));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => fromJson('"\x"'));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => fromJson("'a'"));
+    xThrows(CBOR_ERROR_EXTRANEOUS_DATA, fn () => fromJson('01'));
+    xThrows(CBOR_ERROR_EXTRANEOUS_DATA, fn () => fromJson('[] []'));
+    xThrows(CBOR_ERROR_UTF8, fn () => fromJson('"\ud800"', $f));
+    xThrows(CBOR_ERROR_UTF8, fn () => fromJson('"\udc00"', $f));
+    xThrows(CBOR_ERROR_UTF8, fn () => fromJson("\"\xc3\x28\"", $f));
+    eq('62c328', fromJson("\"\xc3\x28\"", $f | CBOR_UNSAFE_TEXT));
+    eq('42c328', fromJson("\"\xc3\x28\""));
+    xThrows(CBOR_ERROR_DEPTH, fn () => fromJson('[[0]]', options: ['max_depth' => 1]));
+    eq('818100', fromJson('[[0]]', options: ['max_depth' => 2]));
+    xThrows(CBOR_ERROR_INVALID_FLAGS, fn () => fromJson('{"a":1}', CBOR_TEXT));
+    xThrows(CBOR_ERROR_INVALID_FLAGS, fn () => fromJson('"a"', CBOR_KEY_TEXT));
+    eq('a0', fromJson('{}', CBOR_TEXT));
+    xThrows(CBOR_ERROR_INVALID_FLAGS, fn () => fromJson('1', CBOR_BYTE | CBOR_TEXT));
+
+    // large data
+    $value = ['users' => array_fill(0, 10000, ['name' => str_repeat('x', 100), 'id' => 1])];
+    eq(bin2hex(cbor_encode($value, $f)), fromJson(json_encode($value), $f));
+});
+
+?>
+--EXPECT--
+Done.
@@ -0,0 +1,104 @@
+--TEST--
+cbor_index()
+--SKIPIF--
+<?php if (!extension_loaded('cbor')) echo 'skip  extension is not loaded'; ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/common.php';
+
+run(function () {
+    $f = CBOR_TEXT | CBOR_KEY_TEXT;
+    $value = ['header' => ['type' => 'ping', 'id' => 5], 'body' => [1, 2, [3, 4]], 'none' => null];
+    $data = cbor_encode($value, $f);
+    $index = cbor_index($data, $f);
+    ok($index instanceof Cbor\Index);
+    eq('ping', $index->get($data, 'header', 'type'));
+    eq(5, $index->get($data, 'header', 'id'));
+    eq((object)$value['header'], $index->get($data, 'header'));
+    eq([3, 4], $index->get($data, 'body', 2));
+    eq(4, $index->get($data, 'body', '2', 1));
+    eq(cbor_decode($data, $f), $index->get($data));
+    eq($value['header'], cbor_index($data, $f | CBOR_MAP_AS_ARRAY)->get($data, 'header'));
+    // not found
+    eq(null, $index->get($data, 'body', 3));
+    eq(null, $index->get($data, 'body', -1));
+    eq(null, $index->get($data, 'body', 'a'));
+    eq(null, $index->get($data, 'header', 'type', 0));
+    eq(null, $index->get($data, 'nope'));
+    eq(null, $index->get($data, 'none'));
+    eq(null, cbor_index($data)->get($data, 'header'));  // text keys are not allowed by the flags
+
+    // locate
+    [$offset, $length] = $index->locate($data, 'body', 2);
+    eq('8203', bin2hex(substr($data, $offset, 2)));
+    eq(3, $length);
+    eq([3, 4], cbor_decode($data, $f, ['offset' => $offset, 'length' => $length]));
+    eq([0, strlen($data)], $index->locate($data));
+    eq(null, $index->locate($data, 'nope'));
+
+    // indefinite-length and tags
+    $data = decodeHex('bf 7f 6161 6162 ff 9f 01 02 ff 6163 c1 81 03 6164 d9d9f7 04 ff');
+    $index = cbor_index($data, $f);
+    eq(2, $index->get($data, 'ab', 1));
+    eq(null, $index->get($data, 'ab', 2));
+    eq(new Cbor\Tag(1, [3]), $index->get($data, 'c'));
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => $index->get($data, 'c', 0));
+    eq(new Cbor\Tag(55799, 4), $index->get($data, 'd'));
+    eq(null, $index->get($data, 'd', 0));
+    $data = decodeHex('d9d9f7 a1 6161 01');
+    eq(1, cbor_index($data, $f)->get($data, 'a'));
+    eq((object)['a' => 1], cbor_index($data, $f)->get($data));
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => cbor_index($data, $f | CBOR_SELF_DESCRIBE)->get($data, 'a'));
+    $data = decodeHex('a1 6161 d9d9f7 d9d9f7 82 01 d9d9f7 bf 6162 02 ff');
+    $index = cbor_index($data, $f);
+    eq(2, $index->get($data, 'a', 1, 'b'));
+    eq([11, 8], $index->locate($data, 'a', 1));
+    $data = decodeHex('d90100 81 01');
+    eq([1], cbor_index($data, $f)->get($data));
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => cbor_index($data, $f)->get($data, 0));
+    $data = decodeHex('a2 01 6161 20 6162');
+    eq('b', cbor_index($data, $f | CBOR_INT_KEY)->get($data, -1));
+    eq(null, cbor_index($data, $f)->get($data, 1));
+
+    // options
+    $data = decodeHex('00 82 01 02 00');
+    $index = cbor_index($data, options: ['offset' => 1, 'length' => 3]);
+    eq(2, $index->get($data, 1));
+    eq([1, 2], $index->get($data));
+    eq([1, 3], $index->locate($data));
+    $data = decodeHex('a1 6161 81 82 01 02');
+    $index = cbor_index($data, $f, ['max_depth' => 3]);
+    eq([[1, 2]], $index->get($data, 'a'));
+    eq(1, $index->get($data, 'a', 0, 0));
+    xThrows(CBOR_ERROR_DEPTH, fn () => $index->get($data, 'a', 0, 0, 0));
+
+    // errors
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => cbor_index(decodeHex('a2 6161 01')));
+    xThrows(CBOR_ERROR_MALFORMED_DATA, fn () => cbor_index(decodeHex('a2 6161 1c 6162 01')));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => cbor_index(decodeHex('bf 6161 ff')));
+    xThrows(CBOR_ERROR_EXTRANEOUS_DATA, fn () => cbor_index(decodeHex('01 02')));
+    xThrows(CBOR_ERROR_DEPTH, fn () => cbor_index(decodeHex('818180'), options: ['max_depth' => 2]));
+    xThrows(CBOR_ERROR_INVALID_OPTIONS, fn () => cbor_index('', options: ['max_depth' => -1]));
+    $data = decodeHex('82 01 f0');
+    $index = cbor_index($data);  // only the structure is checked
+    eq(1, $index->get($data, 0));
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => $index->get($data, 1));
+    throws(ValueError::class, fn () => $index->get('00'));
+    throws(ValueError::class, fn () => $index->get(decodeHex('82 02 f0'), 0));
+    throws(ValueError::class, fn () => $index->locate(decodeHex('82 02 f0'), 0));
+    eq(1, $index->get(decodeHex('82 01 f0'), 0));  // the same content
+    throws(TypeError::class, fn () => $index->get($data, 1.5));
+    throws(Error::class, fn () => new Cbor\Index());
+
+    // large data
+    $value = ['users' => array_fill(0, 10000, ['name' => str_repeat('x', 100)]), 'type' => 'ping'];
+    $data = cbor_encode($value, $f);
+    $index = cbor_index($data, $f);
+    eq('ping', $index->get($data, 'type'));
+    eq((object)['name' => str_repeat('x', 100)], $index->get($data, 'users', 9999));
+});
+
+?>
+--EXPECT--
+Done.
@@ -0,0 +1,87 @@
+--TEST--
+Cbor\LazyValue
+--SKIPIF--
+<?php if (!extension_loaded('cbor')) echo 'skip  extension is not loaded'; ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/common.php';
+
+run(function () {
+    $f = CBOR_TEXT | CBOR_KEY_TEXT;
+    $value = ['header' => ['type' => 'ping'], 'body' => [1, 2, ['a' => 3, 'b' => [4, 5, 6]]], 'map' => ['x' => 1, 'y' => 2, '3' => 4]];
+    $data = cbor_encode($value, $f);
+    $decoded = cborDecode($data, $f, ['lazy' => 3]);
+    eq((object)['type' => 'ping'], $decoded->header);
+    ok($decoded->body instanceof Cbor\LazyValue);
+    ok($decoded->map instanceof Cbor\LazyValue);
+    eq(3, count($decoded->body));
+    eq(1, $decoded->body[0]);
+    eq(3, $decoded->body['2']->a);
+    ok($decoded->body[2]->b instanceof Cbor\LazyValue);
+    eq([4, 5, 6], $decoded->body[2]->b->getValue());
+    eq([4, 5, 6], iterator_to_array($decoded->body[2]->b));
+    ok($decoded->body[2] === $decoded->body[2]);  // cached
+    eq(null, $decoded->body[3]);
+    ok(isset($decoded->body[1]));
+    ok(!isset($decoded->body[3]));
+    eq(1, $decoded->map['x']);
+    eq(4, $decoded->map[3]);
+    eq(['x' => 1, 'y' => 2, '3' => 4], iterator_to_array($decoded->map));
+    eq((object)['x' => 1, 'y' => 2, '3' => 4], $decoded->map->getValue());
+    eq(4, cborDecode($data, $f | CBOR_MAP_AS_ARRAY, ['lazy' => 3])['map'][3]);
+
+    // encoded as the decoded value
+    $decoded = cborDecode($data, $f, ['lazy' => 3]);
+    eq(bin2hex($data), bin2hex(cbor_encode($decoded, $f)));
+    eq(json_encode($value), json_encode(cborDecode($data, $f, ['lazy' => 3])));
+    eq('[[1,2]]', json_encode(cdec('81 82 01 02', options: ['lazy' => 1])));
+    eq('0x8182f6f5', cenc(cdec('81 82 f6 f5', options: ['lazy' => 1])));
+    eq('0x81a16161f6', cenc(cdec('81 a1 6161 f6', $f, ['lazy' => 1]), $f));
+    $decoded = cdec('82 82 01 f0 00', options: ['lazy' => 2]);
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => cbor_encode($decoded));
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => json_encode($decoded));
+
+    // root and small containers are decoded
+    eq(json_decode(json_encode($value)), cborDecode($data, $f, ['lazy' => 4]));
+    eq(json_decode(json_encode($value)), cborDecode($data, $f, ['lazy' => 0]));
+    eq([[1, 2]], cdec('81 9f 01 02 ff', options: ['lazy' => 1]));
+    ok(cdec('81 82 01 02', options: ['lazy' => 1])[0] instanceof Cbor\LazyValue);
+
+    // not lazy where references may cross the boundary
+    eq([['abc'], 'abc'], cdec('d90100 82 81 63616263 d81900', $f, ['lazy' => 1]));
+    $decoded = cdec('82 d81c a1 6161 01 d81d 00', $f, ['lazy' => 1, 'shared_ref' => true]);
+    eq((object)['a' => 1], $decoded[0]);
+    ok($decoded[0] === $decoded[1]);
+    cdecThrows(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, 'a1 81 01 01', options: ['lazy' => 1]);
+
+    // errors of content are thrown on access
+    $decoded = cdec('82 82 01 f0 00', options: ['lazy' => 2]);
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => $decoded[0][0]);
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => $decoded[0]->getValue());
+    cdecThrows(CBOR_ERROR_TRUNCATED_DATA, '81 82 01', options: ['lazy' => 1]);
+    cdecThrows(CBOR_ERROR_MALFORMED_DATA, '81 81 1c', options: ['lazy' => 1]);
+    xThrows(CBOR_ERROR_DEPTH, fn () => cdec('81 81 81 00', options: ['lazy' => 1, 'max_depth' => 2])[0]->getValue());
+    eq([0], cdec('81 81 81 00', options: ['lazy' => 1, 'max_depth' => 3])[0][0]->getValue());
+    cdecThrows(CBOR_ERROR_INVALID_OPTIONS, '00', options: ['lazy' => -1]);
+    cdecThrows(CBOR_ERROR_INVALID_OPTIONS, '00', options: ['lazy' => true]);
+
+    // read-only
+    $decoded = cdec('81 82 01 02', options: ['lazy' => 1]);
+    throws(Error::class, fn () => $decoded[0][0] = 1);
+    throws(Error::class, function () use ($decoded) { unset($decoded[0][0]); });
+    throws(TypeError::class, fn () => $decoded[0][1.5]);
+    throws(Error::class, fn () => new Cbor\LazyValue());
+    throws(Exception::class, fn () => serialize($decoded[0]));
+
+    // large data
+    $value = ['type' => 'ping', 'body' => array_fill(0, 10000, ['x' => str_repeat('x', 100)])];
+    $decoded = cborDecode(cbor_encode($value, $f), $f, ['lazy' => 1000]);
+    eq('ping', $decoded->type);
+    eq(10000, count($decoded->body));
+    eq(str_repeat('x', 100), $decoded->body[9999]->x);
+});
+
+?>
+--EXPECT--
+Done.
@@ -122,6 +122,17 @@ run(function () {
     eq(['@' => 2], cdec('a2414001414002', CBOR_KEY_BYTE | CBOR_MAP_AS_ARRAY));
     eq(['@' => 2], cdec('bf414001414002ff', CBOR_KEY_BYTE | CBOR_MAP_AS_ARRAY));
     cdecThrows(CBOR_ERROR_DUPLICATE_KEY, 'a2414001414002', CBOR_KEY_BYTE | CBOR_MAP_AS_ARRAY | CBOR_MAP_NO_DUP_KEY);
+    eq((object)['@' => 2], cdec('bf414001414002ff'));
+    cdecThrows(CBOR_ERROR_DUPLICATE_KEY, 'bf414001414002ff', CBOR_KEY_BYTE | CBOR_MAP_NO_DUP_KEY);
+
+    // decoded object behaves as ordinary stdClass
+    $obj = cdec('a341610141620201a0', CBOR_KEY_BYTE | CBOR_INT_KEY);
+    eq(1, $obj->a);
+    eq(2, $obj->b);
+    eq((object)[], $obj->{'1'});
+    $obj->c = 3;
+    unset($obj->a);
+    eq(['b' => 2, '1' => (object)[], 'c' => 3], get_object_vars($obj));
 
     cdecThrows(CBOR_ERROR_UNSUPPORTED_SIZE, 'bb0000000100000000');
 });
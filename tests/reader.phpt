@@ -0,0 +1,208 @@
+--TEST--
+Cbor\Reader
+--SKIPIF--
+<?php if (!extension_loaded('cbor')) echo 'skip  extension is not loaded'; ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/common.php';
+
+use Cbor\Reader;
+
+function readTokens(Reader $reader): string
+{
+    $tokens = [];
+    while ($type = $reader->next()) {
+        $tokens[] = match ($type) {
+            Reader::INT => $reader->intValue(),
+            Reader::BYTE => "h'" . bin2hex($reader->stringValue()) . "'",
+            Reader::TEXT => "'" . $reader->stringValue() . "'",
+            Reader::ARRAY => '[' . ($reader->length() ?? '_'),
+            Reader::MAP => '{' . ($reader->length() ?? '_'),
+            Reader::TAG => 'tag' . $reader->intValue(),
+            Reader::FLOAT => $reader->floatValue(),
+            Reader::FALSE => 'false',
+            Reader::TRUE => 'true',
+            Reader::NULL => 'null',
+            Reader::UNDEFINED => 'undefined',
+            Reader::SIMPLE => 'simple' . $reader->intValue(),
+            Reader::END => ')',
+        };
+    }
+    return implode(' ', $tokens);
+}
+
+function rtok(string $hex, ...$args): string
+{
+    return readTokens(new Reader(decodeHex($hex), ...$args));
+}
+
+run(function () {
+    $f = CBOR_TEXT | CBOR_KEY_TEXT;
+    eq("{3 'a' [3 1 -2 'x' ) 'b' {1 'c' 1.5 ) 'd' [3 true false null ) )", rtok('a3 6161 83 01 21 6178 6162 a1 6163 f93e00 6164 83 f5 f4 f6'));
+    eq("[_ 'ab' h'01' {_ 'a' undefined ) [0 ) )", rtok('9f 7f 6161 6162 ff 5f 4101 ff bf 6161 f7 ff 80 ff'));
+    eq('1.5 1.5 -0', rtok('fa 3fc00000 fb 3ff8000000000000 f98000'));
+    eq('tag1 1 simple0 simple32 tag55799 2', rtok('c1 1a00000001 e0 f820 d9d9f7 02'));
+    eq('1 2', rtok('01 02'));
+    eq('', rtok(''));
+    eq(PHP_INT_MAX . ' ' . PHP_INT_MIN, rtok('1b 7fffffffffffffff 3b 7fffffffffffffff'));
+    eq("[2 1 2 )", readTokens(new Reader(decodeHex('00 82 01 02 00'), options: ['offset' => 1, 'length' => 3])));
+
+    // depth, offset and length
+    $reader = new Reader(decodeHex('82 7f 6161 6162 ff 81 00'));
+    eq([Reader::ARRAY, 0, 0, 2], [$reader->next(), $reader->depth(), $reader->offset(), $reader->length()]);
+    eq([Reader::TEXT, 1, 1, 2], [$reader->next(), $reader->depth(), $reader->offset(), $reader->length()]);
+    eq([Reader::ARRAY, 1, 7, 1], [$reader->next(), $reader->depth(), $reader->offset(), $reader->length()]);
+    eq([Reader::INT, 2, 8], [$reader->next(), $reader->depth(), $reader->offset()]);
+    eq([Reader::END, 1, 9], [$reader->next(), $reader->depth(), $reader->offset()]);
+    eq([Reader::END, 0, 9], [$reader->next(), $reader->depth(), $reader->offset()]);
+    eq(Reader::NONE, $reader->next());
+    eq(Reader::NONE, $reader->next());
+
+    // skip and decode
+    $reader = new Reader(decodeHex('83 82 01 02 c1 81 03 04'));
+    $reader->next();
+    eq(Reader::ARRAY, $reader->next());
+    $reader->skip();
+    eq(Reader::TAG, $reader->next());
+    $reader->skip();
+    $reader->skip();
+    eq([Reader::INT, 4, 1], [$reader->next(), $reader->intValue(), $reader->depth()]);
+    eq(Reader::END, $reader->next());
+    $reader = new Reader(decodeHex('84 82 01 02 c1 81 03 6161 04'), $f);
+    $reader->next();
+    $reader->next();
+    eq([1, 2], $reader->decode());
+    throws(Error::class, fn () => $reader->decode());
+    $reader->next();
+    eq(new Cbor\Tag(1, [3]), $reader->decode());
+    eq(Reader::TEXT, $reader->next());
+    eq('a', $reader->decode());
+    eq(Reader::INT, $reader->next());
+    $reader->skip();  // no effect
+    eq(4, $reader->decode());
+    eq(Reader::END, $reader->next());
+    throws(Error::class, fn () => $reader->decode());
+    $value = ['users' => array_fill(0, 10000, ['name' => str_repeat('x', 100)]), 'type' => 'ping'];
+    $reader = new Reader(cbor_encode($value, $f), $f);
+    $reader->next();
+    $count = 0;
+    while ($reader->next() === Reader::TEXT) {
+        if ($reader->stringValue() === 'users') {
+            eq(Reader::ARRAY, $reader->next());
+            eq(10000, $reader->length());
+            while ($reader->next() !== Reader::END) {
+                eq((object)['name' => str_repeat('x', 100)], $reader->decode());
+                $count++;
+            }
+        } else {
+            $reader->next();
+            eq('ping', $reader->stringValue());
+        }
+    }
+    eq(10000, $count);
+
+    // errors
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => rtok('82 01'));
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => rtok('83 01'));
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => rtok('62 61'));
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => rtok('c1'));
+    xThrows(CBOR_ERROR_MALFORMED_DATA, fn () => rtok('1c'));
+    xThrows(CBOR_ERROR_MALFORMED_DATA, fn () => rtok('f8 10'));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => rtok('ff'));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => rtok('81 ff'));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => rtok('9f c1 ff'));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => rtok('bf 6161 ff'));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => rtok('7f 01 ff'));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => rtok('7f 4100 ff'));
+    xThrows(CBOR_ERROR_DEPTH, fn () => rtok('81 81 00', options: ['max_depth' => 1]));
+    eq('[1 [1 0 ) )', rtok('81 81 00', options: ['max_depth' => 2]));
+    xThrows(CBOR_ERROR_INVALID_OPTIONS, fn () => new Reader('', options: ['max_depth' => -1]));
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => new Reader('00', options: ['offset' => 3]));
+    $reader = new Reader(decodeHex('01 ff 02'));
+    $reader->next();
+    xThrows(CBOR_ERROR_SYNTAX, fn () => $reader->next());
+    eq(Reader::NONE, $reader->next());  // stopped
+    $reader = new Reader(decodeHex('82 81 f0 01'));
+    $reader->next();
+    $reader->next();
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => $reader->decode());
+    $reader->skip();
+    eq([Reader::INT, 1], [$reader->next(), $reader->intValue()]);
+    $reader = new Reader(decodeHex('3b 8000000000000000 62 c328 01'));
+    $reader->next();
+    xThrows(CBOR_ERROR_UNSUPPORTED_VALUE, fn () => $reader->intValue());
+    $reader->next();
+    xThrows(CBOR_ERROR_UTF8, fn () => $reader->stringValue());
+    $reader->next();
+    throws(Error::class, fn () => $reader->stringValue());
+    throws(Error::class, fn () => $reader->floatValue());
+    throws(Error::class, fn () => $reader->length());
+    $reader = new Reader(decodeHex('62 c328'), CBOR_UNSAFE_TEXT);
+    $reader->next();
+    eq("\xc3\x28", $reader->stringValue());
+
+    // file
+    $data = decodeHex('82 01 6161');
+    $file = tempnam(sys_get_temp_dir(), 'cbor');
+    file_put_contents($file, $data);
+    eq("[2 1 'a' )", readTokens(Reader::fromFile($file, $f)));
+    file_put_contents($file, '');
+    eq('', readTokens(Reader::fromFile($file)));
+    unlink($file);
+    eq("[2 1 'a' )", readTokens(Reader::fromFile('data:application/cbor;base64,' . base64_encode($data), $f)));
+    xThrows(CBOR_ERROR_IO, fn () => @Reader::fromFile($file));
+    // stream not supporting mmap is read through a buffer
+    $url = fn (string $data) => 'data:application/cbor;base64,' . base64_encode($data);
+    $data = cbor_encode(['a' => str_repeat('x', 20000), 'b' => [1, [2, 3], 4], 'c' => 'end'], $f);
+    $reader = Reader::fromFile($url($data), $f);
+    eq([Reader::MAP, Reader::TEXT, Reader::TEXT], [$reader->next(), $reader->next(), $reader->next()]);
+    eq(str_repeat('x', 20000), $reader->stringValue());
+    eq([Reader::TEXT, Reader::ARRAY], [$reader->next(), $reader->next()]);
+    $offset = $reader->offset();
+    $reader->skip();
+    eq($offset, $reader->offset());
+    eq([Reader::TEXT, 'c', Reader::TEXT, 'end'], [$reader->next(), $reader->stringValue(), $reader->next(), $reader->decode()]);
+    eq([Reader::END, Reader::NONE], [$reader->next(), $reader->next()]);
+    $reader = Reader::fromFile($url($data), $f);
+    $reader->next();
+    $reader->next();
+    eq(str_repeat('x', 20000), $reader->decode());
+    $reader->next();
+    $reader->next();
+    eq([1, [2, 3], 4], $reader->decode());
+    eq("[2 1 2 )", readTokens(Reader::fromFile($url(decodeHex('00 82 01 02 00')), options: ['offset' => 1, 'length' => 3])));
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => readTokens(Reader::fromFile($url(decodeHex('00 82 01 02')), options: ['offset' => 1, 'length' => 4])));
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => readTokens(Reader::fromFile($url(decodeHex('83 01 6461')))));
+    $reader = Reader::fromFile($url(decodeHex('82 01 ff 02')));
+    $reader->next();
+    $reader->next();
+    xThrows(CBOR_ERROR_SYNTAX, fn () => $reader->next());
+    eq(Reader::NONE, $reader->next());  // stopped
+    if (extension_loaded('zlib') && function_exists('memory_reset_peak_usage')) {
+        $value = array_fill(0, 100000, ['name' => str_repeat('x', 100)]);
+        $data = cbor_encode($value, $f);
+        unset($value);
+        file_put_contents($file, gzencode($data));
+        $size = strlen($data);
+        unset($data);
+        memory_reset_peak_usage();
+        $usage = memory_get_usage();
+        $reader = Reader::fromFile("compress.zlib://$file", $f);
+        $reader->next();
+        $count = 0;
+        while ($reader->next() !== Reader::END) {
+            $reader->decode();
+            $count++;
+        }
+        eq(100000, $count);
+        unset($reader);
+        ok(memory_get_peak_usage() - $usage < $size / 16);
+        unlink($file);
+    }
+    throws(Exception::class, fn () => serialize(new Reader('')));
+});
+
+?>
+--EXPECT--
+Done.
@@ -0,0 +1,65 @@
+--TEST--
+sequence reader
+--SKIPIF--
+<?php if (!extension_loaded('cbor')) echo 'skip  extension is not loaded'; ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/common.php';
+
+run(function () {
+    $values = [0, 'abc', [1, [2, 3]], ['a' => null], true];
+    $data = cbor_encode_sequence($values);
+    $offsets = [0, 1, 5, 10, 14];
+    $flags = CBOR_BYTE | CBOR_KEY_BYTE | CBOR_MAP_AS_ARRAY;
+    $reader = new Cbor\SequenceReader($data, $flags);
+    eq(false, $reader->valid());
+    eq($values, iterator_to_array($reader, false));
+    eq(array_combine($offsets, $values), iterator_to_array($reader));
+    // rewind
+    $reader->rewind();
+    eq(true, $reader->valid());
+    eq(0, $reader->key());
+    eq(0, $reader->current());
+    $reader->next();
+    eq('abc', $reader->current());
+    $reader->rewind();
+    eq(0, $reader->current());
+
+    eq([], iterator_to_array(new Cbor\SequenceReader('')));
+    eq([['a' => null], true], iterator_to_array(new Cbor\SequenceReader($data, $flags, ['offset' => 10]), false));
+    eq([1 => 'abc', 5 => [1, [2, 3]]], iterator_to_array(new Cbor\SequenceReader($data, $flags, ['offset' => 1, 'length' => 9])));
+    eq([0, (object)['a' => null]], iterator_to_array(new Cbor\SequenceReader(cbor_encode_sequence([0, ['a' => null]])), false));
+
+    // self-described items
+    $data2 = cbor_encode_sequence($values, CBOR_BYTE | CBOR_KEY_BYTE | CBOR_SELF_DESCRIBE);
+    eq($values, iterator_to_array(new Cbor\SequenceReader($data2, $flags), false));
+
+    // errors
+    xThrows(CBOR_ERROR_INVALID_OPTIONS, fn () => new Cbor\SequenceReader('', options: ['max_depth' => -1]));
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => new Cbor\SequenceReader('00', options: ['offset' => 3]));
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => iterator_to_array(new Cbor\SequenceReader(hex2bin('0082'))));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => iterator_to_array(new Cbor\SequenceReader(hex2bin('00ff'))));
+    $reader = new Cbor\SequenceReader(hex2bin('0001ff02'));
+    $reader->rewind();
+    $reader->next();
+    xThrows(CBOR_ERROR_SYNTAX, fn () => $reader->next());
+    eq(false, $reader->valid());
+
+    // file
+    $file = tempnam(sys_get_temp_dir(), 'cbor');
+    file_put_contents($file, $data);
+    $reader = Cbor\SequenceReader::fromFile($file, $flags);
+    eq(array_combine($offsets, $values), iterator_to_array($reader));
+    eq(array_combine($offsets, $values), iterator_to_array($reader));
+    unset($reader);
+    file_put_contents($file, '');
+    eq([], iterator_to_array(Cbor\SequenceReader::fromFile($file)));
+    unlink($file);
+    eq($values, iterator_to_array(Cbor\SequenceReader::fromFile('data:application/cbor;base64,' . base64_encode($data), $flags), false));
+    xThrows(CBOR_ERROR_IO, fn () => @Cbor\SequenceReader::fromFile($file));
+});
+
+?>
+--EXPECT--
+Done.
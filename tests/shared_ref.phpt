@@ -88,6 +88,15 @@ run(function () {
     // refcount=1 stdClass in EncodeParams
     $ins = new Cbor\EncodeParams([new stdClass()], []);
     eq('0x8281d81ca081d81d00', cenc([$ins, $ins], options: ['shared_ref' => true]));
+    // many shareables
+    $objs = array_map(fn ($i) => (object)[], range(0, 29));
+    $expected = '0x983c' . str_repeat('d81ca0', 30);
+    foreach ($objs as $i => $obj) {
+        $expected .= 'd81d' . ($i < 24 ? sprintf('%02x', $i) : sprintf('18%02x', $i));
+    }
+    $encoder = new Cbor\Encoder(options: ['shared_ref' => true]);
+    eq($expected, '0x' . bin2hex($encoder->encode([...$objs, ...$objs])));
+    eq($expected, '0x' . bin2hex($encoder->encode([...$objs, ...$objs])));
 
     // redundant shareable
     eq('0x81a0', cenc([new stdClass()], options: ['shared_ref' => true]));
@@ -41,6 +41,22 @@ run(function () {
     eq('0x64f09f9880', cenc('😀', CBOR_TEXT));
     // indefinite splits UTF-8 sequence in the middle
     cdecThrows(CBOR_ERROR_UTF8, '7f62f09f629880ff', CBOR_TEXT);
+    // long strings, invalid sequences on and across block boundaries
+    $text = str_repeat("テキスト text \u{10ffff}\u{7ff}", 8);
+    eq($text, cborDecode(cborEncode($text, CBOR_TEXT), CBOR_TEXT));
+    foreach (["\xc1\x80", "\xe0\x9f\xbf", "\xed\xa0\x80", "\xf0\x8f\xbf\xbf", "\xf4\x90\x80\x80", "\xf5\x80\x80\x80", "\x80", "\xc2", "\xe3\x81", "\xf0\x9f\x98"] as $invalid) {
+        for ($i = 0; $i < 70; $i++) {
+            $str = str_repeat('a', $i) . $invalid . $text;
+            cencThrows(CBOR_ERROR_UTF8, $str, CBOR_TEXT);
+            cdecThrows(CBOR_ERROR_UTF8, bin2hex(cborEncode($str, CBOR_TEXT | CBOR_UNSAFE_TEXT)), CBOR_TEXT);
+        }
+        cencThrows(CBOR_ERROR_UTF8, $text . $invalid, CBOR_TEXT);
+    }
+    // re-encoding decoded strings
+    eq('0x' . bin2hex(cborEncode($text, CBOR_TEXT)), cenc(cborDecode(cborEncode($text, CBOR_TEXT), CBOR_TEXT), CBOR_TEXT));
+    eq('0x6a74657874e38386e382ad', cenc(cdec('7f647465787466e38386e382adff', CBOR_TEXT), CBOR_TEXT));
+    $unsafe = cdec('66f09f9880ff00', CBOR_TEXT | CBOR_UNSAFE_TEXT);
+    cencThrows(CBOR_ERROR_UTF8, $unsafe, CBOR_TEXT);
 
     // each length size, not canonical
     eq('123', cdec('5803313233'));
@@ -0,0 +1,40 @@
+--TEST--
+string_cache option
+--SKIPIF--
+<?php if (!extension_loaded('cbor')) echo 'skip  extension is not loaded'; ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/common.php';
+
+run(function () {
+    $records = [];
+    for ($i = 0; $i < 1000; $i++) {
+        $records[] = ['id' => $i, 'name' => "name$i", 'tags' => ['tag' . ($i % 3), 'common'], "key$i" => true, '12' => 12];
+    }
+    $encoded = cborEncode($records, CBOR_TEXT | CBOR_KEY_TEXT);
+    foreach ([null, false, true, 'all'] as $option) {
+        $options = $option === null ? [] : ['string_cache' => $option];
+        eq($records, cborDecode($encoded, CBOR_TEXT | CBOR_KEY_TEXT | CBOR_MAP_AS_ARRAY, $options));
+        eq(json_decode(json_encode($records)), cborDecode($encoded, CBOR_TEXT | CBOR_KEY_TEXT, $options));
+    }
+
+    // cached strings are not shared beyond copy-on-write
+    $decoded = cdec('82a2626b316276316276316161a2626b316276316276316161', CBOR_TEXT | CBOR_KEY_TEXT | CBOR_MAP_AS_ARRAY, ['string_cache' => 'all']);
+    eq([['k1' => 'v1', 'v1' => 'a'], ['k1' => 'v1', 'v1' => 'a']], $decoded);
+    $decoded[0]['k1'] .= 'x';
+    eq('v1x', $decoded[0]['k1']);
+    eq('v1', $decoded[1]['k1']);
+
+    // values wrapped into objects
+    $value = cdec('82426869426869', 0, ['string_cache' => 'all']);
+    eq([new Cbor\Byte('hi'), new Cbor\Byte('hi')], $value);
+    ok($value[0] !== $value[1]);
+
+    cdecThrows(CBOR_ERROR_INVALID_OPTIONS, '00', options: ['string_cache' => 'keys']);
+    cdecThrows(CBOR_ERROR_INVALID_OPTIONS, '00', options: ['string_cache' => 1]);
+});
+
+?>
+--EXPECT--
+Done.
@@ -23,6 +23,13 @@ run(function () {
     $value[2] = new Cbor\Tag(Cbor\Tag::STRING_REF_NS, $value[2]);
     $value[3] = new Cbor\Tag(Cbor\Tag::STRING_REF_NS, $value[3]);
     eq('0x' . $data, cenc($value, CBOR_TEXT, ['string_ref' => true]));
+    // int keys are referenced as strings; text and byte strings are separate
+    eq('0xd901008343313030a163313030f6a1d81901f5', cenc(['100', [100 => null], [100 => true]], CBOR_BYTE | CBOR_KEY_TEXT, ['string_ref' => true]));
+    $value = array_map(fn ($i) => sprintf('%04d', $i), range(0, 299));
+    $value = array_merge($value, $value);
+    $encoded = cborEncode($value, CBOR_TEXT, ['string_ref' => true]);
+    eq($value, cborDecode($encoded, CBOR_TEXT));
+    ok(strlen($encoded) < strlen(cborEncode($value, CBOR_TEXT)));
 
     // to-object
     $str = new Cbor\Byte('000');
@@ -0,0 +1,72 @@
+--TEST--
+cbor_to_json()
+--SKIPIF--
+<?php if (!extension_loaded('cbor')) echo 'skip  extension is not loaded'; ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/common.php';
+
+function toJson(string $hex, ...$args): string
+{
+    return cbor_to_json(decodeHex($hex), ...$args);
+}
+
+run(function () {
+    $f = CBOR_TEXT | CBOR_KEY_TEXT;
+    eq('{"a":[1,-2,"x"],"b":{"c":1.5},"d":[true,false,null]}', toJson('a3 6161 83 01 21 6178 6162 a1 6163 f93e00 6164 83 f5 f4 f6'));
+    eq('["ab","AQI",{"a":null,"1":2},[],{}]', toJson('9f 7f 6161 6162 ff 5f 4101 4102 ff bf 6161 f7 01 02 ff 80 a0 ff'));
+    $value = ['name' => "a\"\\/\n\x01\u{3042}", 'list' => [1, 1.5, -0.5, PHP_INT_MIN, null], 'empty' => [], 'obj' => (object)['x' => true]];
+    eq(json_encode($value, JSON_UNESCAPED_UNICODE | JSON_UNESCAPED_SLASHES), cbor_to_json(cbor_encode($value, $f), $f));
+    eq('18446744073709551615', toJson('1b ffffffffffffffff'));
+    eq('-18446744073709551616', toJson('3b ffffffffffffffff'));
+    eq('[2.0,1.5,1.0e+300,null,null,null]', toJson('86 fb4000000000000000 fa3fc00000 fb7e37e43c8800759c fb7ff0000000000000 f97e00 f9fc00'));
+    eq('[null,null]', toJson('82 f7 f0'));
+
+    // byte strings
+    eq('["_w","__4","__79",""]', toJson('84 41ff 42fffe 43fffefd 40'));
+    eq('["/w==","//4=","//79",""]', toJson('d6 84 41ff 42fffe 43fffefd 40'));
+    eq('["01ab",{"01ab":"_w"}]', toJson('d7 82 42 01ab a1 42 01ab d5 41ff'));
+    eq('"01abcd"', toJson('d7 5f 4101 42abcd ff'));
+    eq('"AavN"', toJson('5f 4101 42abcd ff'));
+
+    // tags and keys
+    eq('[1,2]', toJson('82 c1 01 c2 d9d9f7 02'));
+    eq('3', toJson('d9d9f7 03'));
+    eq('3', toJson('d9d9f7 03', CBOR_SELF_DESCRIBE));
+    eq('{"-1":1,"-9223372036854775808":2,"3":4}', toJson('a3 20 01 c1 3b 7fffffffffffffff 02 03 04'));
+    xThrows(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, fn () => toJson('a1 f5 01'));
+    xThrows(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, fn () => toJson('a1 f6 01'));
+    xThrows(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, fn () => toJson('a1 f93e00 01'));
+    xThrows(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, fn () => toJson('a1 80 01'));
+    xThrows(CBOR_ERROR_UNSUPPORTED_KEY_TYPE, fn () => toJson('a1 c1 a0 01'));
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => toJson('d90100 82 63616263 d81900'));
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => toJson('82 63616263 d81900'));
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => toJson('82 d81c 81 01 d81d 00'));
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => toJson('81 d81d 00'));
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => toJson('a1 d81c 6161 01'));
+
+    // errors
+    xThrows(CBOR_ERROR_UTF8, fn () => toJson('62 c328'));
+    eq("\"\xc3\x28\"", toJson('62 c328', CBOR_UNSAFE_TEXT));
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => toJson('a1 6161'));
+    xThrows(CBOR_ERROR_TRUNCATED_DATA, fn () => toJson(''));
+    xThrows(CBOR_ERROR_MALFORMED_DATA, fn () => toJson('1c'));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => toJson('bf 6161 ff'));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => toJson('9f c1 ff'));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => toJson('7f 4100 ff'));
+    xThrows(CBOR_ERROR_SYNTAX, fn () => toJson('7f 7f ff ff'));
+    xThrows(CBOR_ERROR_EXTRANEOUS_DATA, fn () => toJson('01 02'));
+    xThrows(CBOR_ERROR_DEPTH, fn () => toJson('81 81 00', options: ['max_depth' => 1]));
+    eq('[[0]]', toJson('81 81 00', options: ['max_depth' => 2]));
+    xThrows(CBOR_ERROR_UNSUPPORTED_SIZE, fn () => toJson('83 01 02 03', options: ['max_size' => 2]));
+    eq('[1]', toJson('00 81 01 00', options: ['offset' => 1, 'length' => 2]));
+
+    // large data
+    $value = ['users' => array_fill(0, 10000, ['name' => str_repeat('x', 100), 'id' => 1])];
+    eq(json_encode($value), cbor_to_json(cbor_encode($value, $f), $f));
+});
+
+?>
+--EXPECT--
+Done.
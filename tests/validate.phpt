@@ -0,0 +1,109 @@
+--TEST--
+cbor_validate()
+--SKIPIF--
+<?php if (!extension_loaded('cbor')) echo 'skip  extension is not loaded'; ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/common.php';
+
+function cval(string $hex, ...$args): int|false
+{
+    return cbor_validate(decodeHex($hex), ...$args);
+}
+
+run(function () {
+    eq(1, cval('00'));
+    eq(4, cval('83010203'));
+    eq(4, cval('d9d9f7 01'));
+    eq(2, cval('01 02'));  // following data is not checked
+    eq(4, cbor_validate("\x00\x83\x01\x02\x03\x00", options: ['offset' => 1, 'length' => 4]));
+    eq(false, cval(''));
+    eq(false, cval('9f01'));
+    eq(false, cval('ff'));
+    xThrows(CBOR_ERROR_INVALID_OPTIONS, fn () => cval('00', options: ['max_depth' => -1]));
+
+    // same result as cbor_decode()
+    $i = CBOR_INT_KEY;
+    $nd = CBOR_MAP_NO_DUP_KEY;
+    $t = CBOR_TEXT | CBOR_KEY_TEXT;
+    $a = CBOR_MAP_AS_ARRAY;
+    $sr = ['string_ref' => true];
+    $dt = ['datetime' => true];
+    $cases = [
+        ['62c328', $t], ['62c328', $t | CBOR_UNSAFE_TEXT], ['7f 6161 62c328 ff', $t],
+        ['f0', 0], ['1bffffffffffffffff', 0], ['81 3bffffffffffffffff', 0],
+        ['a1 1bffffffffffffffff 01', 0], ['a1 1bffffffffffffffff 01', $i],
+        ['a1 01 1bffffffffffffffff', $i], ['a1 6161 01', 0], ['a1 6161 01', $t],
+        ['a1 f6 01', 0], ['a1 80 01', 0], ['a1 4100 01', 0], ['a1 4100 01', $a],
+        ['8201ff', 0], ['bf 4161 ff', 0], ['7f 4161 ff', 0], ['7f 01 ff', 0],
+        ['a2 4161 01 4161 02', 0], ['a2 4161 01 4161 02', $nd],
+        ['a2 01 00 4131 00', $i | $nd], ['a2 01 00 4131 00', $i | $nd | $a],
+        ['a2 4131 00 20 00', $i | $nd | $a], ['a2 412d31 00 20 00', $i | $nd | $a],
+        ['bf 5f 4161 ff 01 4161 02 ff', $nd], ['bf 5f 4161 ff 01 4162 02 ff', $nd],
+        ['d90100 83 63616263 63616263 d81900', $t, $sr], ['d90100 83 63616263 63616263 d81901', $t, $sr],
+        ['d81900', $t, $sr], ['d81900', $t], ['d90100 82 626162 d81900', $t, $sr],
+        ['d90100 a2 63616263 01 d81900 02', $t, $sr], ['d90100 a2 63616263 01 d81900 02', $t | $nd, $sr],
+        ['d90100 82 63616263 a1 d81900 01', CBOR_KEY_TEXT, $sr], ['d90100 82 63616263 a1 d81900 01', $t, $sr],
+        ['d90100 82 d90100 81 63616263 d81900', $t, $sr],
+        ['d90100 83 63616263 d90100 81 63646566 d81900', $t, $sr],
+        ['82 d81c a0 d81d 00', 0], ['d81d 00', 0], ['82 d81c a0 d81d 01', 0],
+        ['d81c a0', 0], ['d81c 80', 0], ['d81c 8101', 0], ['d81c a101 01', $i],
+        ['d81c a101 01', $i | $a], ['d81c 01', 0], ['d81c d81c a0', 0], ['d81c d81d 00', 0],
+        ['d81c 4161', 0], ['d81c 4161', CBOR_BYTE], ['d81c 1bffffffffffffffff', 0],
+        ['a1 d81c a0 01', 0], ['a1 d81d 00 01', 0], ['c1 1bffffffffffffffff', 0],
+        ['dbffffffffffffffff 00', 0], ['f93c00', 0], ['a1 f93c00 01', CBOR_FLOAT16],
+        ['c0 74323031332d30332d32315432303a30343a30305a', 0, $dt], ['c0 74323031332d30332d32315432303a30343a30305a', $t, $dt],
+        ['c0 74323031332d30332d32315432303a30343a30305a', CBOR_BYTE, $dt], ['c0 54323031332d30332d32315432303a30343a30305a', 0, $dt],
+        ['c0 54323031332d30332d32315432303a30343a30305a', $t, $dt], ['c0 54323031332d30332d32315432303a30343a30305a', $t | CBOR_BYTE, $dt],
+        ['c0 7f 6a323031332d30332d3231 6a5432303a30343a30305a ff', 0, $dt], ['c0 7f 6a323031332d30332d3231 695432303a30343a3030 ff', 0, $dt],
+        ['c0 74323031332d30322d32395432303a30343a30305a', 0, $dt], ['c0 63616263', 0, $dt], ['c0 01', 0, $dt],
+        ['d90100 82 74323031332d30332d32315432303a30343a30305a c0 d81900', 0, $sr + $dt],
+        ['d90100 82 54323031332d30332d32315432303a30343a30305a c0 d81900', 0, $sr + $dt],
+        ['d90100 82 54323031332d30332d32315432303a30343a30305a c0 d81900', $t | CBOR_BYTE, $sr + $dt],
+        ['d90100 82 74323031332d30332d32315432303a30343a30305a c0 d81900', $t | CBOR_BYTE, $sr + $dt],
+        ['c1 1a514b67b0', 0, $dt], ['c1 3b7fffffffffffffff', 0, $dt], ['c1 1bffffffffffffffff', 0, $dt],
+        ['c1 fb41cd3dc1b959999a', 0, $dt], ['c1 f9b800', 0, $dt], ['c1 f9b800', CBOR_FLOAT16, $dt],
+        ['c1 f97e00', 0, $dt], ['c1 f97e00', CBOR_FLOAT16, $dt], ['c1 fa7f800000', 0, $dt], ['c1 f6', 0, $dt], ['c1 6161', 0, $dt],
+        ['82 d81c c1 00 d81d 00', 0, $dt], ['d81c c0 01', 0, $dt],
+    ];
+    eq(false, cval('c0 54323031332d30332d32315432303a30343a30305a', $t | CBOR_BYTE, $dt));
+    foreach ($cases as $case) {
+        [$hex, $flags] = $case;
+        $options = $case[2] ?? [];
+        $optionSets = [$options];
+        if (str_contains($hex, 'd81')) {
+            $optionSets = [];
+            foreach ([true, 'shareable', 'shareable_only', 'unsafe_ref'] as $sharedRef) {
+                $optionSets[] = $options + ['shared_ref' => $sharedRef];
+            }
+        }
+        foreach ($optionSets as $options) {
+            try {
+                cborDecode(decodeHex($hex), $flags, $options);
+                $exp = strlen(decodeHex($hex));
+            } catch (Cbor\Exception $e) {
+                $exp = false;
+            }
+            eq([$hex, $flags, $options, $exp], [$hex, $flags, $options, cval($hex, $flags, $options)]);
+        }
+    }
+
+    // limits
+    eq(3, cval('818180', options: ['max_depth' => 2]));
+    eq(false, cval('818180', options: ['max_depth' => 1]));
+    eq(false, cval('83010203', options: ['max_size' => 2]));
+    eq(5, cval('9f010203ff', options: ['max_size' => 3]));
+    eq(false, cval('9f010203ff', options: ['max_size' => 2]));
+    eq(false, cval('bf01010202ff', CBOR_INT_KEY, ['max_size' => 1]));
+    eq(false, cval('9a1fffffff00000000', options: ['max_size' => 0x7fffffff]));
+
+    // large data
+    $data = cbor_encode(array_fill(0, 10000, ['key' => str_repeat('x', 100)]));
+    eq(strlen($data), cbor_validate($data));
+    eq(false, cbor_validate(substr($data, 0, -1)));
+});
+
+?>
+--EXPECT--
+Done.
@@ -0,0 +1,133 @@
+--TEST--
+Cbor\Writer
+--SKIPIF--
+<?php if (!extension_loaded('cbor')) echo 'skip  extension is not loaded'; ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/common.php';
+
+use Cbor\Writer;
+
+run(function () {
+    $f = CBOR_TEXT | CBOR_KEY_TEXT;
+    $writer = new Writer($f);
+    $writer->startMap(2);
+    $writer->text('a');
+    $writer->int(1);
+    $writer->text('b');
+    $writer->startArray();
+    $writer->int(-1);
+    $writer->float(1.5);
+    $writer->bytes("\x01");
+    $writer->tag(1);
+    $writer->int(2);
+    $writer->value(null);
+    $writer->end();
+    $writer->end();
+    eq('a261610161629f20fb3ff80000000000004101c102f6ff', bin2hex($writer->getData()));
+    eq('', $writer->getData());
+    $writer->int(PHP_INT_MIN);
+    eq('3b7fffffffffffffff', bin2hex($writer->getData(false)));
+    eq('3b7fffffffffffffff', bin2hex($writer->getData()));
+    $writer->startMap();
+    $writer->int(1);
+    $writer->int(2);
+    $writer->end();
+    $writer->startArray(0);
+    $writer->end();
+    $writer->tag(1);
+    throws(Error::class, fn () => $writer->getData());
+    $writer->tag(2);
+    $writer->text('');
+    eq('bf0102ff80c1c260', bin2hex($writer->getData()));
+
+    // float
+    $writer = new Writer(CBOR_FLOAT32);
+    $writer->float(1.5);
+    eq('fa3fc00000', bin2hex($writer->getData()));
+    $writer = new Writer(CBOR_FLOAT16 | CBOR_FLOAT32);
+    $writer->float(1.5);
+    $writer->float(0.1);
+    eq('f93e00fb3fb999999999999a', bin2hex($writer->getData()));
+
+    // value
+    $value = ['a' => [1, 'x'], 'b' => (object)['c' => 1.5]];
+    $writer = new Writer($f);
+    $writer->startArray(1);
+    $writer->value($value);
+    $writer->end();
+    eq('81' . bin2hex(cbor_encode($value, $f)), bin2hex($writer->getData()));
+    $writer = new Writer($f | CBOR_SELF_DESCRIBE);
+    $writer->startArray(1);
+    $writer->value('a');
+    $writer->end();
+    $writer->value('a');
+    eq('d9d9f7816161d9d9f76161', bin2hex($writer->getData()));
+    $writer = new Writer($f, ['string_ref' => true]);
+    $writer->value(['abc', 'abc']);
+    eq(bin2hex(cbor_encode(['abc', 'abc'], $f, ['string_ref' => true])), bin2hex($writer->getData()));
+
+    // errors
+    $writer = new Writer();
+    $writer->startArray(1);
+    throws(Error::class, fn () => $writer->getData());
+    throws(Error::class, fn () => $writer->getData(false));
+    $writer->int(1);
+    throws(Error::class, fn () => $writer->int(2));
+    $writer->end();
+    throws(Error::class, fn () => $writer->end());
+    $writer->startArray(2);
+    $writer->int(1);
+    throws(Error::class, fn () => $writer->end());
+    $writer->int(2);
+    $writer->end();
+    $writer->startMap();
+    $writer->int(1);
+    throws(Error::class, fn () => $writer->end());
+    $writer->int(2);
+    $writer->tag(1);
+    throws(Error::class, fn () => $writer->end());
+    $writer->int(3);
+    $writer->int(4);
+    $writer->end();
+    eq('8101820102bf0102c10304ff', bin2hex($writer->getData()));
+    throws(ValueError::class, fn () => $writer->startArray(-1));
+    throws(ValueError::class, fn () => $writer->tag(-1));
+    xThrows(CBOR_ERROR_UTF8, fn () => $writer->text("\xc3\x28"));
+    $writer->startArray();
+    xThrows(CBOR_ERROR_UNSUPPORTED_TYPE, fn () => $writer->value([fopen('php://memory', 'rb')]));
+    $writer->end();
+    eq('9fff', bin2hex($writer->getData()));  // nothing is written on error
+    $writer = new Writer(CBOR_UNSAFE_TEXT);
+    $writer->text("\xc3\x28");
+    eq('62c328', bin2hex($writer->getData()));
+    $writer = new Writer(options: ['max_depth' => 1]);
+    $writer->startArray();
+    xThrows(CBOR_ERROR_DEPTH, fn () => $writer->startMap());
+    xThrows(CBOR_ERROR_INVALID_FLAGS, fn () => new Writer(CBOR_BYTE | CBOR_TEXT));
+    xThrows(CBOR_ERROR_INVALID_OPTIONS, fn () => new Writer(options: ['max_depth' => -1]));
+    throws(Exception::class, fn () => serialize(new Writer()));
+
+    // stream
+    $s128k = str_repeat('0123456789abcdef', (1024 / 16) * 128);
+    $values = array_fill(0, 10000, 'abc');
+    $fp = fopen('php://memory', 'w+b');
+    $writer = new Writer(CBOR_TEXT, null, $fp);
+    $writer->startArray();
+    $writer->value($values);
+    $writer->text($s128k);
+    $writer->bytes($s128k);
+    $writer->end();
+    $writer->int(1);
+    eq('', $writer->getData());
+    rewind($fp);
+    $exp = "\x9f" . cbor_encode($values, CBOR_TEXT) . cbor_encode($s128k, CBOR_TEXT) . cbor_encode($s128k) . "\xff\x01";
+    eq($exp, stream_get_contents($fp));
+    $writer = new Writer(stream: fopen('php://memory', 'rb'));
+    xThrows(CBOR_ERROR_IO, fn () => @$writer->int(0));
+});
+
+?>
+--EXPECT--
+Done.